@@ -44,23 +44,28 @@ int main(int argc, char** argv) {
     string inPath = argv[1];
     string outPath = argv[2];
 
+    // Grayscale (and gray + alpha) inputs stay a single plane
     int W, H, C;
-    uint8_t* img = stbi_load(inPath.c_str(), &W, &H, &C, 3);
+    if (!stbi_info(inPath.c_str(), &W, &H, &C)) {
+        cout << "[ERROR] Failed to load " << inPath << endl;
+        return 1;
+    }
+    int NC = (C <= 2) ? 1 : 3;
+    uint8_t* img = stbi_load(inPath.c_str(), &W, &H, &C, NC);
     if (!img) {
         cout << "[ERROR] Failed to load " << inPath << endl;
         return 1;
     }
 
-    cout << "[INFO] Loaded DCT image: " << W << "x" << H << "\n";
+    cout << "[INFO] Loaded DCT image: " << W << "x" << H
+         << " (" << NC << (NC == 1 ? " channel" : " channels") << ")\n";
 
-    vector<uint8_t> R(W*H), G(W*H), B(W*H);
-    vector<uint8_t> outRGB(W*H*3);
+    vector<vector<uint8_t>> planes(NC, vector<uint8_t>(W*H));
+    vector<uint8_t> outPix(W*H*NC);
 
-    for (int i = 0; i < W*H; i++) {
-        R[i] = img[3*i+0];
-        G[i] = img[3*i+1];
-        B[i] = img[3*i+2];
-    }
+    for (int i = 0; i < W*H; i++)
+        for (int c = 0; c < NC; c++)
+            planes[c][i] = img[NC*i + c];
     stbi_image_free(img);
 
     float blk[8][8], rec[8][8];
@@ -96,15 +101,14 @@ int main(int argc, char** argv) {
         }
 
         for (int i = 0; i < W*H; i++) {
-            outRGB[3*i + chID] = Cout[i];
+            outPix[NC*i + chID] = Cout[i];
         }
     };
 
-    process_channel(R, 0);
-    process_channel(G, 1);
-    process_channel(B, 2);
+    for (int c = 0; c < NC; c++)
+        process_channel(planes[c], c);
 
-    stbi_write_png(outPath.c_str(), W, H, 3, outRGB.data(), W*3);
+    stbi_write_png(outPath.c_str(), W, H, NC, outPix.data(), W*NC);
 
     cout << "[INFO] Wrote reconstructed image: " << outPath << endl;
     return 0;
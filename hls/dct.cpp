@@ -104,16 +104,13 @@ LOAD:
             for (int y = 0; y < 8; y++) {
                 for (int x = 0; x < 8; x++) {
 #pragma HLS PIPELINE II=1
-                    int idx = (by + y) * width + (bx + x);
-                    if (bx + x < width && by + y < height) {
-                        R_blk[y][x] = inR[idx];
-                        G_blk[y][x] = inG[idx];
-                        B_blk[y][x] = inB[idx];
-                    } else {
-                        R_blk[y][x] = 0;
-                        G_blk[y][x] = 0;
-                        B_blk[y][x] = 0;
-                    }
+                    // Edge-replicate past the right/bottom border
+                    int sx = (bx + x < width) ? bx + x : width - 1;
+                    int sy = (by + y < height) ? by + y : height - 1;
+                    int idx = sy * width + sx;
+                    R_blk[y][x] = inR[idx];
+                    G_blk[y][x] = inG[idx];
+                    B_blk[y][x] = inB[idx];
                 }
             }
 
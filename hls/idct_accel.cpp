@@ -0,0 +1,264 @@
+/******************************************************************************
+ * IDCT_ACCEL: INVERSE OF dct_accel (DECODE DIRECTION)
+ * Description: v3's load -> transform -> store dataflow run backwards:
+ *              coefficient planes in (the raster layout dct_accel writes),
+ *              then dequantize, inverse DCT, round/clamp to 0..255 and
+ *              store pixel planes.
+ * Contract: matches the host's decode half block for block (dequant_block,
+ *           idct_block_cpu): coefficients past the right/bottom edge are
+ *           taken as 0, dequantization saturates to 16 bits. qtab holds
+ *           the quant steps, 64 per channel (host: pack_dequant_tables);
+ *           with dequant_en = 0 the input is already dequantized.
+ ******************************************************************************/
+
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+typedef ap_uint<8>  pixel_t;
+typedef ap_int<16>  coeff_t;
+// Datapath: any 16-bit input keeps the row pass within +-2^17 and the
+// column pass within +-2^19, so 20 integer bits. The fraction bits decide
+// how often a pixel lands on the other side of a rounding step from the
+// host's double IDCT: about one in 500000 in C simulation, off by 1.
+typedef ap_fixed<40,20> idct_t;
+typedef ap_fixed<26,1> icoef_t;
+
+static const int N = 8;
+
+// The host's C_d literals
+static const icoef_t C[N][N] = {
+    {0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553},
+    {0.490393, 0.415735, 0.277785, 0.097545,-0.097545,-0.277785,-0.415735,-0.490393},
+    {0.461940, 0.191342,-0.191342,-0.461940,-0.461940,-0.191342, 0.191342, 0.461940},
+    {0.415735,-0.097545,-0.490393,-0.277785, 0.277785, 0.490393, 0.097545,-0.415735},
+    {0.353553,-0.353553,-0.353553, 0.353553, 0.353553,-0.353553,-0.353553, 0.353553},
+    {0.277785,-0.490393, 0.097545, 0.415735,-0.415735,-0.097545, 0.490393,-0.277785},
+    {0.191342,-0.461940, 0.461940,-0.191342,-0.191342, 0.461940,-0.461940, 0.191342},
+    {0.097545,-0.277785, 0.415735,-0.490393, 0.490393,-0.415735, 0.277785,-0.097545}
+};
+
+struct block_data {
+    pixel_t R[8][8];
+    pixel_t G[8][8];
+    pixel_t B[8][8];
+};
+
+struct coeff_data {
+    coeff_t R[8][8];
+    coeff_t G[8][8];
+    coeff_t B[8][8];
+};
+
+// Inverse of dct_accel's dct_2d. blk[u][v] holds block position (y=v, x=u)
+// (the [x][y] indexing of store_blocks_df); the host's idct_block_cpu sees
+// the block as h[r][c] = blk[c][r]. out is raster order.
+static void idct_2d(coeff_t blk[8][8], pixel_t out[8][8])
+{
+#pragma HLS INLINE
+    idct_t tmp[8][8];
+#pragma HLS ARRAY_PARTITION variable=tmp complete dim=0
+
+    // tmp[y][u] = sum_v C[v][y] * h[u][v]
+    for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+        for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+            idct_t acc = 0;
+            for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+                acc += C[v][y] * (idct_t)blk[v][u];
+            }
+            tmp[y][u] = acc;
+        }
+    }
+
+    // out[y][x] = sum_u C[u][x] * tmp[y][u] + 128
+    for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+        for (int x = 0; x < 8; x++) {
+#pragma HLS UNROLL
+            idct_t acc = 0;
+            for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+                acc += C[u][x] * tmp[y][u];
+            }
+            int val = (int)hls::round(acc + idct_t(128));
+            if (val < 0)   val = 0;
+            if (val > 255) val = 255;
+            out[y][x] = (pixel_t)val;
+        }
+    }
+}
+
+// Same [x][y] indexing as dct_accel's store; positions past the edge are 0
+static void load_coeffs_df(
+    const coeff_t* inR,
+    const coeff_t* inG,
+    const coeff_t* inB,
+    hls::stream<coeff_data>& coeff_stream,
+    int width,
+    int height
+) {
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+            coeff_data coef;
+
+            for (int i = 0; i < 64; i++) {
+#pragma HLS PIPELINE II=1
+                int y = i / 8;
+                int x = i % 8;
+                int gx = bx + x;
+                int gy = by + y;
+                bool inside = gx < width && gy < height;
+                int idx = gy * width + gx;
+                coef.R[x][y] = inside ? inR[idx] : coeff_t(0);
+                coef.G[x][y] = inside ? inG[idx] : coeff_t(0);
+                coef.B[x][y] = inside ? inB[idx] : coeff_t(0);
+            }
+            coeff_stream.write(coef);
+        }
+    }
+}
+
+// Quant steps as packed by the host: 3 tables of 64, indexed by block
+// position y*8+x
+static const int DQTAB_WORDS = 3 * 64;
+
+static void dequant_2d(coeff_t blk[8][8], const ap_uint<8> step[64])
+{
+#pragma HLS INLINE
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            // blk[u][v] is stored at block position (y=v, x=u)
+            int d = (int)blk[u][v] * (int)step[v * 8 + u];
+            if (d < -32768) d = -32768;
+            if (d >  32767) d =  32767;
+            blk[u][v] = (coeff_t)d;
+        }
+    }
+}
+
+static void dequant_blocks_df(
+    hls::stream<coeff_data>& in_stream,
+    hls::stream<coeff_data>& out_stream,
+    const ap_uint<32>* qtab,
+    int dequant_en,
+    int width,
+    int height
+) {
+    ap_uint<8> step[3][64];
+#pragma HLS ARRAY_PARTITION variable=step complete dim=0
+
+    for (int i = 0; i < DQTAB_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+        step[i / 64][i % 64] = qtab[i].range(7, 0);
+    }
+
+    int num_blocks = ((height + 7) / 8) * ((width + 7) / 8);
+
+    for (int i = 0; i < num_blocks; i++) {
+#pragma HLS PIPELINE II=1
+        coeff_data coef = in_stream.read();
+        if (dequant_en) {
+            dequant_2d(coef.R, step[0]);
+            dequant_2d(coef.G, step[1]);
+            dequant_2d(coef.B, step[2]);
+        }
+        out_stream.write(coef);
+    }
+}
+
+static void compute_idct_df(
+    hls::stream<coeff_data>& in_stream,
+    hls::stream<block_data>& out_stream,
+    int width,
+    int height
+) {
+    int num_blocks = ((height + 7) / 8) * ((width + 7) / 8);
+
+    for (int i = 0; i < num_blocks; i++) {
+#pragma HLS PIPELINE II=1
+        coeff_data coef = in_stream.read();
+        block_data blk;
+
+        idct_2d(coef.R, blk.R);
+        idct_2d(coef.G, blk.G);
+        idct_2d(coef.B, blk.B);
+
+        out_stream.write(blk);
+    }
+}
+
+static void store_pixels_df(
+    hls::stream<block_data>& block_stream,
+    pixel_t* outR,
+    pixel_t* outG,
+    pixel_t* outB,
+    int width,
+    int height
+) {
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+            block_data blk = block_stream.read();
+
+            for (int i = 0; i < 64; i++) {
+#pragma HLS PIPELINE II=1
+                int y = i / 8;
+                int x = i % 8;
+                int gx = bx + x;
+                int gy = by + y;
+                if (gx < width && gy < height) {
+                    int idx = gy * width + gx;
+                    outR[idx] = blk.R[y][x];
+                    outG[idx] = blk.G[y][x];
+                    outB[idx] = blk.B[y][x];
+                }
+            }
+        }
+    }
+}
+
+extern "C" void idct_accel(
+    const coeff_t* inR,
+    const coeff_t* inG,
+    const coeff_t* inB,
+    pixel_t* outR,
+    pixel_t* outG,
+    pixel_t* outB,
+    const ap_uint<32>* qtab,
+    int width,
+    int height,
+    int dequant_en
+) {
+#pragma HLS INTERFACE m_axi port=inR offset=slave bundle=gmem0 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inG offset=slave bundle=gmem1 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inB offset=slave bundle=gmem2 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=outR offset=slave bundle=gmem3 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outG offset=slave bundle=gmem4 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outB offset=slave bundle=gmem5 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=qtab offset=slave bundle=gmem6 depth=192
+#pragma HLS INTERFACE s_axilite port=width
+#pragma HLS INTERFACE s_axilite port=height
+#pragma HLS INTERFACE s_axilite port=dequant_en
+#pragma HLS INTERFACE s_axilite port=return
+
+#pragma HLS DATAFLOW
+
+    hls::stream<coeff_data> coeff_stream("coeff_stream");
+#pragma HLS STREAM variable=coeff_stream depth=4
+
+    hls::stream<coeff_data> dq_stream("dq_stream");
+#pragma HLS STREAM variable=dq_stream depth=4
+
+    hls::stream<block_data> block_stream("block_stream");
+#pragma HLS STREAM variable=block_stream depth=4
+
+    load_coeffs_df(inR, inG, inB, coeff_stream, width, height);
+    dequant_blocks_df(coeff_stream, dq_stream, qtab, dequant_en, width, height);
+    compute_idct_df(dq_stream, block_stream, width, height);
+    store_pixels_df(block_stream, outR, outG, outB, width, height);
+}
@@ -0,0 +1,359 @@
+// C-simulation harness: how narrow can dct_t get?
+//
+// The kernels' dct_2d (v2-v8; hls/v4_dct_accel.cpp) is instantiated here
+// with the datapath type as a template parameter, for every width in
+// DCT_WIDTHS, and run over a corpus of images against the same dataflow
+// in double precision. Per width it reports how many coefficients and
+// blocks differ, the error size, and the PSNR after the host's quantize/
+// dequantize/IDCT at one quality level next to the double-precision PSNR,
+// then picks the narrowest width that meets the target.
+//
+// Build (C simulation only, no kernel compile):
+//   make precision
+// Run:
+//   build/dct_precision data/*.png [--quality Q] [--max-psnr-loss DB] [--exact] [--csv FILE]
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "jpeg_cpu.hpp"
+#include "parallel.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+// (total bits, integer bits) of each dct_t tried. The row pass needs 10
+// integer bits and the column pass 11 (a flat block's DC reaches +-1024),
+// so I = 10 shows overflow; 24,6 is v1's type, 24,12 the other kernels'.
+#define DCT_WIDTHS(X) \
+    X(32, 16) X(24, 12) X(24, 6) \
+    X(22, 12) X(20, 12) X(18, 12) X(17, 12) X(16, 12) X(15, 12) X(14, 12) \
+    X(19, 11) X(17, 11) X(15, 11) X(14, 11) X(13, 11) \
+    X(18, 10) X(16, 10)
+
+// Coefficient ROM in the datapath type, as the kernels declare C
+template <class T>
+struct CoefRom {
+    T c[8][8];
+    CoefRom()
+    {
+        for (int i = 0; i < 8; i++)
+            for (int j = 0; j < 8; j++) c[i][j] = T(C_d[i][j]);
+    }
+};
+
+template <class T>
+static const CoefRom<T>& coef_rom()
+{
+    static const CoefRom<T> rom;
+    return rom;
+}
+
+// dct_2d of v2-v8 with dct_t = ap_fixed<W, I>; the block is [y][x] as the
+// kernel loaders fill it, the output 16-bit as coeff_t. dct_2d indexes
+// in_blk[x][v], so its output is the transpose of dct_block_cpu's.
+template <int W, int I>
+static void dct_2d_fixed(const pixel_t in_blk[8][8], coeff_t out_blk[8][8])
+{
+    typedef ap_fixed<W, I> dct_t;
+    const dct_t (&C)[8][8] = coef_rom<dct_t>().c;
+    dct_t tmp[8][8];
+
+    for (int u = 0; u < 8; u++) {
+        for (int v = 0; v < 8; v++) {
+            dct_t acc = 0;
+            for (int x = 0; x < 8; x++)
+                acc += C[u][x] * (dct_t)((int)in_blk[x][v] - 128);
+            tmp[u][v] = acc;
+        }
+    }
+
+    for (int u = 0; u < 8; u++) {
+        for (int v = 0; v < 8; v++) {
+            dct_t acc = 0;
+            for (int y = 0; y < 8; y++)
+                acc += tmp[u][y] * C[v][y];
+            int val = (int)hls::round(acc);
+
+            if (val < -32768) val = -32768;
+            if (val >  32767) val =  32767;
+
+            out_blk[u][v] = (coeff_t)val;
+        }
+    }
+}
+
+// The same dataflow with exact arithmetic: the ideal datapath
+static void dct_2d_double(const pixel_t in_blk[8][8], coeff_t out_blk[8][8])
+{
+    double tmp[8][8];
+    for (int u = 0; u < 8; u++)
+        for (int v = 0; v < 8; v++) {
+            double acc = 0;
+            for (int x = 0; x < 8; x++) acc += C_d[u][x] * ((int)in_blk[x][v] - 128);
+            tmp[u][v] = acc;
+        }
+    for (int u = 0; u < 8; u++)
+        for (int v = 0; v < 8; v++) {
+            double acc = 0;
+            for (int y = 0; y < 8; y++) acc += tmp[u][y] * C_d[v][y];
+            int val = (int)std::lround(acc);
+            out_blk[u][v] = (coeff_t)std::min(32767, std::max(-32768, val));
+        }
+}
+
+struct Width {
+    int bits, int_bits;
+    void (*dct)(const pixel_t[8][8], coeff_t[8][8]);
+};
+
+#define DCT_WIDTH_ENTRY(W, I) { W, I, dct_2d_fixed<W, I> },
+static const Width widths[] = { DCT_WIDTHS(DCT_WIDTH_ENTRY) };
+static const int num_widths = sizeof(widths) / sizeof(widths[0]);
+
+// DSP48E2 slices for a W x W multiply (27 x 18 per slice), times the 128
+// multipliers the pipelined row and column passes unroll to. A first-order
+// estimate only; synthesis may map narrow products to LUTs.
+static int dsp_estimate(int w)
+{
+    return 128 * ((w + 26) / 27) * ((w + 17) / 18);
+}
+
+struct Image {
+    std::string name;
+    int width, height, planes;
+    vector<pixel_t> pix[3];
+};
+
+// One width over one image
+struct Result {
+    size_t coeffs = 0, blocks = 0;
+    size_t bad_coeffs = 0, bad_blocks = 0;
+    int max_err = 0;
+    double sum_err = 0;
+    double sse = 0, sse_ref = 0;    // reconstruction vs source pixels
+    size_t pixels = 0;
+};
+
+static double psnr(double sse, size_t n)
+{
+    return sse == 0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 * n / sse);
+}
+
+static Result run_width(const Width& wd, const Image& img, const QuantTable& qt)
+{
+    Result r;
+    pixel_t in[8][8], rec[8][8];
+    coeff_t ref[8][8], out[8][8], tr[8][8], q[8][8], dq[8][8];
+    for (int c = 0; c < img.planes; c++) {
+        const vector<pixel_t>& p = img.pix[c];
+        int w = img.width, h = img.height;
+        for (int by = 0; by < h; by += 8) {
+            for (int bx = 0; bx < w; bx += 8) {
+                for (int y = 0; y < 8; y++)
+                    for (int x = 0; x < 8; x++)
+                        in[y][x] = p[size_t(std::min(by + y, h - 1)) * w + std::min(bx + x, w - 1)];
+                dct_2d_double(in, ref);
+                wd.dct(in, out);
+
+                int bad = 0;
+                for (int i = 0; i < 64; i++) {
+                    int e = std::abs(int((&out[0][0])[i]) - int((&ref[0][0])[i]));
+                    bad += e != 0;
+                    r.max_err = std::max(r.max_err, e);
+                    r.sum_err += e;
+                }
+                r.coeffs += 64;
+                r.blocks++;
+                r.bad_coeffs += bad;
+                r.bad_blocks += bad != 0;
+
+                // Reconstruction through the host's quantizer and IDCT, in
+                // dct_block_cpu orientation, for both
+                for (int pass = 0; pass < 2; pass++) {
+                    coeff_t (&k)[8][8] = pass ? ref : out;
+                    for (int y = 0; y < 8; y++)
+                        for (int x = 0; x < 8; x++) tr[y][x] = k[x][y];
+                    quant_block(tr, q, qt);
+                    dequant_block(q, dq, qt);
+                    idct_block_cpu(dq, rec);
+                    double& sse = pass ? r.sse_ref : r.sse;
+                    for (int y = 0; y < 8 && by + y < h; y++) {
+                        for (int x = 0; x < 8 && bx + x < w; x++) {
+                            double d = double(rec[y][x]) - double(in[y][x]);
+                            sse += d * d;
+                        }
+                    }
+                }
+                r.pixels += size_t(std::min(8, h - by)) * std::min(8, w - bx);
+            }
+        }
+    }
+    return r;
+}
+
+static void print_usage(const char* prog)
+{
+    cerr << "Usage: " << prog << " <image.png>... [options]\n"
+         << "Options:\n"
+         << "  --quality N         quality for the PSNR column (default 75)\n"
+         << "  --max-psnr-loss DB  target: PSNR at most DB below double precision on every image (default 0.05)\n"
+         << "  --exact             target: bit-exact with the double-precision datapath instead\n"
+         << "  --csv FILE          also write the table to FILE\n";
+}
+
+int main(int argc, char** argv)
+{
+    vector<std::string> files;
+    int quality = 75;
+    double max_loss = 0.05;
+    bool exact = false;
+    std::string csv;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--quality" && i + 1 < argc) {
+            quality = atoi(argv[++i]);
+        } else if (a == "--max-psnr-loss" && i + 1 < argc) {
+            max_loss = atof(argv[++i]);
+        } else if (a == "--exact") {
+            exact = true;
+        } else if (a == "--csv" && i + 1 < argc) {
+            csv = argv[++i];
+        } else if (a.compare(0, 2, "--") == 0) {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            files.push_back(a);
+        }
+    }
+    if (files.empty() || quality < 1 || quality > 100) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Gray images are one plane, everything else R, G, B
+    vector<Image> corpus;
+    for (auto& f : files) {
+        int w, h, ch;
+        if (!stbi_info(f.c_str(), &w, &h, &ch)) {
+            cerr << "WARNING: skipping " << f << " (cannot load)\n";
+            continue;
+        }
+        int planes = ch <= 2 ? 1 : 3;
+        unsigned char* data = stbi_load(f.c_str(), &w, &h, &ch, planes);
+        if (!data) continue;
+        Image img;
+        img.name = f;
+        img.width = w;
+        img.height = h;
+        img.planes = planes;
+        for (int c = 0; c < planes; c++) {
+            img.pix[c].resize(size_t(w) * h);
+            for (size_t i = 0; i < img.pix[c].size(); i++) img.pix[c][i] = data[i * planes + c];
+        }
+        stbi_image_free(data);
+        corpus.push_back(std::move(img));
+    }
+    if (corpus.empty()) {
+        cerr << "ERROR: no images loaded\n";
+        return 1;
+    }
+
+    QuantTable qt;
+    quant_table_init(qt, Q_luma, quality);
+
+    // Every (width, image) pair is an independent task
+    const int nimg = (int)corpus.size();
+    vector<Result> results(size_t(num_widths) * nimg);
+    parallel_for(0, (int)results.size(), host_num_threads(), [&](int, int lo, int hi) {
+        for (int t = lo; t < hi; t++)
+            results[t] = run_width(widths[t / nimg], corpus[t % nimg], qt);
+    });
+
+    size_t corpus_px = 0;
+    for (auto& img : corpus) corpus_px += size_t(img.width) * img.height * img.planes;
+    cout << "Corpus: " << nimg << " images, " << std::fixed << std::setprecision(2)
+         << corpus_px / 1e6 << " M samples; PSNR at quality " << quality << "\n\n";
+    cout << " dct_t              DSP est.  Mismatch %  Exact blk %  Max err  Mean err"
+            "   PSNR dB  Worst dPSNR\n";
+
+    std::ofstream out;
+    if (!csv.empty()) {
+        out.open(csv);
+        out << "bits,int_bits,dsp_est,mismatch_pct,exact_block_pct,max_err,mean_err,psnr_db,worst_dpsnr_db\n";
+    }
+
+    int best = -1;
+    for (int wi = 0; wi < num_widths; wi++) {
+        Result tot;
+        double worst_loss = 0;
+        for (int i = 0; i < nimg; i++) {
+            const Result& r = results[size_t(wi) * nimg + i];
+            tot.coeffs += r.coeffs;
+            tot.blocks += r.blocks;
+            tot.bad_coeffs += r.bad_coeffs;
+            tot.bad_blocks += r.bad_blocks;
+            tot.max_err = std::max(tot.max_err, r.max_err);
+            tot.sum_err += r.sum_err;
+            tot.sse += r.sse;
+            tot.sse_ref += r.sse_ref;
+            tot.pixels += r.pixels;
+            worst_loss = std::max(worst_loss, psnr(r.sse_ref, r.pixels) - psnr(r.sse, r.pixels));
+        }
+        const Width& wd = widths[wi];
+        double mismatch = 100.0 * tot.bad_coeffs / tot.coeffs;
+        double exact_blk = 100.0 * (tot.blocks - tot.bad_blocks) / tot.blocks;
+        double mean_err = tot.sum_err / tot.coeffs;
+        bool ok = exact ? tot.bad_coeffs == 0 : worst_loss <= max_loss;
+        if (ok && (best < 0 || wd.bits < widths[best].bits ||
+                   (wd.bits == widths[best].bits && wd.int_bits < widths[best].int_bits)))
+            best = wi;
+
+        std::string name = "ap_fixed<" + std::to_string(wd.bits) + "," + std::to_string(wd.int_bits) + ">";
+        cout << " " << std::left << std::setw(18) << name << std::right
+             << std::setw(9) << dsp_estimate(wd.bits)
+             << std::setprecision(3) << std::setw(12) << mismatch
+             << std::setprecision(2) << std::setw(13) << exact_blk
+             << std::setw(9) << tot.max_err
+             << std::setprecision(3) << std::setw(10) << mean_err
+             << std::setprecision(2) << std::setw(10) << psnr(tot.sse, tot.pixels)
+             << std::setprecision(3) << std::setw(13) << -worst_loss
+             << (ok ? "" : "  x") << "\n";
+        if (out.is_open())
+            out << wd.bits << "," << wd.int_bits << "," << dsp_estimate(wd.bits) << ","
+                << mismatch << "," << exact_blk << "," << tot.max_err << "," << mean_err << ","
+                << psnr(tot.sse, tot.pixels) << "," << -worst_loss << "\n";
+    }
+
+    Result ref;
+    for (auto& r : results) {
+        if (&r - &results[0] >= nimg) break;
+        ref.sse_ref += r.sse_ref;
+        ref.pixels += r.pixels;
+    }
+    cout << "\nDouble precision: " << std::setprecision(2) << psnr(ref.sse_ref, ref.pixels) << " dB\n";
+    cout << "Target: ";
+    if (exact)
+        cout << "bit-exact\n";
+    else
+        cout << "PSNR loss <= " << std::setprecision(3) << max_loss << " dB on every image\n";
+    if (best >= 0)
+        cout << "Narrowest datapath meeting it: ap_fixed<" << widths[best].bits << ","
+             << widths[best].int_bits << ">\n";
+    else
+        cout << "No width in DCT_WIDTHS meets it\n";
+    return 0;
+}
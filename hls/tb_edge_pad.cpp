@@ -0,0 +1,219 @@
+// C-simulation testbench for edge-replication padding of partial blocks.
+//
+// Every plane size with a width and height from EDGE_SIDES (1, 7, 9 and
+// 4097, one past v6's MAX_WIDTH) is transformed three ways:
+//   - kernel-padded: v4 on the raw w x h plane, its loader replicating the
+//     last column and row into partial blocks;
+//   - host-padded: the plane replicated out to whole blocks on the host
+//     (copy_rect_replicate), then v4 on the padded plane, and v6 on
+//     pitch_pad's layout where the plane fits its line buffers;
+//   - the host's golden DCT (cpu_dct_image): dct_block_cpu on
+//     edge-replicated blocks.
+// Host- and kernel-padded coefficients must be identical; against the
+// golden double-precision DCT the fixed-point kernels may round a
+// coefficient by up to MAX_GOLDEN_DIFF, while a block padded with zeros
+// instead would be off by far more. Images given on the command line are
+// checked the same way after the synthetic sizes.
+//
+// Build (C simulation only, no kernel compile):
+//   make csim_edge
+// Run:
+//   build/tb_edge_pad [image.png ...]
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+namespace v6 {
+#include "v6_dct_accel.cpp"
+}
+// v4 also exports dct_accel
+#define dct_accel dct_accel_v4
+namespace v4 {
+#include "v4_dct_accel.cpp"
+}
+#undef dct_accel
+
+#include "jpeg_cpu.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "tb_images.hpp"
+#include "planes.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+static const int EDGE_SIDES[] = { 1, 7, 9, 4097 };
+static const int MAX_GOLDEN_DIFF = 1;
+
+// The host's golden DCT (cpu_dct_image in host.cpp): edge-replicated blocks
+static void golden_plane(const vector<pixel_t>& in, int w, int h, vector<coeff_t>& out)
+{
+    out.resize(size_t(w) * h);
+    for (int by = 0; by < h; by += 8) {
+        for (int bx = 0; bx < w; bx += 8) {
+            pixel_t blk[8][8];
+            coeff_t res[8][8];
+            for (int y = 0; y < 8; y++)
+                for (int x = 0; x < 8; x++)
+                    blk[y][x] = in[size_t(std::min(by + y, h - 1)) * w + std::min(bx + x, w - 1)];
+            dct_block_cpu(blk, res);
+            for (int y = 0; y < 8 && by + y < h; y++)
+                for (int x = 0; x < 8 && bx + x < w; x++)
+                    out[size_t(by + y) * w + bx + x] = res[y][x];
+        }
+    }
+}
+
+// v4 over three w x h planes
+static void run_v4(const vector<pixel_t> planes[3], int w, int h, const vector<ap_uint<32>>& qwords,
+                   vector<coeff_t> out[3])
+{
+    vector<v4::pixel_t> in[3];
+    vector<v4::coeff_t> res[3];
+    for (int c = 0; c < 3; c++) {
+        in[c].assign(planes[c].begin(), planes[c].end());
+        res[c].resize(size_t(w) * h);
+    }
+    v4::dct_accel_v4(in[0].data(), in[1].data(), in[2].data(),
+                     res[0].data(), res[1].data(), res[2].data(),
+                     qwords.data(), w, h, 0);
+    for (int c = 0; c < 3; c++) {
+        out[c].resize(res[c].size());
+        for (size_t i = 0; i < res[c].size(); i++) out[c][i] = coeff_t(int(res[c][i]));
+    }
+}
+
+// v6 over three planes in pitch_pad's layout, cropped back to w x h
+static void run_v6(const vector<pixel_t> planes[3], int w, int h, const vector<ap_uint<32>>& qwords,
+                   vector<coeff_t> out[3])
+{
+    const PitchedLayout pl = pitched_layout(w, h);
+    const size_t words = pl.size() / 8;
+    vector<v6::pix8_t> in[3];
+    vector<v6::coef8_t> res[3];
+    for (int c = 0; c < 3; c++) {
+        vector<pixel_t> padded;
+        pitch_pad(planes[c], w, h, pl, padded);
+        in[c].resize(words);
+        for (size_t i = 0; i < words; i++)
+            for (int x = 0; x < 8; x++) in[c][i].range(8 * x + 7, 8 * x) = padded[i * 8 + x];
+        res[c].resize(words);
+    }
+    v6::dct_accel(in[0].data(), in[1].data(), in[2].data(),
+                  res[0].data(), res[1].data(), res[2].data(),
+                  qwords.data(), pl.width, pl.height, pl.pitch, 0);
+    for (int c = 0; c < 3; c++) {
+        vector<coeff_t> full(pl.size());
+        for (size_t i = 0; i < words; i++)
+            for (int x = 0; x < 8; x++)
+                full[i * 8 + x] = coeff_t(int(ap_int<16>(res[c][i].range(16 * x + 15, 16 * x))));
+        pitch_crop(full, w, h, pl, out[c]);
+    }
+}
+
+static long count_diff(const vector<coeff_t>& a, const vector<coeff_t>& b, int& max_diff)
+{
+    long n = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        int d = std::abs(int(a[i]) - int(b[i]));
+        n += d != 0;
+        max_diff = std::max(max_diff, d);
+    }
+    return n;
+}
+
+// One plane size; returns the number of failed comparisons
+static int check(const Image& im, const vector<ap_uint<32>>& qwords, long& golden_diff, int& golden_max)
+{
+    const int w = im.w, h = im.h;
+    int bad = 0;
+
+    vector<coeff_t> kernel_padded[3];
+    run_v4(im.p, w, h, qwords, kernel_padded);
+
+    // Host-padded, dense: whole blocks, so v4 never pads
+    const int pw = round_up8(w), ph = round_up8(h);
+    vector<pixel_t> padded[3];
+    vector<coeff_t> host_padded[3];
+    for (int c = 0; c < 3; c++) {
+        padded[c].resize(size_t(pw) * ph);
+        copy_rect_replicate(im.p[c].data(), w, padded[c].data(), pw, w, h, pw, ph);
+    }
+    run_v4(padded, pw, ph, qwords, host_padded);
+    for (int c = 0; c < 3; c++) {
+        vector<coeff_t> cropped(size_t(w) * h);
+        copy_rect(host_padded[c].data(), pw, cropped.data(), w, w, h);
+        host_padded[c].swap(cropped);
+    }
+
+    // Host-padded, pitched (v6); the host refuses planes wider than MAX_WIDTH
+    const bool fits_v6 = pitched_layout(w, h).width <= v6::MAX_WIDTH;
+    vector<coeff_t> pitched[3];
+    if (fits_v6) run_v6(im.p, w, h, qwords, pitched);
+
+    for (int c = 0; c < 3; c++) {
+        int max_diff = 0;
+        long d = count_diff(host_padded[c], kernel_padded[c], max_diff);
+        if (d) {
+            cerr << "  " << im.name << " ch" << c << ": host-padded v4 differs from kernel-padded in "
+                 << d << " coefficients\n";
+            bad++;
+        }
+        if (fits_v6 && (d = count_diff(pitched[c], kernel_padded[c], max_diff)) != 0) {
+            cerr << "  " << im.name << " ch" << c << ": v6 differs from kernel-padded v4 in "
+                 << d << " coefficients\n";
+            bad++;
+        }
+
+        vector<coeff_t> gold;
+        golden_plane(im.p[c], w, h, gold);
+        int gmax = 0;
+        golden_diff += count_diff(kernel_padded[c], gold, gmax);
+        golden_max = std::max(golden_max, gmax);
+        if (gmax > MAX_GOLDEN_DIFF) {
+            cerr << "  " << im.name << " ch" << c << ": off the golden DCT by up to " << gmax << "\n";
+            bad++;
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char** argv)
+{
+    // Unquantized, so every coefficient shows; the tables are not read
+    vector<ap_uint<32>> qwords(3 * 64, 0);
+
+    int runs = 0, failed = 0, golden_max = 0;
+    long golden_diff = 0, coeffs = 0;
+    vector<Image> images;
+    uint32_t seed = 1;
+    for (int w : EDGE_SIDES)
+        for (int h : EDGE_SIDES)
+            if (w <= 4096 || h <= 4096)     // 4097 x 4097 adds nothing but time
+                images.push_back(synthetic(w, h, seed++));
+    if (argc > 1) {
+        vector<Image> files;
+        if (!load_test_images(argc, argv, files)) return 1;
+        images.insert(images.end(), files.begin(), files.end());
+    }
+
+    for (auto& im : images) {
+        runs++;
+        failed += check(im, qwords, golden_diff, golden_max) != 0;
+        coeffs += 3L * im.w * im.h;
+    }
+
+    cout << "Edge padding: " << runs - failed << " / " << runs
+         << " sizes match between host- and kernel-padded; " << golden_diff << " of " << coeffs
+         << " coefficients off the golden DCT, max " << golden_max << "\n";
+    cout << (failed ? "FAIL" : "PASS") << "\n";
+    return failed ? 1 : 0;
+}
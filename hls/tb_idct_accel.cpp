@@ -0,0 +1,199 @@
+// C-simulation testbench for hls/idct_accel.cpp.
+//
+// Builds coefficient planes the way the encode side produces them (the
+// host's golden DCT, quantized at several quality levels, plus planes of
+// random coefficients up to the 16-bit limits), runs idct_accel as C++
+// with and without on-kernel dequantization and compares every pixel with
+// the host's decode half: zero-padded blocks, dequant_block,
+// idct_block_cpu. Fixed point and double may round a value that sits on a
+// .5 boundary differently, so up to MAX_OFF_BY_ONE of the pixels may be
+// off by 1; anything more fails.
+//
+// Build (C simulation only, no kernel compile):
+//   make csim_idct
+// Run:
+//   build/tb_idct_accel [image.png ...]
+// Without arguments a synthetic set covers partial edge blocks, a single
+// block and sizes below one block.
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+namespace kernel {
+#include "idct_accel.cpp"
+}
+
+#include "jpeg_cpu.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "tb_images.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+static const double MAX_OFF_BY_ONE = 1e-5;
+
+// Quantize (or dequantize) every block of a raster plane in place, as the
+// host's quantize_image does
+template <class F>
+static void map_blocks(vector<coeff_t>& plane, int w, int h, F fn)
+{
+    for (int by = 0; by < h; by += 8) {
+        for (int bx = 0; bx < w; bx += 8) {
+            coeff_t blk[8][8], res[8][8];
+            for (int y = 0; y < 8; y++)
+                for (int x = 0; x < 8; x++)
+                    blk[y][x] = (bx + x < w && by + y < h) ? plane[size_t(by + y) * w + bx + x] : 0;
+            fn(blk, res);
+            for (int y = 0; y < 8 && by + y < h; y++)
+                for (int x = 0; x < 8 && bx + x < w; x++)
+                    plane[size_t(by + y) * w + bx + x] = res[y][x];
+        }
+    }
+}
+
+// The host's golden DCT (cpu_dct_image in host.cpp): edge-replicated blocks
+static void dct_plane(const vector<pixel_t>& in, int w, int h, vector<coeff_t>& out)
+{
+    out.resize(size_t(w) * h);
+    for (int by = 0; by < h; by += 8) {
+        for (int bx = 0; bx < w; bx += 8) {
+            pixel_t blk[8][8];
+            coeff_t res[8][8];
+            for (int y = 0; y < 8; y++)
+                for (int x = 0; x < 8; x++)
+                    blk[y][x] = in[size_t(std::min(by + y, h - 1)) * w + std::min(bx + x, w - 1)];
+            dct_block_cpu(blk, res);
+            for (int y = 0; y < 8 && by + y < h; y++)
+                for (int x = 0; x < 8 && bx + x < w; x++)
+                    out[size_t(by + y) * w + bx + x] = res[y][x];
+        }
+    }
+}
+
+// The host's decode of one plane
+static void host_decode(const vector<coeff_t>& coeffs, int w, int h, const QuantTable* qt,
+                        vector<pixel_t>& out)
+{
+    out.resize(size_t(w) * h);
+    for (int by = 0; by < h; by += 8) {
+        for (int bx = 0; bx < w; bx += 8) {
+            coeff_t blk[8][8], dq[8][8];
+            pixel_t rec[8][8];
+            for (int y = 0; y < 8; y++)
+                for (int x = 0; x < 8; x++)
+                    blk[y][x] = (bx + x < w && by + y < h) ? coeffs[size_t(by + y) * w + bx + x] : 0;
+            if (qt)
+                dequant_block(blk, dq, *qt);
+            else
+                std::copy(&blk[0][0], &blk[0][0] + 64, &dq[0][0]);
+            idct_block_cpu(dq, rec);
+            for (int y = 0; y < 8 && by + y < h; y++)
+                for (int x = 0; x < 8 && bx + x < w; x++)
+                    out[size_t(by + y) * w + bx + x] = rec[y][x];
+        }
+    }
+}
+
+// One kernel run over three coefficient planes; returns differing pixels
+static long check(const std::string& what, vector<coeff_t> planes[3], int w, int h,
+                  const QuantTable qt[3], int dequant_en, int& max_diff)
+{
+    const size_t n = size_t(w) * h;
+    vector<kernel::coeff_t> in[3];
+    vector<kernel::pixel_t> out[3];
+    for (int c = 0; c < 3; c++) {
+        in[c].assign(planes[c].begin(), planes[c].end());
+        out[c].resize(n);
+    }
+    vector<uint32_t> packed;
+    pack_dequant_tables(qt, packed);
+    vector<ap_uint<32>> steps(packed.begin(), packed.end());
+
+    kernel::idct_accel(in[0].data(), in[1].data(), in[2].data(),
+                       out[0].data(), out[1].data(), out[2].data(),
+                       steps.data(), w, h, dequant_en);
+
+    long bad = 0;
+    for (int c = 0; c < 3; c++) {
+        vector<pixel_t> want;
+        host_decode(planes[c], w, h, dequant_en ? &qt[c] : nullptr, want);
+        for (size_t i = 0; i < n; i++) {
+            int d = std::abs(int(out[c][i]) - int(want[i]));
+            bad += d != 0;
+            max_diff = std::max(max_diff, d);
+        }
+    }
+    if (bad) cerr << "  " << what << " dequant_en=" << dequant_en << ": " << bad << " pixels differ\n";
+    return bad;
+}
+
+int main(int argc, char** argv)
+{
+    vector<Image> images;
+    if (!load_test_images(argc, argv, images)) return 1;
+
+    const int qualities[] = { 1, 10, 50, 90, 100 };
+    int runs = 0, max_diff = 0;
+    long pixels = 0, bad = 0;
+    for (auto& im : images) {
+        vector<coeff_t> raw[3];
+        for (int c = 0; c < 3; c++) dct_plane(im.p[c], im.w, im.h, raw[c]);
+        for (int q : qualities) {
+            QuantTable qt[3];
+            quant_table_init(qt[0], Q_luma, q);
+            quant_table_init(qt[1], Q_chroma, q);
+            quant_table_init(qt[2], Q_chroma, q);
+            vector<coeff_t> quant[3], dequant[3];
+            for (int c = 0; c < 3; c++) {
+                const QuantTable& t = qt[c];
+                quant[c] = raw[c];
+                map_blocks(quant[c], im.w, im.h, [&](coeff_t in[8][8], coeff_t out[8][8]) {
+                    quant_block(in, out, t);
+                });
+                dequant[c] = quant[c];
+                map_blocks(dequant[c], im.w, im.h, [&](coeff_t in[8][8], coeff_t out[8][8]) {
+                    dequant_block(in, out, t);
+                });
+            }
+            std::string what = im.name + " q" + std::to_string(q);
+            long b = check(what, quant, im.w, im.h, qt, 1, max_diff) +
+                     check(what, dequant, im.w, im.h, qt, 0, max_diff);
+            runs += 2;
+            bad += b;
+            pixels += 6 * long(im.w) * im.h;
+        }
+    }
+
+    // Random coefficients over the whole 16-bit range, as a foreign encoder
+    // could send, exercise the datapath's range, saturation and clamping
+    {
+        std::mt19937 rng(7);
+        const int w = 40, h = 24;
+        vector<coeff_t> planes[3];
+        for (int c = 0; c < 3; c++) {
+            planes[c].resize(size_t(w) * h);
+            for (auto& v : planes[c]) v = coeff_t(int(rng() % 65536) - 32768);
+        }
+        QuantTable qt[3];
+        for (int c = 0; c < 3; c++) quant_table_init(qt[c], Q_luma, 50);
+        bad += check("random 16-bit", planes, w, h, qt, 1, max_diff);
+        runs++;
+        pixels += 3L * w * h;
+    }
+
+    bool failed = max_diff > 1 || bad > pixels * MAX_OFF_BY_ONE;
+    cout << "idct_accel: " << runs << " runs, " << bad << " of " << pixels
+         << " pixels differ from the host decode, max " << max_diff << "\n";
+    cout << (failed ? "FAIL" : "PASS") << "\n";
+    return failed ? 1 : 0;
+}
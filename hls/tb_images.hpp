@@ -0,0 +1,66 @@
+#pragma once
+// Test images shared by the C-simulation testbenches: the PNGs named on
+// the command line, or a synthetic set that covers partial edge blocks, a
+// single block and sizes below one block. The testbench defines
+// STB_IMAGE_IMPLEMENTATION before including this header.
+#include "stb_image.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+
+#include "jpeg_cpu.hpp"
+
+struct Image {
+    std::string name;
+    int w, h;
+    std::vector<pixel_t> p[3];
+};
+
+// Smooth gradients plus noise, different per channel, so blocks have both
+// long zero runs and busy high frequencies
+static Image synthetic(int w, int h, uint32_t seed)
+{
+    Image im = { "synthetic " + std::to_string(w) + "x" + std::to_string(h), w, h, {} };
+    std::mt19937 rng(seed);
+    for (int c = 0; c < 3; c++) {
+        im.p[c].resize(size_t(w) * h);
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++) {
+                int v = (x * (3 + c) + y * (5 - c)) % 256;
+                if ((x / 8 + y / 8 + c) % 3 == 0) v += int(rng() % 64) - 32;
+                im.p[c][size_t(y) * w + x] = pixel_t(std::min(255, std::max(0, v)));
+            }
+    }
+    return im;
+}
+
+// argv[1..] as RGB planes, or the synthetic set without arguments; false
+// if a file cannot be loaded
+static bool load_test_images(int argc, char** argv, std::vector<Image>& images)
+{
+    for (int i = 1; i < argc; i++) {
+        int w, h, ch;
+        unsigned char* img = stbi_load(argv[i], &w, &h, &ch, 3);
+        if (!img) {
+            std::cerr << "ERROR: Cannot load " << argv[i] << "\n";
+            return false;
+        }
+        Image im = { argv[i], w, h, {} };
+        for (int c = 0; c < 3; c++) {
+            im.p[c].resize(size_t(w) * h);
+            for (size_t j = 0; j < im.p[c].size(); j++) im.p[c][j] = img[3 * j + c];
+        }
+        stbi_image_free(img);
+        images.push_back(im);
+    }
+    if (images.empty()) {
+        const int sizes[][2] = { {64, 64}, {37, 21}, {100, 31}, {203, 117}, {8, 8}, {5, 3}, {1, 1} };
+        uint32_t seed = 1;
+        for (auto& s : sizes) images.push_back(synthetic(s[0], s[1], seed++));
+    }
+    return true;
+}
@@ -0,0 +1,205 @@
+// C-simulation testbench for hls/v10_dct_accel.cpp.
+//
+// Runs the v10 round trip (DCT, quantize, dequantize, IDCT, squared error)
+// as C++ at several quality levels, with and without reconstructed pixels.
+// v10's DCT and quantizer are v4's, so v4 runs on the same planes and the
+// host's decode half (dequant_block, idct_block_cpu) turns its quantized
+// coefficients into the reference pixels:
+//   - fixed point and double may round a value that sits on a .5 boundary
+//     differently, so up to MAX_OFF_BY_ONE of the pixels may be off by 1;
+//     anything more fails;
+//   - sse must be exactly the squared error of the kernel's own pixels
+//     against the source, the same whether recon_en is set or not, and
+//     give the reference's PSNR to within PSNR_TOL_DB;
+//   - with recon_en clear the output planes must not be touched.
+// Grayscale images run the way the host sends them: the same plane on
+// every port, channel 0 read back.
+// (Against the golden double DCT the pixels differ more often, wherever
+// v4's fixed-point DCT lands a coefficient on the other side of a
+// quantizer step; the host's audit compares PSNRs for that reason.)
+//
+// Build (C simulation only, no kernel compile):
+//   make csim_roundtrip
+// Run:
+//   build/tb_v10_roundtrip [image.png ...]
+// Without arguments a synthetic set covers partial edge blocks, a single
+// block and sizes below one block; each is also run as grayscale.
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+namespace v10 {
+#include "v10_dct_accel.cpp"
+}
+// v4 also exports dct_accel
+#define dct_accel dct_accel_v4
+namespace v4 {
+#include "v4_dct_accel.cpp"
+}
+#undef dct_accel
+
+#include "jpeg_cpu.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "tb_images.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+static const double MAX_OFF_BY_ONE = 1e-5;
+static const double PSNR_TOL_DB = 0.05;
+
+// The host's decode of one quantized plane (reconstruct_plane in host.cpp):
+// coefficients of partial edge blocks outside the plane are taken as 0
+static void host_decode(const vector<coeff_t>& coeffs, int w, int h, const QuantTable& qt,
+                        vector<pixel_t>& out)
+{
+    out.resize(size_t(w) * h);
+    for (int by = 0; by < h; by += 8) {
+        for (int bx = 0; bx < w; bx += 8) {
+            coeff_t blk[8][8], dq[8][8];
+            pixel_t rec[8][8];
+            for (int y = 0; y < 8; y++)
+                for (int x = 0; x < 8; x++)
+                    blk[y][x] = (bx + x < w && by + y < h) ? coeffs[size_t(by + y) * w + bx + x] : 0;
+            dequant_block(blk, dq, qt);
+            idct_block_cpu(dq, rec);
+            for (int y = 0; y < 8 && by + y < h; y++)
+                for (int x = 0; x < 8 && bx + x < w; x++)
+                    out[size_t(by + y) * w + bx + x] = rec[y][x];
+        }
+    }
+}
+
+static uint64_t plane_sse(const vector<pixel_t>& a, const vector<pixel_t>& b)
+{
+    uint64_t s = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        int d = int(a[i]) - int(b[i]);
+        s += uint64_t(d * d);
+    }
+    return s;
+}
+
+static double psnr(uint64_t sse, size_t n)
+{
+    double mse = double(sse) / double(n);
+    return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+struct Totals {
+    int runs = 0, failed = 0;
+    long pixels = 0, diff = 0;
+    int max_diff = 0;
+    double max_delta = 0.0;
+};
+
+// One image at one quality, both recon_en settings
+static void check(const std::string& what, const vector<pixel_t>* planes[3], int nplanes,
+                  int w, int h, const QuantTable qt[3], Totals& t)
+{
+    const size_t n = size_t(w) * h;
+    vector<v10::pixel_t> in[3], out[3], untouched[3];
+    vector<v4::coeff_t> quant[3];
+    for (int c = 0; c < 3; c++) {
+        in[c].assign(planes[c]->begin(), planes[c]->end());
+        out[c].assign(n, 0);
+        untouched[c].assign(n, 0x5a);
+        quant[c].resize(n);
+    }
+    vector<uint32_t> packed;
+    pack_roundtrip_tables(qt, packed);
+    vector<ap_uint<32>> qwords(packed.begin(), packed.end());
+
+    ap_uint<64> sse[3], sse_norecon[3];
+    v10::dct_accel(in[0].data(), in[1].data(), in[2].data(),
+                   out[0].data(), out[1].data(), out[2].data(),
+                   qwords.data(), w, h, 1, sse);
+    v10::dct_accel(in[0].data(), in[1].data(), in[2].data(),
+                   untouched[0].data(), untouched[1].data(), untouched[2].data(),
+                   qwords.data(), w, h, 0, sse_norecon);
+    // The round trip's tables start with v4's
+    v4::dct_accel_v4(in[0].data(), in[1].data(), in[2].data(),
+                     quant[0].data(), quant[1].data(), quant[2].data(),
+                     qwords.data(), w, h, 1);
+
+    bool ok = true;
+    for (int c = 0; c < nplanes; c++) {
+        vector<pixel_t> rec(out[c].begin(), out[c].end()), want;
+        host_decode(vector<coeff_t>(quant[c].begin(), quant[c].end()), w, h, qt[c], want);
+
+        uint64_t own = plane_sse(*planes[c], rec);
+        if (uint64_t(sse[c]) != own || uint64_t(sse_norecon[c]) != own) {
+            cerr << "  " << what << " ch" << c << ": sse " << uint64_t(sse[c]) << " / "
+                 << uint64_t(sse_norecon[c]) << " (recon_en 1 / 0), pixels give " << own << "\n";
+            ok = false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (untouched[c][i] != 0x5a) {
+                cerr << "  " << what << " ch" << c << ": recon_en=0 wrote pixel " << i << "\n";
+                ok = false;
+                break;
+            }
+        }
+
+        long diff = 0;
+        for (size_t i = 0; i < n; i++) {
+            int d = std::abs(int(rec[i]) - int(want[i]));
+            diff += d != 0;
+            t.max_diff = std::max(t.max_diff, d);
+        }
+        double delta = std::fabs(psnr(uint64_t(sse[c]), n) - psnr(plane_sse(*planes[c], want), n));
+        t.max_delta = std::max(t.max_delta, delta);
+        if (delta > PSNR_TOL_DB) {
+            cerr << "  " << what << " ch" << c << ": PSNR off the reference's by " << delta << " dB\n";
+            ok = false;
+        }
+        t.diff += diff;
+        t.pixels += long(n);
+    }
+    t.runs++;
+    t.failed += !ok;
+}
+
+int main(int argc, char** argv)
+{
+    vector<Image> images;
+    if (!load_test_images(argc, argv, images)) return 1;
+
+    const int qualities[] = { 10, 50, 90, 100 };
+    Totals t;
+    for (auto& im : images) {
+        for (int q : qualities) {
+            QuantTable qt[3];
+            quant_table_init(qt[0], Q_luma, q);
+            quant_table_init(qt[1], Q_chroma, q);
+            quant_table_init(qt[2], Q_chroma, q);
+            std::string what = im.name + " q" + std::to_string(q);
+
+            const vector<pixel_t>* rgb[3] = { &im.p[0], &im.p[1], &im.p[2] };
+            check(what, rgb, 3, im.w, im.h, qt, t);
+
+            // Grayscale: the host sends the one plane to every port and
+            // reads channel 0 with the luma table
+            const vector<pixel_t>* gray[3] = { &im.p[0], &im.p[0], &im.p[0] };
+            QuantTable gq[3] = { qt[0], qt[0], qt[0] };
+            check(what + " gray", gray, 1, im.w, im.h, gq, t);
+        }
+    }
+
+    bool failed = t.failed || t.max_diff > 1 || t.diff > t.pixels * MAX_OFF_BY_ONE;
+    cout << "v10 round trip: " << t.runs - t.failed << " / " << t.runs << " runs pass, "
+         << t.diff << " of " << t.pixels << " pixels differ from the host decode of v4 (max "
+         << t.max_diff << "), PSNR within " << t.max_delta << " dB\n";
+    cout << (failed ? "FAIL" : "PASS") << "\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+// C-simulation testbench for the v11 stream pipeline.
+//
+// Tiles each image the way the host does (raster_to_tiles), then runs
+// dct_mm2s -> dct_accel -> dct_s2mm as C++ over hls::stream channels, with
+// dct_accel called once per block the way the free-running kernel runs on
+// the card. Images go through back to back on the same streams, with no
+// reset in between. Checks:
+//   - every coefficient word matches v7 (the same transform on m_axi
+//     buffers) run on the same tiles;
+//   - TLAST is set on exactly the last beat of each image, on every
+//     channel;
+//   - no beats are left over in any stream.
+// Differences from the host's golden DCT (dct_block_cpu) are only
+// reported: v3's 24-bit transform is off by 1 in a share of the
+// coefficients (see make precision).
+//
+// Build (C simulation only, no kernel compile):
+//   make csim_stream
+// Run:
+//   build/tb_v11_stream [image.png ...]
+// Without arguments a synthetic set covers partial edge blocks, a single
+// block and sizes below one block.
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <ap_axi_sdata.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+namespace stream_kernel {
+#include "v11_dct_accel.cpp"
+}
+namespace movers {
+#include "v11_data_movers.cpp"
+}
+// v7 also exports dct_accel
+#define dct_accel dct_accel_v7
+namespace v7 {
+#include "v7_dct_accel.cpp"
+}
+#undef dct_accel
+
+#include "jpeg_cpu.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "tb_images.hpp"
+#include "tiles.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+typedef hls::stream<movers::pix_beat_t> pix_stream;
+typedef hls::stream<movers::coef_beat_t> coef_stream;
+
+// Move the beats of one image out of s, checking TLAST, and put them back
+static int check_last(coef_stream& s, size_t beats)
+{
+    vector<movers::coef_beat_t> v;
+    int bad = 0;
+    for (size_t i = 0; i < beats && !s.empty(); i++) {
+        v.push_back(s.read());
+        bad += int(v.back().last) != int(i == beats - 1);
+    }
+    bad += v.size() != beats;
+    for (auto& b : v) s.write(b);
+    return bad;
+}
+
+// One image through the stream pipeline; returns the number of failures
+static int check(const Image& im, pix_stream in[3], coef_stream out[3], long& golden_diff)
+{
+    const int nblocks = tiled_blocks_x(im.w) * tiled_blocks_y(im.h);
+    const size_t beats = size_t(nblocks) * 8;
+
+    vector<ap_uint<64>> words[3];
+    for (int c = 0; c < 3; c++) {
+        vector<pixel_t> tiles;
+        raster_to_tiles(im.p[c], im.w, im.h, tiles);
+        words[c].resize(beats);
+        for (size_t i = 0; i < beats; i++)
+            for (int x = 0; x < 8; x++) words[c][i].range(8 * x + 7, 8 * x) = tiles[i * 8 + x];
+    }
+
+    movers::dct_mm2s(words[0].data(), words[1].data(), words[2].data(),
+                     in[0], in[1], in[2], nblocks);
+    for (int i = 0; i < nblocks; i++)
+        stream_kernel::dct_accel(in[0], in[1], in[2], out[0], out[1], out[2]);
+
+    int bad = 0;
+    for (int c = 0; c < 3; c++) {
+        if (!in[c].empty()) {
+            cerr << "  " << im.name << ": input stream " << c << " not drained\n";
+            bad++;
+        }
+        int b = check_last(out[c], beats);
+        if (b) cerr << "  " << im.name << ": TLAST wrong on " << b << " beats of channel " << c << "\n";
+        bad += b;
+    }
+
+    vector<ap_uint<128>> got[3], want[3];
+    for (int c = 0; c < 3; c++) {
+        got[c].resize(beats);
+        want[c].resize(beats);
+    }
+    movers::dct_s2mm(out[0], out[1], out[2], got[0].data(), got[1].data(), got[2].data(), nblocks);
+    for (int c = 0; c < 3; c++) {
+        if (!out[c].empty()) {
+            cerr << "  " << im.name << ": output stream " << c << " has extra beats\n";
+            bad++;
+        }
+    }
+
+    ap_uint<32> qtab[v7::QTAB_WORDS] = {};
+    v7::dct_accel_v7(words[0].data(), words[1].data(), words[2].data(),
+                     want[0].data(), want[1].data(), want[2].data(), qtab, nblocks, 0);
+
+    int words_bad = 0;
+    for (int c = 0; c < 3; c++) {
+        vector<pixel_t> tiles;
+        raster_to_tiles(im.p[c], im.w, im.h, tiles);
+        vector<coeff_t> gold(tiles.size());
+        cpu_dct_tiles(tiles.data(), nblocks, gold.data());
+        for (size_t i = 0; i < beats; i++) {
+            words_bad += got[c][i] != want[c][i];
+            for (int x = 0; x < 8; x++)
+                golden_diff += coeff_t(int(ap_int<16>(got[c][i].range(16 * x + 15, 16 * x)))) != gold[i * 8 + x];
+        }
+    }
+    if (words_bad) cerr << "  " << im.name << ": " << words_bad << " words differ from v7\n";
+    return bad + words_bad;
+}
+
+int main(int argc, char** argv)
+{
+    vector<Image> images;
+    if (!load_test_images(argc, argv, images)) return 1;
+
+    // One set of channels for all images, as on the card
+    pix_stream in[3];
+    coef_stream out[3];
+    int failed = 0;
+    long golden_diff = 0, coeffs = 0;
+    for (auto& im : images) {
+        failed += check(im, in, out, golden_diff) != 0;
+        coeffs += 3L * tiled_size(im.w, im.h);
+    }
+
+    cout << "v11 stream pipeline: " << images.size() - failed << " / " << images.size()
+         << " images match v7 with TLAST in place\n";
+    cout << "Golden DCT: " << golden_diff << " / " << coeffs << " coefficients differ (v3 transform)\n";
+    cout << (failed ? "FAIL" : "PASS") << "\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+// C-simulation testbench for the v12 cycle counters.
+//
+// Runs hls/v12_dct_accel.cpp and v4 as C++ on the same planes and checks
+// that the instrumentation changed nothing and counts what it should:
+//   - every coefficient matches v4, with and without quantization;
+//   - active cycles are 64 per block for load and store (one pixel per
+//     cycle) and 1 per block for the DCT and quantizer;
+//   - every stage reported, so the timer stamped it.
+// C simulation runs the dataflow stages one after another, so the stream
+// stall counts stay 0 and the finish cycles say nothing about hardware
+// timing. Those need hardware emulation or a card.
+//
+// Build (C simulation only, no kernel compile):
+//   make csim_perf
+// Run:
+//   build/tb_v12_perf [image.png ...]
+// Without arguments the synthetic set from tb_images.hpp is used.
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+namespace v12 {
+#include "v12_dct_accel.cpp"
+}
+// v4 also exports dct_accel
+#define dct_accel dct_accel_v4
+namespace v4 {
+#include "v4_dct_accel.cpp"
+}
+#undef dct_accel
+
+#include "jpeg_cpu.hpp"
+#include "kernel_perf.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "tb_images.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+static_assert(v12::PERF_WORDS == KPERF_WORDS, "kernel/host perf layout differ");
+static_assert(v12::PERF_STAGE_WORDS == KPERF_STAGE_WORDS, "kernel/host perf layout differ");
+
+// One run of both kernels on an image; returns the number of failed checks
+static int check(const Image& im, int quant_en)
+{
+    const int w = im.w, h = im.h;
+    const size_t n = size_t(w) * h;
+    const uint32_t blocks = uint32_t(((w + 7) / 8) * ((h + 7) / 8));
+    vector<v12::pixel_t> in[3];
+    vector<v12::coeff_t> got[3], want[3];
+    for (int c = 0; c < 3; c++) {
+        in[c].assign(im.p[c].begin(), im.p[c].end());
+        got[c].resize(n);
+        want[c].resize(n);
+    }
+    QuantTable qt[3];
+    quant_table_init(qt[0], Q_luma, 50);
+    quant_table_init(qt[1], Q_chroma, 50);
+    quant_table_init(qt[2], Q_chroma, 50);
+    vector<uint32_t> packed;
+    pack_quant_tables(qt, packed);
+    vector<ap_uint<32>> qwords(packed.begin(), packed.end());
+    ap_uint<32> perf[v12::PERF_WORDS];
+
+    v12::dct_accel(in[0].data(), in[1].data(), in[2].data(),
+                   got[0].data(), got[1].data(), got[2].data(),
+                   qwords.data(), w, h, quant_en, perf);
+    v4::dct_accel_v4(in[0].data(), in[1].data(), in[2].data(),
+                     want[0].data(), want[1].data(), want[2].data(),
+                     qwords.data(), w, h, quant_en);
+
+    const std::string what = im.name + " quant_en=" + std::to_string(quant_en);
+    int bad = 0;
+    size_t diff = 0;
+    for (int c = 0; c < 3; c++)
+        for (size_t i = 0; i < n; i++) diff += got[c][i] != want[c][i];
+    if (diff) {
+        cerr << "  " << what << ": " << diff << " coefficients differ from v4\n";
+        bad++;
+    }
+
+    uint32_t words[KPERF_WORDS];
+    for (int i = 0; i < KPERF_WORDS; i++) words[i] = (uint32_t)perf[i];
+    StagePerf stages[KPERF_STAGES];
+    unpack_kernel_perf(words, stages);
+    const uint32_t want_active[KPERF_STAGES] = { 64 * blocks, blocks, blocks, 64 * blocks };
+    for (int s = 0; s < KPERF_STAGES; s++) {
+        if (stages[s].active != want_active[s]) {
+            cerr << "  " << what << ": " << KPERF_STAGE_NAMES[s] << " active " << stages[s].active
+                 << ", expected " << want_active[s] << "\n";
+            bad++;
+        }
+        if (!stages[s].done_at) {
+            cerr << "  " << what << ": " << KPERF_STAGE_NAMES[s] << " never reported\n";
+            bad++;
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char** argv)
+{
+    vector<Image> images;
+    if (!load_test_images(argc, argv, images)) return 1;
+
+    int runs = 0, failed = 0;
+    for (auto& im : images)
+        for (int quant_en = 0; quant_en < 2; quant_en++) {
+            runs++;
+            failed += check(im, quant_en) != 0;
+        }
+
+    cout << "v12 cycle counters: " << runs - failed << " / " << runs
+         << " runs match v4 with the expected active counts\n";
+    cout << (failed ? "FAIL" : "PASS") << "\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+// C-simulation testbench for hls/v7_dct_accel.cpp.
+//
+// Lays every plane out block-major the way the host does for v7
+// (raster_to_tiles: blocks contiguous, partial edge blocks replicated),
+// runs v7 and v4 as C++ on the same image, with and without quantization,
+// and checks that v7's coefficients, taken back to raster order with
+// tiles_to_raster, match v4's. Each plane also goes through
+// raster_to_tiles and tiles_to_raster unchanged.
+//
+// Build (C simulation only, no kernel compile):
+//   make csim_tiled
+// Run:
+//   build/tb_v7_tiled [image.png ...]
+// Without arguments the synthetic set from tb_images.hpp is used.
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+namespace v7 {
+#include "v7_dct_accel.cpp"
+}
+// v4 also exports dct_accel
+#define dct_accel dct_accel_v4
+namespace v4 {
+#include "v4_dct_accel.cpp"
+}
+#undef dct_accel
+
+#include "jpeg_cpu.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "tb_images.hpp"
+#include "tiles.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+// One image through both kernels; returns the number of failures
+static long check(const Image& im, const vector<ap_uint<32>>& qwords, int quant_en)
+{
+    const int w = im.w, h = im.h;
+    const size_t n = size_t(w) * h;
+    const int nblocks = tiled_blocks_x(w) * tiled_blocks_y(h);
+    const size_t words = size_t(nblocks) * 8;
+
+    long bad = 0;
+    vector<v7::pix8_t> in[3];
+    vector<v7::coef8_t> out[3];
+    vector<v4::pixel_t> raster[3];
+    vector<v4::coeff_t> want[3];
+    for (int c = 0; c < 3; c++) {
+        vector<pixel_t> tiles, back;
+        raster_to_tiles(im.p[c], w, h, tiles);
+        tiles_to_raster(tiles, w, h, back);
+        if (back != im.p[c]) {
+            cerr << "  " << im.name << ": tiles_to_raster does not undo raster_to_tiles\n";
+            bad++;
+        }
+        in[c].resize(words);
+        for (size_t i = 0; i < words; i++)
+            for (int x = 0; x < 8; x++) in[c][i].range(8 * x + 7, 8 * x) = tiles[i * 8 + x];
+        out[c].resize(words);
+        raster[c].assign(im.p[c].begin(), im.p[c].end());
+        want[c].resize(n);
+    }
+
+    v7::dct_accel(in[0].data(), in[1].data(), in[2].data(),
+                  out[0].data(), out[1].data(), out[2].data(),
+                  qwords.data(), nblocks, quant_en);
+    v4::dct_accel_v4(raster[0].data(), raster[1].data(), raster[2].data(),
+                     want[0].data(), want[1].data(), want[2].data(),
+                     qwords.data(), w, h, quant_en);
+
+    long diff = 0;
+    for (int c = 0; c < 3; c++) {
+        vector<coeff_t> tiles(words * 8), got;
+        for (size_t i = 0; i < words; i++)
+            for (int x = 0; x < 8; x++)
+                tiles[i * 8 + x] = coeff_t(int(ap_int<16>(out[c][i].range(16 * x + 15, 16 * x))));
+        tiles_to_raster(tiles, w, h, got);
+        for (size_t i = 0; i < n; i++) diff += got[i] != coeff_t(int(want[c][i]));
+    }
+    if (diff)
+        cerr << "  " << im.name << " quant_en=" << quant_en << ": " << diff
+             << " coefficients differ from v4\n";
+    return bad + diff;
+}
+
+int main(int argc, char** argv)
+{
+    vector<Image> images;
+    if (!load_test_images(argc, argv, images)) return 1;
+
+    QuantTable qt[3];
+    quant_table_init(qt[0], Q_luma, 50);
+    quant_table_init(qt[1], Q_chroma, 50);
+    quant_table_init(qt[2], Q_chroma, 50);
+    vector<uint32_t> packed;
+    pack_quant_tables(qt, packed);
+    vector<ap_uint<32>> qwords(packed.begin(), packed.end());
+
+    int runs = 0, failed = 0;
+    for (auto& im : images)
+        for (int quant_en = 0; quant_en < 2; quant_en++) {
+            runs++;
+            failed += check(im, qwords, quant_en) != 0;
+        }
+
+    cout << "v7 tiled: " << runs - failed << " / " << runs << " runs match v4\n";
+    cout << (failed ? "FAIL" : "PASS") << "\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+// C-simulation testbench for hls/v8_dct_accel.cpp.
+//
+// Packs a batch of images of mixed sizes back to back into tiled buffers
+// with a descriptor table laid out as host/batch.hpp's batch_layout lays
+// it out, runs v8 once over the whole batch, with and without
+// quantization, and checks every image's coefficients against a v4 run
+// on that image alone. The batch also carries descriptors of zero blocks
+// (a 0 x 5 and a 7 x 0 image), first, in the middle and last: they must
+// take no blocks and write nothing, so the words past the batch's last
+// block stay as they were.
+//
+// Build (C simulation only, no kernel compile):
+//   make csim_batch
+// Run:
+//   build/tb_v8_batch [image.png ...]
+// Without arguments the synthetic set from tb_images.hpp is used.
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+namespace v8 {
+#include "v8_dct_accel.cpp"
+}
+// v4 also exports dct_accel
+#define dct_accel dct_accel_v4
+namespace v4 {
+#include "v4_dct_accel.cpp"
+}
+#undef dct_accel
+
+#include "jpeg_cpu.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "tb_images.hpp"
+#include "tiles.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+static const int GUARD_WORDS = 64;
+
+// The whole batch in one launch; returns the number of failures
+static int check(const vector<Image>& batch, const vector<ap_uint<32>>& qwords, int quant_en)
+{
+    // Descriptors { first block, width, height, 0 }, images back to back
+    vector<ap_uint<32>> desc(batch.size() * v8::DESC_WORDS, 0);
+    vector<size_t> first(batch.size());
+    size_t total = 0;
+    for (size_t n = 0; n < batch.size(); n++) {
+        first[n] = total;
+        desc[n * v8::DESC_WORDS + 0] = uint32_t(total);
+        desc[n * v8::DESC_WORDS + 1] = uint32_t(batch[n].w);
+        desc[n * v8::DESC_WORDS + 2] = uint32_t(batch[n].h);
+        total += size_t(tiled_blocks_x(batch[n].w)) * tiled_blocks_y(batch[n].h);
+    }
+    const size_t words = total * 8;
+
+    const v8::coef8_t guard = ~v8::coef8_t(0);
+    vector<v8::pix8_t> in[3];
+    vector<v8::coef8_t> out[3];
+    for (int c = 0; c < 3; c++) {
+        in[c].resize(words + GUARD_WORDS);
+        out[c].assign(words + GUARD_WORDS, guard);
+        for (size_t n = 0; n < batch.size(); n++) {
+            const Image& im = batch[n];
+            if (!im.w || !im.h) continue;
+            vector<pixel_t> tiles;
+            raster_to_tiles(im.p[c], im.w, im.h, tiles);
+            v8::pix8_t* dst = in[c].data() + first[n] * 8;
+            for (size_t i = 0; i < tiles.size() / 8; i++)
+                for (int x = 0; x < 8; x++) dst[i].range(8 * x + 7, 8 * x) = tiles[i * 8 + x];
+        }
+    }
+
+    v8::dct_accel(in[0].data(), in[1].data(), in[2].data(),
+                  out[0].data(), out[1].data(), out[2].data(),
+                  qwords.data(), desc.data(), int(batch.size()), int(total), quant_en);
+
+    int bad = 0;
+    for (int c = 0; c < 3; c++) {
+        for (size_t i = words; i < words + GUARD_WORDS; i++) {
+            if (out[c][i] != guard) {
+                cerr << "  quant_en=" << quant_en << ": channel " << c
+                     << " written past the batch's last block\n";
+                bad++;
+                break;
+            }
+        }
+    }
+    for (size_t n = 0; n < batch.size(); n++) {
+        const Image& im = batch[n];
+        if (!im.w || !im.h) continue;
+        const size_t np = size_t(im.w) * im.h;
+        vector<v4::pixel_t> raster[3];
+        vector<v4::coeff_t> want[3];
+        for (int c = 0; c < 3; c++) {
+            raster[c].assign(im.p[c].begin(), im.p[c].end());
+            want[c].resize(np);
+        }
+        v4::dct_accel_v4(raster[0].data(), raster[1].data(), raster[2].data(),
+                         want[0].data(), want[1].data(), want[2].data(),
+                         qwords.data(), im.w, im.h, quant_en);
+
+        long diff = 0;
+        for (int c = 0; c < 3; c++) {
+            const v8::coef8_t* src = out[c].data() + first[n] * 8;
+            vector<coeff_t> tiles(tiled_size(im.w, im.h)), got;
+            for (size_t i = 0; i < tiles.size() / 8; i++)
+                for (int x = 0; x < 8; x++)
+                    tiles[i * 8 + x] = coeff_t(int(ap_int<16>(src[i].range(16 * x + 15, 16 * x))));
+            tiles_to_raster(tiles, im.w, im.h, got);
+            for (size_t i = 0; i < np; i++) diff += got[i] != coeff_t(int(want[c][i]));
+        }
+        if (diff) {
+            cerr << "  " << im.name << " (batch entry " << n << ") quant_en=" << quant_en
+                 << ": " << diff << " coefficients differ from v4\n";
+            bad++;
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char** argv)
+{
+    vector<Image> images;
+    if (!load_test_images(argc, argv, images)) return 1;
+
+    // Zero-block entries at the start, in the middle and at the end
+    Image empty_w = { "0x5", 0, 5, {} };
+    Image empty_h = { "7x0", 7, 0, {} };
+    vector<Image> batch;
+    batch.push_back(empty_w);
+    for (size_t i = 0; i < images.size(); i++) {
+        batch.push_back(images[i]);
+        if (i == images.size() / 2) batch.push_back(empty_h);
+    }
+    batch.push_back(empty_w);
+
+    QuantTable qt[3];
+    quant_table_init(qt[0], Q_luma, 50);
+    quant_table_init(qt[1], Q_chroma, 50);
+    quant_table_init(qt[2], Q_chroma, 50);
+    vector<uint32_t> packed;
+    pack_quant_tables(qt, packed);
+    vector<ap_uint<32>> qwords(packed.begin(), packed.end());
+
+    int runs = 0, failed = 0;
+    for (int quant_en = 0; quant_en < 2; quant_en++) {
+        runs++;
+        failed += check(batch, qwords, quant_en) != 0;
+    }
+
+    cout << "v8 batch: " << runs - failed << " / " << runs << " launches of " << batch.size()
+         << " images match v4\n";
+    cout << (failed ? "FAIL" : "PASS") << "\n";
+    return failed ? 1 : 0;
+}
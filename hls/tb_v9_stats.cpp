@@ -0,0 +1,131 @@
+// C-simulation testbench for the v9 statistics stage.
+//
+// Runs hls/v9_dct_accel.cpp as C++ over a set of images, sizes and
+// quality levels, with and without on-kernel quantization, and checks
+// every word of its statistics buffer against the host's counts over the
+// kernel's own coefficient planes, counted with calculate_compression's
+// count_block (host/kernel_stats.hpp) plus huff_category of the DC
+// difference.
+//
+// Build (C simulation only, no kernel compile):
+//   make csim_stats
+// Run:
+//   build/tb_v9_stats [image.png ...]
+// Without arguments a synthetic set covers partial edge blocks, a single
+// block and sizes below one block.
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+namespace kernel {
+#include "v9_dct_accel.cpp"
+}
+
+#include "jpeg_cpu.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "tb_images.hpp"
+#include "huffman.hpp"
+#include "kernel_stats.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+static_assert(kernel::STATS_WORDS == KSTATS_WORDS, "kernel/host stats layout differ");
+static_assert(kernel::STATS_CH_WORDS == KSTATS_CH_WORDS, "kernel/host stats layout differ");
+
+// The host's counts for one coefficient plane
+static void host_counts(const vector<coeff_t>& coeffs, int w, int h, bool quantized,
+                        const QuantTable& qt, uint32_t out[KSTATS_CH_WORDS])
+{
+    std::fill(out, out + KSTATS_CH_WORDS, 0u);
+    BlockCounts counts;
+    vector<coeff_t> zz;
+    vector<std::pair<coeff_t,int>> rle;
+    int prev_dc = 0;
+    for (int by = 0; by < h; by += 8) {
+        for (int bx = 0; bx < w; bx += 8) {
+            count_block(coeffs.data(), w, h, bx, by, qt, quantized, zz, rle, counts);
+            out[3]++;
+            out[4 + huff_category(zz[0] - prev_dc)]++;
+            prev_dc = zz[0];
+        }
+    }
+    out[0] = uint32_t(counts.zero);
+    out[1] = uint32_t(counts.nonzero);
+    out[2] = uint32_t(counts.rle_pairs);
+}
+
+static const char* const WORD_NAMES[4] = { "zero", "nonzero", "rle_pairs", "blocks" };
+
+// One kernel run; returns the number of differing words
+static int check(const Image& im, int quality, int quant_en)
+{
+    const int w = im.w, h = im.h;
+    const size_t n = size_t(w) * h;
+    QuantTable qt[3];
+    quant_table_init(qt[0], Q_luma, quality);
+    quant_table_init(qt[1], Q_chroma, quality);
+    quant_table_init(qt[2], Q_chroma, quality);
+
+    vector<kernel::pixel_t> in[3];
+    vector<kernel::coeff_t> out[3];
+    for (int c = 0; c < 3; c++) {
+        in[c].assign(im.p[c].begin(), im.p[c].end());
+        out[c].resize(n);
+    }
+    vector<uint32_t> packed;
+    pack_quant_tables(qt, packed);
+    vector<ap_uint<32>> qwords(packed.begin(), packed.end());
+    ap_uint<32> stats[kernel::STATS_WORDS];
+
+    kernel::dct_accel(in[0].data(), in[1].data(), in[2].data(),
+                      out[0].data(), out[1].data(), out[2].data(),
+                      qwords.data(), w, h, quant_en, stats);
+
+    int bad = 0;
+    for (int c = 0; c < 3; c++) {
+        vector<coeff_t> plane(n);
+        for (size_t i = 0; i < n; i++) plane[i] = (coeff_t)(int)out[c][i];
+        uint32_t want[KSTATS_CH_WORDS];
+        host_counts(plane, w, h, quant_en != 0, qt[c], want);
+        for (int i = 0; i < KSTATS_CH_WORDS; i++) {
+            uint32_t got = (uint32_t)stats[c * KSTATS_CH_WORDS + i];
+            if (got == want[i]) continue;
+            if (bad++ < 8) {
+                cerr << "  " << im.name << " q" << quality << " quant_en=" << quant_en
+                     << " ch" << c << " ";
+                if (i < 4) cerr << WORD_NAMES[i];
+                else cerr << "dc_cat[" << i - 4 << "]";
+                cerr << ": kernel " << got << ", host " << want[i] << "\n";
+            }
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char** argv)
+{
+    vector<Image> images;
+    if (!load_test_images(argc, argv, images)) return 1;
+
+    const int qualities[] = { 10, 50, 90 };
+    int runs = 0, failed = 0;
+    for (auto& im : images)
+        for (int q : qualities)
+            for (int quant_en = 0; quant_en < 2; quant_en++) {
+                runs++;
+                failed += check(im, q, quant_en) != 0;
+            }
+
+    cout << "v9 statistics stage: " << runs - failed << " / " << runs << " runs match the host counts\n";
+    cout << (failed ? "FAIL" : "PASS") << "\n";
+    return failed ? 1 : 0;
+}
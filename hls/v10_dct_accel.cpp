@@ -0,0 +1,413 @@
+/******************************************************************************
+ * VERSION 10: ON-DEVICE ROUND TRIP (DCT -> Q -> DQ -> IDCT) WITH SSE
+ * Description: v4's loader and DCT, then quantize, dequantize and inverse
+ *              DCT per block, the way the host's quality check does it,
+ *              and accumulate each channel's squared error against the
+ *              source. A quality audit reads back three 64-bit sums
+ *              instead of every coefficient.
+ * Contract: out* receive the reconstructed pixels only when recon_en is
+ *           set (otherwise they are not touched and may be small); sse
+ *           gets 3 words, R G B, over the width x height pixels. qtab holds
+ *           RTAB_WORDS words (host: pack_roundtrip_tables).
+ ******************************************************************************/
+
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+typedef ap_uint<8>  pixel_t;
+typedef ap_int<16>  coeff_t;
+typedef ap_fixed<24,12> dct_t;
+// IDCT datapath: dequantized coefficients stay within +-1200 or so and
+// the row pass within +-10000, so 16 integer bits. The fraction bits
+// decide how often a pixel lands on the other side of a rounding step
+// from the host's double IDCT: with a 25-bit basis and 20-bit sums, about
+// one pixel in 10^5 or fewer (C simulation); 12-bit dct_t is near 1 in 200.
+typedef ap_fixed<36,16> idct_t;
+typedef ap_fixed<26,1> icoef_t;
+
+static const int N = 8;
+
+static const dct_t C[N][N] = {
+    {0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553},
+    {0.490393, 0.415735, 0.277785, 0.097545,-0.097545,-0.277785,-0.415735,-0.490393},
+    {0.461940, 0.191342,-0.191342,-0.461940,-0.461940,-0.191342, 0.191342, 0.461940},
+    {0.415735,-0.097545,-0.490393,-0.277785, 0.277785, 0.490393, 0.097545,-0.415735},
+    {0.353553,-0.353553,-0.353553, 0.353553, 0.353553,-0.353553,-0.353553, 0.353553},
+    {0.277785,-0.490393, 0.097545, 0.415735,-0.415735,-0.097545, 0.490393,-0.277785},
+    {0.191342,-0.461940, 0.461940,-0.191342,-0.191342, 0.461940,-0.461940, 0.191342},
+    {0.097545,-0.277785, 0.415735,-0.490393, 0.490393,-0.415735, 0.277785,-0.097545}
+};
+
+// Same basis (the host's C_d literals) at IDCT precision
+static const icoef_t CI[N][N] = {
+    {0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553},
+    {0.490393, 0.415735, 0.277785, 0.097545,-0.097545,-0.277785,-0.415735,-0.490393},
+    {0.461940, 0.191342,-0.191342,-0.461940,-0.461940,-0.191342, 0.191342, 0.461940},
+    {0.415735,-0.097545,-0.490393,-0.277785, 0.277785, 0.490393, 0.097545,-0.415735},
+    {0.353553,-0.353553,-0.353553, 0.353553, 0.353553,-0.353553,-0.353553, 0.353553},
+    {0.277785,-0.490393, 0.097545, 0.415735,-0.415735,-0.097545, 0.490393,-0.277785},
+    {0.191342,-0.461940, 0.461940,-0.191342,-0.191342, 0.461940,-0.461940, 0.191342},
+    {0.097545,-0.277785, 0.415735,-0.490393, 0.490393,-0.415735, 0.277785,-0.097545}
+};
+
+struct block_data {
+    pixel_t R[8][8];
+    pixel_t G[8][8];
+    pixel_t B[8][8];
+};
+
+struct coeff_data {
+    coeff_t R[8][8];
+    coeff_t G[8][8];
+    coeff_t B[8][8];
+};
+
+// v4's transform: out_blk[u][v] is vertical frequency u, horizontal v
+static void dct_2d(pixel_t in_blk[8][8], coeff_t out_blk[8][8])
+{
+#pragma HLS INLINE
+    dct_t tmp[8][8];
+#pragma HLS ARRAY_PARTITION variable=tmp complete dim=0
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int x = 0; x < 8; x++) {
+#pragma HLS UNROLL
+                acc += C[u][x] * (dct_t)((int)in_blk[x][v] - 128);
+            }
+            tmp[u][v] = acc;
+        }
+    }
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+                acc += tmp[u][y] * C[v][y];
+            }
+            int val = (int)hls::round(acc);
+            if (val < -32768) val = -32768;
+            if (val >  32767) val =  32767;
+            out_blk[u][v] = (coeff_t)val;
+        }
+    }
+}
+
+// v4's loader, also sending each block to the error stage
+static void load_blocks_df(
+    const pixel_t* inR,
+    const pixel_t* inG,
+    const pixel_t* inB,
+    hls::stream<block_data>& block_stream,
+    hls::stream<block_data>& orig_stream,
+    int width,
+    int height
+) {
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+            block_data blk;
+            
+            for (int i = 0; i < 64; i++) {
+#pragma HLS PIPELINE II=1
+                int y = i / 8;
+                int x = i % 8;
+                // Edge-replicate past the right/bottom border
+                int gx = bx + x;
+                int gy = by + y;
+                int sx = gx < width ? gx : width - 1;
+                int sy = gy < height ? gy : height - 1;
+                int idx = sy * width + sx;
+                blk.R[y][x] = inR[idx];
+                blk.G[y][x] = inG[idx];
+                blk.B[y][x] = inB[idx];
+            }
+            block_stream.write(blk);
+            orig_stream.write(blk);
+        }
+    }
+}
+
+// One block of each channel per iteration
+static void compute_dct_df(
+    hls::stream<block_data>& in_stream,
+    hls::stream<coeff_data>& out_stream,
+    int width,
+    int height
+) {
+    int num_blocks = ((height + 7) / 8) * ((width + 7) / 8);
+    
+    for (int i = 0; i < num_blocks; i++) {
+#pragma HLS PIPELINE II=1
+        block_data blk = in_stream.read();
+        coeff_data coef;
+        
+        dct_2d(blk.R, coef.R);
+        dct_2d(blk.G, coef.G);
+        dct_2d(blk.B, coef.B);
+        
+        out_stream.write(coef);
+    }
+}
+
+// Quant table entry as packed by the host: recip[15:0] corr[23:16] shift[28:24]
+// Table t covers channel t (0 = R/Y, 1 = G/Cb, 2 = B/Cr), 64 entries each,
+// indexed by block position y*8+x.
+// v10 appends the three tables' quant steps (q) for the dequantizer.
+static const int QTAB_WORDS = 3 * 64;
+static const int RTAB_WORDS = 2 * QTAB_WORDS;
+
+static void quant_2d(
+    coeff_t blk[8][8],
+    const ap_uint<16> recip[64],
+    const ap_uint<8>  corr[64],
+    const ap_uint<5>  shift[64]
+) {
+#pragma HLS INLINE
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            // blk[u][v] is stored at block position (y=v, x=u)
+            int i = v * 8 + u;
+            int val = blk[u][v];
+            ap_uint<17> a = val < 0 ? -val : val;
+            ap_uint<33> p = (a + corr[i]) * recip[i];
+            int q = (int)(p >> shift[i]);
+            blk[u][v] = (coeff_t)(val < 0 ? -q : q);
+        }
+    }
+}
+
+// Dequantize and inverse-transform one block, as the host's quality check
+// does it (jpeg_block_pipeline, host.cpp): coefficients past the
+// right/bottom edge are dropped, dequant_block saturates to 16 bits and
+// idct_block_cpu rounds and clamps to 0..255. The host indexes the block
+// as h[r][c] = blk[c][r]; out is in raster order like block_data.
+static void idct_2d(
+    const coeff_t blk[8][8],
+    const ap_uint<8> q[64],
+    int bx,
+    int by,
+    int width,
+    int height,
+    pixel_t out[8][8]
+) {
+#pragma HLS INLINE
+    idct_t dq[8][8];
+    idct_t tmp[8][8];
+#pragma HLS ARRAY_PARTITION variable=dq complete dim=0
+#pragma HLS ARRAY_PARTITION variable=tmp complete dim=0
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            // blk[u][v] is stored at block position (y=v, x=u)
+            int d = (bx + u < width && by + v < height) ? (int)blk[u][v] * (int)q[v * 8 + u] : 0;
+            if (d < -32768) d = -32768;
+            if (d >  32767) d =  32767;
+            dq[v][u] = d;
+        }
+    }
+
+    // tmp[y][u] = sum_v C[v][y] * h[u][v]
+    for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+        for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+            idct_t acc = 0;
+            for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+                acc += CI[v][y] * dq[u][v];
+            }
+            tmp[y][u] = acc;
+        }
+    }
+
+    // out[y][x] = sum_u C[u][x] * tmp[y][u] + 128
+    for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+        for (int x = 0; x < 8; x++) {
+#pragma HLS UNROLL
+            idct_t acc = 0;
+            for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+                acc += CI[u][x] * tmp[y][u];
+            }
+            int val = (int)hls::round(acc + idct_t(128));
+            if (val < 0)   val = 0;
+            if (val > 255) val = 255;
+            out[y][x] = (pixel_t)val;
+        }
+    }
+}
+
+// Quantize, then dequantize and inverse-transform: the whole lossy step
+// of the codec, block by block. Table words as packed by the host
+// (pack_roundtrip_tables): QTAB_WORDS quantizer entries, then the steps.
+static void roundtrip_blocks_df(
+    hls::stream<coeff_data>& in_stream,
+    hls::stream<block_data>& out_stream,
+    const ap_uint<32>* qtab,
+    int width,
+    int height
+) {
+    ap_uint<16> recip[3][64];
+    ap_uint<8>  corr[3][64];
+    ap_uint<5>  shift[3][64];
+    ap_uint<8>  step[3][64];
+#pragma HLS ARRAY_PARTITION variable=recip complete dim=0
+#pragma HLS ARRAY_PARTITION variable=corr complete dim=0
+#pragma HLS ARRAY_PARTITION variable=shift complete dim=0
+#pragma HLS ARRAY_PARTITION variable=step complete dim=0
+
+    for (int i = 0; i < QTAB_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+        ap_uint<32> e = qtab[i];
+        recip[i / 64][i % 64] = e.range(15, 0);
+        corr[i / 64][i % 64]  = e.range(23, 16);
+        shift[i / 64][i % 64] = e.range(28, 24);
+    }
+    for (int i = 0; i < QTAB_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+        step[i / 64][i % 64] = qtab[QTAB_WORDS + i].range(7, 0);
+    }
+
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+#pragma HLS PIPELINE II=1
+            coeff_data coef = in_stream.read();
+            block_data rec;
+            quant_2d(coef.R, recip[0], corr[0], shift[0]);
+            quant_2d(coef.G, recip[1], corr[1], shift[1]);
+            quant_2d(coef.B, recip[2], corr[2], shift[2]);
+            idct_2d(coef.R, step[0], bx, by, width, height, rec.R);
+            idct_2d(coef.G, step[1], bx, by, width, height, rec.G);
+            idct_2d(coef.B, step[2], bx, by, width, height, rec.B);
+            out_stream.write(rec);
+        }
+    }
+}
+
+// Squared error of one block against the source, pixels inside the image only
+static ap_uint<24> block_sse(
+    const pixel_t orig[8][8],
+    const pixel_t rec[8][8],
+    int bx,
+    int by,
+    int width,
+    int height
+) {
+#pragma HLS INLINE
+    ap_uint<24> sum = 0;
+    for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+        for (int x = 0; x < 8; x++) {
+#pragma HLS UNROLL
+            ap_int<9> d = (ap_int<9>)orig[y][x] - (ap_int<9>)rec[y][x];
+            if (bx + x < width && by + y < height) sum += (ap_uint<16>)(d * d);
+        }
+    }
+    return sum;
+}
+
+// Accumulate the per-channel SSE; with recon_en also store the pixels
+static void sse_store_df(
+    hls::stream<block_data>& rec_stream,
+    hls::stream<block_data>& orig_stream,
+    pixel_t* outR,
+    pixel_t* outG,
+    pixel_t* outB,
+    ap_uint<64>* sse,
+    int width,
+    int height,
+    int recon_en
+) {
+    ap_uint<64> acc[3] = {0, 0, 0};
+#pragma HLS ARRAY_PARTITION variable=acc complete
+
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+            block_data rec = rec_stream.read();
+            block_data orig = orig_stream.read();
+            acc[0] += block_sse(orig.R, rec.R, bx, by, width, height);
+            acc[1] += block_sse(orig.G, rec.G, bx, by, width, height);
+            acc[2] += block_sse(orig.B, rec.B, bx, by, width, height);
+
+            if (!recon_en) continue;
+            for (int i = 0; i < 64; i++) {
+#pragma HLS PIPELINE II=1
+                int y = i / 8;
+                int x = i % 8;
+                int gx = bx + x;
+                int gy = by + y;
+                if (gx < width && gy < height) {
+                    int idx = gy * width + gx;
+                    outR[idx] = rec.R[y][x];
+                    outG[idx] = rec.G[y][x];
+                    outB[idx] = rec.B[y][x];
+                }
+            }
+        }
+    }
+
+    for (int c = 0; c < 3; c++) {
+#pragma HLS PIPELINE II=1
+        sse[c] = acc[c];
+    }
+}
+
+extern "C" void dct_accel(
+    const pixel_t* inR,
+    const pixel_t* inG,
+    const pixel_t* inB,
+    pixel_t* outR,
+    pixel_t* outG,
+    pixel_t* outB,
+    const ap_uint<32>* qtab,
+    int width,
+    int height,
+    int recon_en,
+    ap_uint<64>* sse
+) {
+#pragma HLS INTERFACE m_axi port=inR offset=slave bundle=gmem0 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inG offset=slave bundle=gmem1 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inB offset=slave bundle=gmem2 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=outR offset=slave bundle=gmem3 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outG offset=slave bundle=gmem4 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outB offset=slave bundle=gmem5 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=qtab offset=slave bundle=gmem6 depth=384
+#pragma HLS INTERFACE m_axi port=sse offset=slave bundle=gmem7 depth=3
+#pragma HLS INTERFACE s_axilite port=width
+#pragma HLS INTERFACE s_axilite port=height
+#pragma HLS INTERFACE s_axilite port=recon_en
+#pragma HLS INTERFACE s_axilite port=return
+
+#pragma HLS DATAFLOW
+
+    hls::stream<block_data> block_stream("block_stream");
+#pragma HLS STREAM variable=block_stream depth=4
+
+    // Source blocks wait here while their reconstruction is computed
+    hls::stream<block_data> orig_stream("orig_stream");
+#pragma HLS STREAM variable=orig_stream depth=8
+
+    hls::stream<coeff_data> coeff_stream("coeff_stream");
+#pragma HLS STREAM variable=coeff_stream depth=4
+
+    hls::stream<block_data> rec_stream("rec_stream");
+#pragma HLS STREAM variable=rec_stream depth=4
+
+    load_blocks_df(inR, inG, inB, block_stream, orig_stream, width, height);
+    compute_dct_df(block_stream, coeff_stream, width, height);
+    roundtrip_blocks_df(coeff_stream, rec_stream, qtab, width, height);
+    sse_store_df(rec_stream, orig_stream, outR, outG, outB, sse, width, height, recon_en);
+}
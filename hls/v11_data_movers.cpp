@@ -0,0 +1,84 @@
+/******************************************************************************
+ * VERSION 11 DATA MOVERS
+ * Description: Memory <-> stream adapters for the free-running v11
+ *              dct_accel, for when it is used on its own rather than between
+ *              other stream kernels. dct_mm2s reads three block-major pixel
+ *              planes (v7's layout) as sequential bursts and sends them down
+ *              three AXI4-Streams, setting TLAST on the image's last beat.
+ *              dct_s2mm writes the three coefficient streams back the same
+ *              way. These two are the host's kernels; the transform runs
+ *              whenever beats reach it.
+ * Contract: num_blocks blocks per channel, 8 beats each. Compile each
+ *           kernel with -k from this file; hls/v11_connectivity.cfg wires
+ *           the streams.
+ ******************************************************************************/
+
+#include <ap_int.h>
+#include <ap_axi_sdata.h>
+#include <hls_stream.h>
+
+typedef ap_uint<64>  pix8_t;     // 8 pixels of one block row
+typedef ap_uint<128> coef8_t;    // 8 coefficients of one block row
+typedef ap_axiu<64,0,0,0>  pix_beat_t;
+typedef ap_axiu<128,0,0,0> coef_beat_t;
+
+extern "C" void dct_mm2s(
+    const pix8_t* inR,
+    const pix8_t* inG,
+    const pix8_t* inB,
+    hls::stream<pix_beat_t>& outR,
+    hls::stream<pix_beat_t>& outG,
+    hls::stream<pix_beat_t>& outB,
+    int num_blocks
+) {
+#pragma HLS INTERFACE m_axi port=inR offset=slave bundle=gmem0 depth=262144 max_read_burst_length=64
+#pragma HLS INTERFACE m_axi port=inG offset=slave bundle=gmem1 depth=262144 max_read_burst_length=64
+#pragma HLS INTERFACE m_axi port=inB offset=slave bundle=gmem2 depth=262144 max_read_burst_length=64
+#pragma HLS INTERFACE axis port=outR
+#pragma HLS INTERFACE axis port=outG
+#pragma HLS INTERFACE axis port=outB
+#pragma HLS INTERFACE s_axilite port=num_blocks
+#pragma HLS INTERFACE s_axilite port=return
+
+    const int beats = num_blocks * 8;
+    for (int i = 0; i < beats; i++) {
+#pragma HLS PIPELINE II=1
+        pix_beat_t r, g, b;
+        r.data = inR[i];
+        g.data = inG[i];
+        b.data = inB[i];
+        r.keep = g.keep = b.keep = -1;
+        r.strb = g.strb = b.strb = -1;
+        r.last = g.last = b.last = (i == beats - 1);
+        outR.write(r);
+        outG.write(g);
+        outB.write(b);
+    }
+}
+
+extern "C" void dct_s2mm(
+    hls::stream<coef_beat_t>& inR,
+    hls::stream<coef_beat_t>& inG,
+    hls::stream<coef_beat_t>& inB,
+    coef8_t* outR,
+    coef8_t* outG,
+    coef8_t* outB,
+    int num_blocks
+) {
+#pragma HLS INTERFACE axis port=inR
+#pragma HLS INTERFACE axis port=inG
+#pragma HLS INTERFACE axis port=inB
+#pragma HLS INTERFACE m_axi port=outR offset=slave bundle=gmem3 depth=262144 max_write_burst_length=64
+#pragma HLS INTERFACE m_axi port=outG offset=slave bundle=gmem4 depth=262144 max_write_burst_length=64
+#pragma HLS INTERFACE m_axi port=outB offset=slave bundle=gmem5 depth=262144 max_write_burst_length=64
+#pragma HLS INTERFACE s_axilite port=num_blocks
+#pragma HLS INTERFACE s_axilite port=return
+
+    const int beats = num_blocks * 8;
+    for (int i = 0; i < beats; i++) {
+#pragma HLS PIPELINE II=1
+        outR[i] = inR.read().data;
+        outG[i] = inG.read().data;
+        outB[i] = inB.read().data;
+    }
+}
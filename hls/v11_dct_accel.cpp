@@ -0,0 +1,194 @@
+/******************************************************************************
+ * VERSION 11: FREE-RUNNING AXI4-STREAM DCT
+ * Description: v7's block-major transform with AXI4-Stream ports instead of
+ *              m_axi bundles. Each channel arrives as 8 64-bit beats per
+ *              block (one block row each) and leaves as 8 128-bit beats.
+ *              There is no control interface (ap_ctrl_none): the kernel
+ *              transforms blocks as they arrive, so it can sit between other
+ *              stream kernels (color conversion before it, entropy coding
+ *              after it) without a round trip through device memory. Used
+ *              on its own it is fed by the dct_mm2s / dct_s2mm data movers
+ *              (hls/v11_data_movers.cpp) as wired in
+ *              hls/v11_connectivity.cfg.
+ * Contract: blocks in v7's layout (host/tiles.hpp), the three channels in
+ *           lockstep. TLAST on the last beat of an input block is passed to
+ *           the last beat of its coefficients. No quantization: a
+ *           free-running kernel has no table to load, so the host
+ *           quantizes.
+ ******************************************************************************/
+
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <ap_axi_sdata.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+typedef ap_uint<8>  pixel_t;
+typedef ap_int<16>  coeff_t;
+typedef ap_fixed<24,12> dct_t;
+typedef ap_axiu<64,0,0,0>  pix_beat_t;    // 8 pixels of one block row
+typedef ap_axiu<128,0,0,0> coef_beat_t;   // 8 coefficients of one block row
+
+static const int N = 8;
+
+static const dct_t C[N][N] = {
+    {0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553},
+    {0.490393, 0.415735, 0.277785, 0.097545,-0.097545,-0.277785,-0.415735,-0.490393},
+    {0.461940, 0.191342,-0.191342,-0.461940,-0.461940,-0.191342, 0.191342, 0.461940},
+    {0.415735,-0.097545,-0.490393,-0.277785, 0.277785, 0.490393, 0.097545,-0.415735},
+    {0.353553,-0.353553,-0.353553, 0.353553, 0.353553,-0.353553,-0.353553, 0.353553},
+    {0.277785,-0.490393, 0.097545, 0.415735,-0.415735,-0.097545, 0.490393,-0.277785},
+    {0.191342,-0.461940, 0.461940,-0.191342,-0.191342, 0.461940,-0.461940, 0.191342},
+    {0.097545,-0.277785, 0.415735,-0.490393, 0.490393,-0.415735, 0.277785,-0.097545}
+};
+
+struct block_data {
+    pixel_t R[8][8];
+    pixel_t G[8][8];
+    pixel_t B[8][8];
+};
+
+struct coeff_data {
+    coeff_t R[8][8];
+    coeff_t G[8][8];
+    coeff_t B[8][8];
+};
+
+// v4's transform: out_blk[u][v] is vertical frequency u, horizontal v
+static void dct_2d(pixel_t in_blk[8][8], coeff_t out_blk[8][8])
+{
+#pragma HLS INLINE
+    dct_t tmp[8][8];
+#pragma HLS ARRAY_PARTITION variable=tmp complete dim=0
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int x = 0; x < 8; x++) {
+#pragma HLS UNROLL
+                acc += C[u][x] * (dct_t)((int)in_blk[x][v] - 128);
+            }
+            tmp[u][v] = acc;
+        }
+    }
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+                acc += tmp[u][y] * C[v][y];
+            }
+            int val = (int)hls::round(acc);
+            if (val < -32768) val = -32768;
+            if (val >  32767) val =  32767;
+            out_blk[u][v] = (coeff_t)val;
+        }
+    }
+}
+
+// One block = 8 beats per channel. TLAST of the block's last beat goes
+// around the transform to the store.
+static void read_block_df(
+    hls::stream<pix_beat_t>& inR,
+    hls::stream<pix_beat_t>& inG,
+    hls::stream<pix_beat_t>& inB,
+    hls::stream<block_data>& block_stream,
+    hls::stream<bool>& last_stream
+) {
+    block_data blk;
+    bool last = false;
+    for (int y = 0; y < 8; y++) {
+#pragma HLS PIPELINE II=1
+        pix_beat_t r = inR.read();
+        pix_beat_t g = inG.read();
+        pix_beat_t b = inB.read();
+        for (int x = 0; x < 8; x++) {
+            blk.R[y][x] = r.data.range(8 * x + 7, 8 * x);
+            blk.G[y][x] = g.data.range(8 * x + 7, 8 * x);
+            blk.B[y][x] = b.data.range(8 * x + 7, 8 * x);
+        }
+        if (y == 7) last = r.last;
+    }
+    block_stream.write(blk);
+    last_stream.write(last);
+}
+
+static void compute_dct_df(
+    hls::stream<block_data>& in_stream,
+    hls::stream<coeff_data>& out_stream
+) {
+    block_data blk = in_stream.read();
+    coeff_data coef;
+
+    dct_2d(blk.R, coef.R);
+    dct_2d(blk.G, coef.G);
+    dct_2d(blk.B, coef.B);
+
+    out_stream.write(coef);
+}
+
+// Keeps v3's transposed [x][y] read of the coefficient blocks
+static void write_block_df(
+    hls::stream<coeff_data>& coeff_stream,
+    hls::stream<bool>& last_stream,
+    hls::stream<coef_beat_t>& outR,
+    hls::stream<coef_beat_t>& outG,
+    hls::stream<coef_beat_t>& outB
+) {
+    coeff_data coef = coeff_stream.read();
+    bool last = last_stream.read();
+    for (int y = 0; y < 8; y++) {
+#pragma HLS PIPELINE II=1
+        coef_beat_t r, g, b;
+        for (int x = 0; x < 8; x++) {
+            r.data.range(16 * x + 15, 16 * x) = coef.R[x][y];
+            g.data.range(16 * x + 15, 16 * x) = coef.G[x][y];
+            b.data.range(16 * x + 15, 16 * x) = coef.B[x][y];
+        }
+        r.keep = g.keep = b.keep = -1;
+        r.strb = g.strb = b.strb = -1;
+        r.last = g.last = b.last = (y == 7) && last;
+        outR.write(r);
+        outG.write(g);
+        outB.write(b);
+    }
+}
+
+// One block per channel per pass; free-running, so passes overlap as long
+// as beats keep coming
+extern "C" void dct_accel(
+    hls::stream<pix_beat_t>& inR,
+    hls::stream<pix_beat_t>& inG,
+    hls::stream<pix_beat_t>& inB,
+    hls::stream<coef_beat_t>& outR,
+    hls::stream<coef_beat_t>& outG,
+    hls::stream<coef_beat_t>& outB
+) {
+#pragma HLS INTERFACE axis port=inR
+#pragma HLS INTERFACE axis port=inG
+#pragma HLS INTERFACE axis port=inB
+#pragma HLS INTERFACE axis port=outR
+#pragma HLS INTERFACE axis port=outG
+#pragma HLS INTERFACE axis port=outB
+#pragma HLS INTERFACE ap_ctrl_none port=return
+
+#pragma HLS DATAFLOW
+
+    hls::stream<block_data> block_stream("block_stream");
+#pragma HLS STREAM variable=block_stream depth=2
+
+    hls::stream<bool> last_stream("last_stream");
+#pragma HLS STREAM variable=last_stream depth=4
+
+    hls::stream<coeff_data> coeff_stream("coeff_stream");
+#pragma HLS STREAM variable=coeff_stream depth=2
+
+    read_block_df(inR, inG, inB, block_stream, last_stream);
+    compute_dct_df(block_stream, coeff_stream);
+    write_block_df(coeff_stream, last_stream, outR, outG, outB);
+}
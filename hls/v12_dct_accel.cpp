@@ -0,0 +1,380 @@
+/******************************************************************************
+ * VERSION 12: v4 DATAFLOW WITH PER-STAGE CYCLE COUNTERS
+ * Description: v4's load -> DCT -> quantize -> store dataflow, instrumented
+ *              so the host can see which stage limits it. Each stage counts
+ *              its active cycles and the cycles it spent waiting on an
+ *              empty input stream or a full output stream, and reports
+ *              them when it finishes. A timer process next to the stages
+ *              counts cycles from the start of the kernel and stamps when
+ *              each report arrives. Whatever a stage's finish time leaves
+ *              after active and stream-stall cycles is memory wait (load,
+ *              store) or pipeline fill.
+ * Contract: same arguments as v4 plus `perf` (PERF_WORDS words, see
+ *           host/kernel_perf.hpp). Coefficients are identical to v4.
+ ******************************************************************************/
+
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+typedef ap_uint<8>  pixel_t;
+typedef ap_int<16>  coeff_t;
+typedef ap_fixed<24,12> dct_t;
+
+static const int N = 8;
+
+static const dct_t C[N][N] = {
+    {0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553},
+    {0.490393, 0.415735, 0.277785, 0.097545,-0.097545,-0.277785,-0.415735,-0.490393},
+    {0.461940, 0.191342,-0.191342,-0.461940,-0.461940,-0.191342, 0.191342, 0.461940},
+    {0.415735,-0.097545,-0.490393,-0.277785, 0.277785, 0.490393, 0.097545,-0.415735},
+    {0.353553,-0.353553,-0.353553, 0.353553, 0.353553,-0.353553,-0.353553, 0.353553},
+    {0.277785,-0.490393, 0.097545, 0.415735,-0.415735,-0.097545, 0.490393,-0.277785},
+    {0.191342,-0.461940, 0.461940,-0.191342,-0.191342, 0.461940,-0.461940, 0.191342},
+    {0.097545,-0.277785, 0.415735,-0.490393, 0.490393,-0.415735, 0.277785,-0.097545}
+};
+
+struct block_data {
+    pixel_t R[8][8];
+    pixel_t G[8][8];
+    pixel_t B[8][8];
+};
+
+struct coeff_data {
+    coeff_t R[8][8];
+    coeff_t G[8][8];
+    coeff_t B[8][8];
+};
+
+// v4's transform: out_blk[u][v] is vertical frequency u, horizontal v
+static void dct_2d(pixel_t in_blk[8][8], coeff_t out_blk[8][8])
+{
+#pragma HLS INLINE
+    dct_t tmp[8][8];
+#pragma HLS ARRAY_PARTITION variable=tmp complete dim=0
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int x = 0; x < 8; x++) {
+#pragma HLS UNROLL
+                acc += C[u][x] * (dct_t)((int)in_blk[x][v] - 128);
+            }
+            tmp[u][v] = acc;
+        }
+    }
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+                acc += tmp[u][y] * C[v][y];
+            }
+            int val = (int)hls::round(acc);
+            if (val < -32768) val = -32768;
+            if (val >  32767) val =  32767;
+            out_blk[u][v] = (coeff_t)val;
+        }
+    }
+}
+
+// Stage counters, reported once when the stage finishes. Stream stalls
+// are counted by polling (empty()/full()) in II=1 loops, one count per
+// cycle; a burst the memory is slow to serve stalls the whole pipeline
+// and shows up in none of them.
+struct stage_perf {
+    ap_uint<32> active;
+    ap_uint<32> in_stall;
+    ap_uint<32> out_stall;
+};
+
+// v4's load; waits for room in block_stream instead of blocking on it
+static void load_blocks_df(
+    const pixel_t* inR,
+    const pixel_t* inG,
+    const pixel_t* inB,
+    hls::stream<block_data>& block_stream,
+    hls::stream<stage_perf>& perf_stream,
+    int width,
+    int height
+) {
+    stage_perf perf = { 0, 0, 0 };
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+            block_data blk;
+
+            for (int i = 0; i < 64; i++) {
+#pragma HLS PIPELINE II=1
+                int y = i / 8;
+                int x = i % 8;
+                // Edge-replicate past the right/bottom border
+                int gx = bx + x;
+                int gy = by + y;
+                int sx = gx < width ? gx : width - 1;
+                int sy = gy < height ? gy : height - 1;
+                int idx = sy * width + sx;
+                blk.R[y][x] = inR[idx];
+                blk.G[y][x] = inG[idx];
+                blk.B[y][x] = inB[idx];
+            }
+            perf.active += 64;
+
+            while (block_stream.full()) {
+#pragma HLS PIPELINE II=1
+                perf.out_stall++;
+            }
+            block_stream.write(blk);
+        }
+    }
+    perf_stream.write(perf);
+}
+
+// v4's DCT as a polling loop: one block per active cycle
+static void compute_dct_df(
+    hls::stream<block_data>& in_stream,
+    hls::stream<coeff_data>& out_stream,
+    hls::stream<stage_perf>& perf_stream,
+    int width,
+    int height
+) {
+    int num_blocks = ((height + 7) / 8) * ((width + 7) / 8);
+    stage_perf perf = { 0, 0, 0 };
+
+    for (int i = 0; i < num_blocks; ) {
+#pragma HLS PIPELINE II=1
+        if (in_stream.empty()) {
+            perf.in_stall++;
+        } else if (out_stream.full()) {
+            perf.out_stall++;
+        } else {
+            block_data blk = in_stream.read();
+            coeff_data coef;
+
+            dct_2d(blk.R, coef.R);
+            dct_2d(blk.G, coef.G);
+            dct_2d(blk.B, coef.B);
+
+            out_stream.write(coef);
+            perf.active++;
+            i++;
+        }
+    }
+    perf_stream.write(perf);
+}
+
+// Quant table entry as packed by the host: recip[15:0] corr[23:16] shift[28:24]
+// Table t covers channel t (0 = R/Y, 1 = G/Cb, 2 = B/Cr), 64 entries each,
+// indexed by block position y*8+x.
+static const int QTAB_WORDS = 3 * 64;
+
+static void quant_2d(
+    coeff_t blk[8][8],
+    const ap_uint<16> recip[64],
+    const ap_uint<8>  corr[64],
+    const ap_uint<5>  shift[64]
+) {
+#pragma HLS INLINE
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            // blk[u][v] is stored at block position (y=v, x=u)
+            int i = v * 8 + u;
+            int val = blk[u][v];
+            ap_uint<17> a = val < 0 ? -val : val;
+            ap_uint<33> p = (a + corr[i]) * recip[i];
+            int q = (int)(p >> shift[i]);
+            blk[u][v] = (coeff_t)(val < 0 ? -q : q);
+        }
+    }
+}
+
+static void quant_blocks_df(
+    hls::stream<coeff_data>& in_stream,
+    hls::stream<coeff_data>& out_stream,
+    hls::stream<stage_perf>& perf_stream,
+    const ap_uint<32>* qtab,
+    int quant_en,
+    int width,
+    int height
+) {
+    ap_uint<16> recip[3][64];
+    ap_uint<8>  corr[3][64];
+    ap_uint<5>  shift[3][64];
+#pragma HLS ARRAY_PARTITION variable=recip complete dim=0
+#pragma HLS ARRAY_PARTITION variable=corr complete dim=0
+#pragma HLS ARRAY_PARTITION variable=shift complete dim=0
+
+    for (int i = 0; i < QTAB_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+        ap_uint<32> e = qtab[i];
+        recip[i / 64][i % 64] = e.range(15, 0);
+        corr[i / 64][i % 64]  = e.range(23, 16);
+        shift[i / 64][i % 64] = e.range(28, 24);
+    }
+
+    int num_blocks = ((height + 7) / 8) * ((width + 7) / 8);
+    stage_perf perf = { 0, 0, 0 };
+
+    for (int i = 0; i < num_blocks; ) {
+#pragma HLS PIPELINE II=1
+        if (in_stream.empty()) {
+            perf.in_stall++;
+        } else if (out_stream.full()) {
+            perf.out_stall++;
+        } else {
+            coeff_data coef = in_stream.read();
+            if (quant_en) {
+                quant_2d(coef.R, recip[0], corr[0], shift[0]);
+                quant_2d(coef.G, recip[1], corr[1], shift[1]);
+                quant_2d(coef.B, recip[2], corr[2], shift[2]);
+            }
+            out_stream.write(coef);
+            perf.active++;
+            i++;
+        }
+    }
+    perf_stream.write(perf);
+}
+
+// v4's store; waits for a block instead of blocking on the stream
+static void store_blocks_df(
+    hls::stream<coeff_data>& coeff_stream,
+    hls::stream<stage_perf>& perf_stream,
+    coeff_t* outR,
+    coeff_t* outG,
+    coeff_t* outB,
+    int width,
+    int height
+) {
+    stage_perf perf = { 0, 0, 0 };
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+            while (coeff_stream.empty()) {
+#pragma HLS PIPELINE II=1
+                perf.in_stall++;
+            }
+            coeff_data coef = coeff_stream.read();
+
+            // Transposed, as v4 stores it
+            for (int i = 0; i < 64; i++) {
+#pragma HLS PIPELINE II=1
+                int y = i / 8;
+                int x = i % 8;
+                int gx = bx + x;
+                int gy = by + y;
+                if (gx < width && gy < height) {
+                    int idx = gy * width + gx;
+                    outR[idx] = coef.R[x][y];
+                    outG[idx] = coef.G[x][y];
+                    outB[idx] = coef.B[x][y];
+                }
+            }
+            perf.active += 64;
+        }
+    }
+    perf_stream.write(perf);
+}
+
+// Stage order in the perf buffer and its layout, PERF_STAGE_WORDS 32-bit
+// words per stage (host/kernel_perf.hpp):
+//   [0] cycle the stage finished  [1] active  [2] input stall
+//   [3] output stall
+static const int PERF_STAGES = 4;
+static const int PERF_STAGE_WORDS = 4;
+static const int PERF_WORDS = PERF_STAGES * PERF_STAGE_WORDS;
+
+// Counts cycles from the start of the kernel until every stage has
+// reported, stamping each report as it arrives
+static void timer_df(
+    hls::stream<stage_perf>& load_perf,
+    hls::stream<stage_perf>& dct_perf,
+    hls::stream<stage_perf>& quant_perf,
+    hls::stream<stage_perf>& store_perf,
+    ap_uint<32>* perf
+) {
+    stage_perf p[PERF_STAGES];
+    ap_uint<32> done_at[PERF_STAGES] = { 0, 0, 0, 0 };
+    bool done[PERF_STAGES] = { false, false, false, false };
+#pragma HLS ARRAY_PARTITION variable=p complete
+#pragma HLS ARRAY_PARTITION variable=done_at complete
+#pragma HLS ARRAY_PARTITION variable=done complete
+    ap_uint<32> cycle = 0;
+    int reported = 0;
+
+    while (reported < PERF_STAGES) {
+#pragma HLS PIPELINE II=1
+        cycle++;
+        if (!done[0] && load_perf.read_nb(p[0]))  { done[0] = true; done_at[0] = cycle; reported++; }
+        if (!done[1] && dct_perf.read_nb(p[1]))   { done[1] = true; done_at[1] = cycle; reported++; }
+        if (!done[2] && quant_perf.read_nb(p[2])) { done[2] = true; done_at[2] = cycle; reported++; }
+        if (!done[3] && store_perf.read_nb(p[3])) { done[3] = true; done_at[3] = cycle; reported++; }
+    }
+
+    for (int s = 0; s < PERF_STAGES; s++) {
+#pragma HLS PIPELINE II=4
+        perf[s * PERF_STAGE_WORDS + 0] = done_at[s];
+        perf[s * PERF_STAGE_WORDS + 1] = p[s].active;
+        perf[s * PERF_STAGE_WORDS + 2] = p[s].in_stall;
+        perf[s * PERF_STAGE_WORDS + 3] = p[s].out_stall;
+    }
+}
+
+extern "C" void dct_accel(
+    const pixel_t* inR,
+    const pixel_t* inG,
+    const pixel_t* inB,
+    coeff_t* outR,
+    coeff_t* outG,
+    coeff_t* outB,
+    const ap_uint<32>* qtab,
+    int width,
+    int height,
+    int quant_en,
+    ap_uint<32>* perf
+) {
+#pragma HLS INTERFACE m_axi port=inR offset=slave bundle=gmem0 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inG offset=slave bundle=gmem1 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inB offset=slave bundle=gmem2 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=outR offset=slave bundle=gmem3 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outG offset=slave bundle=gmem4 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outB offset=slave bundle=gmem5 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=qtab offset=slave bundle=gmem6 depth=192
+#pragma HLS INTERFACE m_axi port=perf offset=slave bundle=gmem7 depth=16
+#pragma HLS INTERFACE s_axilite port=width
+#pragma HLS INTERFACE s_axilite port=height
+#pragma HLS INTERFACE s_axilite port=quant_en
+#pragma HLS INTERFACE s_axilite port=return
+
+#pragma HLS DATAFLOW
+
+    hls::stream<block_data> block_stream("block_stream");
+#pragma HLS STREAM variable=block_stream depth=4
+
+    hls::stream<coeff_data> coeff_stream("coeff_stream");
+#pragma HLS STREAM variable=coeff_stream depth=4
+
+    hls::stream<coeff_data> quant_stream("quant_stream");
+#pragma HLS STREAM variable=quant_stream depth=4
+
+    hls::stream<stage_perf> load_perf("load_perf");
+    hls::stream<stage_perf> dct_perf("dct_perf");
+    hls::stream<stage_perf> quant_perf("quant_perf");
+    hls::stream<stage_perf> store_perf("store_perf");
+#pragma HLS STREAM variable=load_perf depth=1
+#pragma HLS STREAM variable=dct_perf depth=1
+#pragma HLS STREAM variable=quant_perf depth=1
+#pragma HLS STREAM variable=store_perf depth=1
+
+    load_blocks_df(inR, inG, inB, block_stream, load_perf, width, height);
+    compute_dct_df(block_stream, coeff_stream, dct_perf, width, height);
+    quant_blocks_df(coeff_stream, quant_stream, quant_perf, qtab, quant_en, width, height);
+    store_blocks_df(quant_stream, store_perf, outR, outG, outB, width, height);
+    timer_df(load_perf, dct_perf, quant_perf, store_perf, perf);
+}
@@ -87,17 +87,14 @@ extern "C" void dct_accel(
             // Load block
             for (int y = 0; y < 8; y++) {
                 for (int x = 0; x < 8; x++) {
+                    // Edge-replicate past the right/bottom border
                     int gx = bx + x;
                     int gy = by + y;
-                    if (gx < width && gy < height) {
-                        R_blk[y][x] = inR[gy * width + gx];
-                        G_blk[y][x] = inG[gy * width + gx];
-                        B_blk[y][x] = inB[gy * width + gx];
-                    } else {
-                        R_blk[y][x] = 0;
-                        G_blk[y][x] = 0;
-                        B_blk[y][x] = 0;
-                    }
+                    int sx = gx < width ? gx : width - 1;
+                    int sy = gy < height ? gy : height - 1;
+                    R_blk[y][x] = inR[sy * width + sx];
+                    G_blk[y][x] = inG[sy * width + sx];
+                    B_blk[y][x] = inB[sy * width + sx];
                 }
             }
 
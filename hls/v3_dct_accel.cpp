@@ -93,18 +93,15 @@ static void load_blocks_df(
 #pragma HLS PIPELINE II=1
                 int y = i / 8;
                 int x = i % 8;
+                // Edge-replicate past the right/bottom border
                 int gx = bx + x;
                 int gy = by + y;
-                if (gx < width && gy < height) {
-                    int idx = gy * width + gx;
-                    blk.R[y][x] = inR[idx];
-                    blk.G[y][x] = inG[idx];
-                    blk.B[y][x] = inB[idx];
-                } else {
-                    blk.R[y][x] = (pixel_t)0;
-                    blk.G[y][x] = (pixel_t)0;
-                    blk.B[y][x] = (pixel_t)0;
-                }
+                int sx = gx < width ? gx : width - 1;
+                int sy = gy < height ? gy : height - 1;
+                int idx = sy * width + sx;
+                blk.R[y][x] = inR[idx];
+                blk.G[y][x] = inG[idx];
+                blk.B[y][x] = inB[idx];
             }
             block_stream.write(blk);
         }
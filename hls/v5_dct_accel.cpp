@@ -0,0 +1,320 @@
+/******************************************************************************
+ * VERSION 5: v4 DATAFLOW WITH ON-KERNEL RGB -> YCbCr 4:2:0
+ * Description: Loads 16x16 MCUs of RGB, converts to YCbCr (JFIF, 16-bit fixed
+ *              point), averages chroma 2x2 and runs 6 DCTs per MCU (4 Y, Cb,
+ *              Cr) instead of 12. Quantizer stage as in v4.
+ * Outputs: outY is width x height, outCb/outCr are ceil(w/2) x ceil(h/2)
+ ******************************************************************************/
+
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+typedef ap_uint<8>  pixel_t;
+typedef ap_int<16>  coeff_t;
+typedef ap_fixed<24,12> dct_t;
+
+static const int N = 8;
+
+static const dct_t C[N][N] = {
+    {0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553},
+    {0.490393, 0.415735, 0.277785, 0.097545,-0.097545,-0.277785,-0.415735,-0.490393},
+    {0.461940, 0.191342,-0.191342,-0.461940,-0.461940,-0.191342, 0.191342, 0.461940},
+    {0.415735,-0.097545,-0.490393,-0.277785, 0.277785, 0.490393, 0.097545,-0.415735},
+    {0.353553,-0.353553,-0.353553, 0.353553, 0.353553,-0.353553,-0.353553, 0.353553},
+    {0.277785,-0.490393, 0.097545, 0.415735,-0.415735,-0.097545, 0.490393,-0.277785},
+    {0.191342,-0.461940, 0.461940,-0.191342,-0.191342, 0.461940,-0.461940, 0.191342},
+    {0.097545,-0.277785, 0.415735,-0.490393, 0.490393,-0.415735, 0.277785,-0.097545}
+};
+
+// One 16x16 MCU: Y blocks in raster order (0 1 / 2 3), then Cb and Cr
+struct mcu_data {
+    pixel_t Y[4][8][8];
+    pixel_t Cb[8][8];
+    pixel_t Cr[8][8];
+};
+
+struct mcu_coeff {
+    coeff_t Y[4][8][8];
+    coeff_t Cb[8][8];
+    coeff_t Cr[8][8];
+};
+
+// v4's transform: out_blk[u][v] is vertical frequency u, horizontal v
+static void dct_2d(pixel_t in_blk[8][8], coeff_t out_blk[8][8])
+{
+#pragma HLS INLINE
+    dct_t tmp[8][8];
+#pragma HLS ARRAY_PARTITION variable=tmp complete dim=0
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int x = 0; x < 8; x++) {
+#pragma HLS UNROLL
+                acc += C[u][x] * (dct_t)((int)in_blk[x][v] - 128);
+            }
+            tmp[u][v] = acc;
+        }
+    }
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+                acc += tmp[u][y] * C[v][y];
+            }
+            int val = (int)hls::round(acc);
+            if (val < -32768) val = -32768;
+            if (val >  32767) val =  32767;
+            out_blk[u][v] = (coeff_t)val;
+        }
+    }
+}
+
+// Same arithmetic as the host's rgb_to_ycc420. Pixels past the right/bottom
+// edge replicate the last column/row, which also covers Y padding; chroma
+// samples past the chroma plane repeat its last column/row, matching the
+// CPU golden's edge replication of the Cb/Cr planes
+static void load_mcus_df(
+    const pixel_t* inR,
+    const pixel_t* inG,
+    const pixel_t* inB,
+    hls::stream<mcu_data>& mcu_stream,
+    int width,
+    int height
+) {
+    int cw = (width + 1) / 2;
+    int ch = (height + 1) / 2;
+
+    for (int my = 0; my < height; my += 16) {
+        for (int mx = 0; mx < width; mx += 16) {
+            mcu_data mcu;
+            pixel_t cb[8][8], cr[8][8];
+#pragma HLS ARRAY_PARTITION variable=cb complete dim=0
+#pragma HLS ARRAY_PARTITION variable=cr complete dim=0
+
+            // One chroma sample (2x2 pixels) per iteration
+            for (int i = 0; i < 64; i++) {
+#pragma HLS PIPELINE II=4
+                int cy = i / 8;
+                int cx = i % 8;
+                int cb_sum = 0;
+                int cr_sum = 0;
+
+                for (int k = 0; k < 4; k++) {
+#pragma HLS UNROLL
+                    int py = 2 * cy + k / 2;
+                    int px = 2 * cx + k % 2;
+                    int gx = mx + px;
+                    int gy = my + py;
+                    int sx = gx < width ? gx : width - 1;
+                    int sy = gy < height ? gy : height - 1;
+                    int idx = sy * width + sx;
+                    int r = inR[idx];
+                    int g = inG[idx];
+                    int b = inB[idx];
+
+                    int y = (19595 * r + 38470 * g + 7471 * b + 32768) >> 16;
+                    cb_sum += (-11059 * r - 21709 * g + 32768 * b + (128 << 16) + 32767) >> 16;
+                    cr_sum += (32768 * r - 27439 * g - 5329 * b + (128 << 16) + 32767) >> 16;
+
+                    mcu.Y[(py / 8) * 2 + px / 8][py % 8][px % 8] = (pixel_t)y;
+                }
+
+                cb[cy][cx] = (pixel_t)((cb_sum + 2) >> 2);
+                cr[cy][cx] = (pixel_t)((cr_sum + 2) >> 2);
+            }
+
+            // Valid chroma columns/rows in this block (at least 1)
+            int nx = cw - mx / 2;
+            int ny = ch - my / 2;
+            for (int i = 0; i < 64; i++) {
+#pragma HLS UNROLL
+                int cy = i / 8;
+                int cx = i % 8;
+                int sx = cx < nx ? cx : nx - 1;
+                int sy = cy < ny ? cy : ny - 1;
+                mcu.Cb[cy][cx] = cb[sy][sx];
+                mcu.Cr[cy][cx] = cr[sy][sx];
+            }
+            mcu_stream.write(mcu);
+        }
+    }
+}
+
+static void compute_dct_df(
+    hls::stream<mcu_data>& in_stream,
+    hls::stream<mcu_coeff>& out_stream,
+    int width,
+    int height
+) {
+    int num_mcus = ((height + 15) / 16) * ((width + 15) / 16);
+
+    for (int i = 0; i < num_mcus; i++) {
+#pragma HLS PIPELINE II=1
+        mcu_data mcu = in_stream.read();
+        mcu_coeff coef;
+
+        for (int k = 0; k < 4; k++) {
+#pragma HLS UNROLL
+            dct_2d(mcu.Y[k], coef.Y[k]);
+        }
+        dct_2d(mcu.Cb, coef.Cb);
+        dct_2d(mcu.Cr, coef.Cr);
+
+        out_stream.write(coef);
+    }
+}
+
+// Quant table entry as packed by the host: recip[15:0] corr[23:16] shift[28:24]
+// Table t covers channel t (0 = Y, 1 = Cb, 2 = Cr), 64 entries each,
+// indexed by block position y*8+x.
+static const int QTAB_WORDS = 3 * 64;
+
+static void quant_2d(
+    coeff_t blk[8][8],
+    const ap_uint<16> recip[64],
+    const ap_uint<8>  corr[64],
+    const ap_uint<5>  shift[64]
+) {
+#pragma HLS INLINE
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            // blk[u][v] is stored at block position (y=v, x=u)
+            int i = v * 8 + u;
+            int val = blk[u][v];
+            ap_uint<17> a = val < 0 ? -val : val;
+            ap_uint<33> p = (a + corr[i]) * recip[i];
+            int q = (int)(p >> shift[i]);
+            blk[u][v] = (coeff_t)(val < 0 ? -q : q);
+        }
+    }
+}
+
+static void quant_blocks_df(
+    hls::stream<mcu_coeff>& in_stream,
+    hls::stream<mcu_coeff>& out_stream,
+    const ap_uint<32>* qtab,
+    int quant_en,
+    int width,
+    int height
+) {
+    ap_uint<16> recip[3][64];
+    ap_uint<8>  corr[3][64];
+    ap_uint<5>  shift[3][64];
+#pragma HLS ARRAY_PARTITION variable=recip complete dim=0
+#pragma HLS ARRAY_PARTITION variable=corr complete dim=0
+#pragma HLS ARRAY_PARTITION variable=shift complete dim=0
+
+    for (int i = 0; i < QTAB_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+        ap_uint<32> e = qtab[i];
+        recip[i / 64][i % 64] = e.range(15, 0);
+        corr[i / 64][i % 64]  = e.range(23, 16);
+        shift[i / 64][i % 64] = e.range(28, 24);
+    }
+
+    int num_mcus = ((height + 15) / 16) * ((width + 15) / 16);
+
+    for (int i = 0; i < num_mcus; i++) {
+#pragma HLS PIPELINE II=1
+        mcu_coeff coef = in_stream.read();
+        if (quant_en) {
+            for (int k = 0; k < 4; k++) {
+#pragma HLS UNROLL
+                quant_2d(coef.Y[k], recip[0], corr[0], shift[0]);
+            }
+            quant_2d(coef.Cb, recip[1], corr[1], shift[1]);
+            quant_2d(coef.Cr, recip[2], corr[2], shift[2]);
+        }
+        out_stream.write(coef);
+    }
+}
+
+// Keeps v3's transposed [x][y] read of the coefficient blocks
+static void store_mcus_df(
+    hls::stream<mcu_coeff>& coeff_stream,
+    coeff_t* outY,
+    coeff_t* outCb,
+    coeff_t* outCr,
+    int width,
+    int height
+) {
+    int cw = (width + 1) / 2;
+    int ch = (height + 1) / 2;
+
+    for (int my = 0; my < height; my += 16) {
+        for (int mx = 0; mx < width; mx += 16) {
+            mcu_coeff coef = coeff_stream.read();
+
+            // 4 Y blocks; the chroma blocks ride along with the first one
+            for (int i = 0; i < 256; i++) {
+#pragma HLS PIPELINE II=1
+                int k = i / 64;
+                int y = (i % 64) / 8;
+                int x = i % 8;
+                int gx = mx + (k % 2) * 8 + x;
+                int gy = my + (k / 2) * 8 + y;
+                if (gx < width && gy < height)
+                    outY[gy * width + gx] = coef.Y[k][x][y];
+
+                int cx = mx / 2 + x;
+                int cy = my / 2 + y;
+                if (k == 0 && cx < cw && cy < ch) {
+                    outCb[cy * cw + cx] = coef.Cb[x][y];
+                    outCr[cy * cw + cx] = coef.Cr[x][y];
+                }
+            }
+        }
+    }
+}
+
+extern "C" void dct_accel(
+    const pixel_t* inR,
+    const pixel_t* inG,
+    const pixel_t* inB,
+    coeff_t* outY,
+    coeff_t* outCb,
+    coeff_t* outCr,
+    const ap_uint<32>* qtab,
+    int width,
+    int height,
+    int quant_en
+) {
+#pragma HLS INTERFACE m_axi port=inR offset=slave bundle=gmem0 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inG offset=slave bundle=gmem1 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inB offset=slave bundle=gmem2 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=outY offset=slave bundle=gmem3 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outCb offset=slave bundle=gmem4 depth=518400 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outCr offset=slave bundle=gmem5 depth=518400 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=qtab offset=slave bundle=gmem6 depth=192
+#pragma HLS INTERFACE s_axilite port=width
+#pragma HLS INTERFACE s_axilite port=height
+#pragma HLS INTERFACE s_axilite port=quant_en
+#pragma HLS INTERFACE s_axilite port=return
+
+#pragma HLS DATAFLOW
+
+    hls::stream<mcu_data> mcu_stream("mcu_stream");
+#pragma HLS STREAM variable=mcu_stream depth=4
+
+    hls::stream<mcu_coeff> coeff_stream("coeff_stream");
+#pragma HLS STREAM variable=coeff_stream depth=4
+
+    hls::stream<mcu_coeff> quant_stream("quant_stream");
+#pragma HLS STREAM variable=quant_stream depth=4
+
+    load_mcus_df(inR, inG, inB, mcu_stream, width, height);
+    compute_dct_df(mcu_stream, coeff_stream, width, height);
+    quant_blocks_df(coeff_stream, quant_stream, qtab, quant_en, width, height);
+    store_mcus_df(quant_stream, outY, outCb, outCr, width, height);
+}
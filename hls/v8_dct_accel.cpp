@@ -0,0 +1,294 @@
+/******************************************************************************
+ * VERSION 8: v7 TILED DATAFLOW OVER A BATCH OF IMAGES
+ * Description: One launch transforms a whole batch of (small) images held
+ *              in shared, block-major buffers. A descriptor table gives each
+ *              image's first block and size, so launch, wait and buffer
+ *              syncs are paid once per batch instead of once per image.
+ * Descriptor: DESC_WORDS x 32-bit words per image (host/batch.hpp):
+ *             [0] offset of the image's first block in the buffers
+ *             [1] width  [2] height  [3] reserved
+ * Contract: images are tiled as in v7; total_blocks is the sum of
+ *           ceil(w/8) * ceil(h/8) over the batch. Coefficients come back
+ *           tiled at the same offsets.
+ ******************************************************************************/
+
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+typedef ap_uint<8>  pixel_t;
+typedef ap_int<16>  coeff_t;
+typedef ap_fixed<24,12> dct_t;
+typedef ap_uint<64>  pix8_t;     // 8 pixels of one block row
+typedef ap_uint<128> coef8_t;    // 8 coefficients of one block row
+
+static const int N = 8;
+static const int DESC_WORDS = 4;
+static const int MAX_IMAGES = 4096;     // desc depth is MAX_IMAGES * DESC_WORDS
+
+static const dct_t C[N][N] = {
+    {0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553},
+    {0.490393, 0.415735, 0.277785, 0.097545,-0.097545,-0.277785,-0.415735,-0.490393},
+    {0.461940, 0.191342,-0.191342,-0.461940,-0.461940,-0.191342, 0.191342, 0.461940},
+    {0.415735,-0.097545,-0.490393,-0.277785, 0.277785, 0.490393, 0.097545,-0.415735},
+    {0.353553,-0.353553,-0.353553, 0.353553, 0.353553,-0.353553,-0.353553, 0.353553},
+    {0.277785,-0.490393, 0.097545, 0.415735,-0.415735,-0.097545, 0.490393,-0.277785},
+    {0.191342,-0.461940, 0.461940,-0.191342,-0.191342, 0.461940,-0.461940, 0.191342},
+    {0.097545,-0.277785, 0.415735,-0.490393, 0.490393,-0.415735, 0.277785,-0.097545}
+};
+
+struct block_data {
+    pixel_t R[8][8];
+    pixel_t G[8][8];
+    pixel_t B[8][8];
+};
+
+struct coeff_data {
+    coeff_t R[8][8];
+    coeff_t G[8][8];
+    coeff_t B[8][8];
+};
+
+// v4's transform: out_blk[u][v] is vertical frequency u, horizontal v
+static void dct_2d(pixel_t in_blk[8][8], coeff_t out_blk[8][8])
+{
+#pragma HLS INLINE
+    dct_t tmp[8][8];
+#pragma HLS ARRAY_PARTITION variable=tmp complete dim=0
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int x = 0; x < 8; x++) {
+#pragma HLS UNROLL
+                acc += C[u][x] * (dct_t)((int)in_blk[x][v] - 128);
+            }
+            tmp[u][v] = acc;
+        }
+    }
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+                acc += tmp[u][y] * C[v][y];
+            }
+            int val = (int)hls::round(acc);
+            if (val < -32768) val = -32768;
+            if (val >  32767) val =  32767;
+            out_blk[u][v] = (coeff_t)val;
+        }
+    }
+}
+
+// Walk the descriptor table and stream every image's blocks. Each
+// image's (offset, block count) goes on to the store stage.
+static void load_blocks_df(
+    const pix8_t* inR,
+    const pix8_t* inG,
+    const pix8_t* inB,
+    const ap_uint<32>* desc,
+    int num_images,
+    hls::stream<block_data>& block_stream,
+    hls::stream<ap_uint<64> >& span_stream
+) {
+    for (int n = 0; n < num_images; n++) {
+#pragma HLS LOOP_TRIPCOUNT min=1 max=4096
+        ap_uint<32> offset = desc[n * DESC_WORDS + 0];
+        int w = desc[n * DESC_WORDS + 1];
+        int h = desc[n * DESC_WORDS + 2];
+        int nb = ((w + 7) / 8) * ((h + 7) / 8);
+
+        ap_uint<64> span;
+        span.range(31, 0) = offset;
+        span.range(63, 32) = nb;
+        span_stream.write(span);
+
+        for (int i = 0; i < nb; i++) {
+#pragma HLS LOOP_TRIPCOUNT min=1 max=64
+            int base = (offset + i) * 8;
+            block_data blk;
+            for (int y = 0; y < 8; y++) {
+#pragma HLS PIPELINE II=1
+                pix8_t r = inR[base + y];
+                pix8_t g = inG[base + y];
+                pix8_t b = inB[base + y];
+                for (int x = 0; x < 8; x++) {
+                    blk.R[y][x] = r.range(8 * x + 7, 8 * x);
+                    blk.G[y][x] = g.range(8 * x + 7, 8 * x);
+                    blk.B[y][x] = b.range(8 * x + 7, 8 * x);
+                }
+            }
+            block_stream.write(blk);
+        }
+    }
+}
+
+// Same as v3, counted in blocks
+static void compute_dct_df(
+    hls::stream<block_data>& in_stream,
+    hls::stream<coeff_data>& out_stream,
+    int num_blocks
+) {
+    for (int i = 0; i < num_blocks; i++) {
+#pragma HLS PIPELINE II=1
+        block_data blk = in_stream.read();
+        coeff_data coef;
+        
+        dct_2d(blk.R, coef.R);
+        dct_2d(blk.G, coef.G);
+        dct_2d(blk.B, coef.B);
+        
+        out_stream.write(coef);
+    }
+}
+
+// Quant table entry as packed by the host: recip[15:0] corr[23:16] shift[28:24]
+// Table t covers channel t (0 = R/Y, 1 = G/Cb, 2 = B/Cr), 64 entries each,
+// indexed by block position y*8+x.
+static const int QTAB_WORDS = 3 * 64;
+
+static void quant_2d(
+    coeff_t blk[8][8],
+    const ap_uint<16> recip[64],
+    const ap_uint<8>  corr[64],
+    const ap_uint<5>  shift[64]
+) {
+#pragma HLS INLINE
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            // blk[u][v] is stored at block position (y=v, x=u)
+            int i = v * 8 + u;
+            int val = blk[u][v];
+            ap_uint<17> a = val < 0 ? -val : val;
+            ap_uint<33> p = (a + corr[i]) * recip[i];
+            int q = (int)(p >> shift[i]);
+            blk[u][v] = (coeff_t)(val < 0 ? -q : q);
+        }
+    }
+}
+
+static void quant_blocks_df(
+    hls::stream<coeff_data>& in_stream,
+    hls::stream<coeff_data>& out_stream,
+    const ap_uint<32>* qtab,
+    int quant_en,
+    int num_blocks
+) {
+    ap_uint<16> recip[3][64];
+    ap_uint<8>  corr[3][64];
+    ap_uint<5>  shift[3][64];
+#pragma HLS ARRAY_PARTITION variable=recip complete dim=0
+#pragma HLS ARRAY_PARTITION variable=corr complete dim=0
+#pragma HLS ARRAY_PARTITION variable=shift complete dim=0
+
+    for (int i = 0; i < QTAB_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+        ap_uint<32> e = qtab[i];
+        recip[i / 64][i % 64] = e.range(15, 0);
+        corr[i / 64][i % 64]  = e.range(23, 16);
+        shift[i / 64][i % 64] = e.range(28, 24);
+    }
+
+    for (int i = 0; i < num_blocks; i++) {
+#pragma HLS PIPELINE II=1
+        coeff_data coef = in_stream.read();
+        if (quant_en) {
+            quant_2d(coef.R, recip[0], corr[0], shift[0]);
+            quant_2d(coef.G, recip[1], corr[1], shift[1]);
+            quant_2d(coef.B, recip[2], corr[2], shift[2]);
+        }
+        out_stream.write(coef);
+    }
+}
+
+// Write each image's blocks back at its own offset.
+// Keeps v3's transposed [x][y] read of the coefficient blocks.
+static void store_blocks_df(
+    hls::stream<coeff_data>& coeff_stream,
+    hls::stream<ap_uint<64> >& span_stream,
+    coef8_t* outR,
+    coef8_t* outG,
+    coef8_t* outB,
+    int num_images
+) {
+    for (int n = 0; n < num_images; n++) {
+#pragma HLS LOOP_TRIPCOUNT min=1 max=4096
+        ap_uint<64> span = span_stream.read();
+        int offset = span.range(31, 0);
+        int nb = span.range(63, 32);
+
+        for (int i = 0; i < nb; i++) {
+#pragma HLS LOOP_TRIPCOUNT min=1 max=64
+            int base = (offset + i) * 8;
+            coeff_data coef = coeff_stream.read();
+            for (int y = 0; y < 8; y++) {
+#pragma HLS PIPELINE II=1
+                coef8_t r, g, b;
+                for (int x = 0; x < 8; x++) {
+                    r.range(16 * x + 15, 16 * x) = coef.R[x][y];
+                    g.range(16 * x + 15, 16 * x) = coef.G[x][y];
+                    b.range(16 * x + 15, 16 * x) = coef.B[x][y];
+                }
+                outR[base + y] = r;
+                outG[base + y] = g;
+                outB[base + y] = b;
+            }
+        }
+    }
+}
+
+extern "C" void dct_accel(
+    const pix8_t* inR,
+    const pix8_t* inG,
+    const pix8_t* inB,
+    coef8_t* outR,
+    coef8_t* outG,
+    coef8_t* outB,
+    const ap_uint<32>* qtab,
+    const ap_uint<32>* desc,
+    int num_images,
+    int total_blocks,
+    int quant_en
+) {
+#pragma HLS INTERFACE m_axi port=inR offset=slave bundle=gmem0 depth=262144 max_read_burst_length=64
+#pragma HLS INTERFACE m_axi port=inG offset=slave bundle=gmem1 depth=262144 max_read_burst_length=64
+#pragma HLS INTERFACE m_axi port=inB offset=slave bundle=gmem2 depth=262144 max_read_burst_length=64
+#pragma HLS INTERFACE m_axi port=outR offset=slave bundle=gmem3 depth=262144 max_write_burst_length=64
+#pragma HLS INTERFACE m_axi port=outG offset=slave bundle=gmem4 depth=262144 max_write_burst_length=64
+#pragma HLS INTERFACE m_axi port=outB offset=slave bundle=gmem5 depth=262144 max_write_burst_length=64
+#pragma HLS INTERFACE m_axi port=qtab offset=slave bundle=gmem6 depth=192
+#pragma HLS INTERFACE m_axi port=desc offset=slave bundle=gmem7 depth=16384
+#pragma HLS INTERFACE s_axilite port=num_images
+#pragma HLS INTERFACE s_axilite port=total_blocks
+#pragma HLS INTERFACE s_axilite port=quant_en
+#pragma HLS INTERFACE s_axilite port=return
+
+#pragma HLS DATAFLOW
+
+    hls::stream<block_data> block_stream("block_stream");
+#pragma HLS STREAM variable=block_stream depth=4
+
+    hls::stream<coeff_data> coeff_stream("coeff_stream");
+#pragma HLS STREAM variable=coeff_stream depth=4
+
+    hls::stream<coeff_data> quant_stream("quant_stream");
+#pragma HLS STREAM variable=quant_stream depth=4
+
+    // One entry per image; deep enough that store never stalls load on it
+    hls::stream<ap_uint<64> > span_stream("span_stream");
+#pragma HLS STREAM variable=span_stream depth=64
+
+    load_blocks_df(inR, inG, inB, desc, num_images, block_stream, span_stream);
+    compute_dct_df(block_stream, coeff_stream, total_blocks);
+    quant_blocks_df(coeff_stream, quant_stream, qtab, quant_en, total_blocks);
+    store_blocks_df(quant_stream, span_stream, outR, outG, outB, num_images);
+}
@@ -0,0 +1,384 @@
+/******************************************************************************
+ * VERSION 9: v4 DATAFLOW WITH AN IN-KERNEL STATISTICS STAGE
+ * Description: v4's load -> DCT -> quantize -> store dataflow, plus a stage
+ *              that counts, per channel, what the host's compression
+ *              metrics need while the blocks stream past: zero and nonzero
+ *              quantized coefficients, RLE pairs in zigzag order and a
+ *              histogram of DC difference categories. The counts land in a
+ *              small result buffer, so the host does not rescan the planes.
+ * Contract: same arguments as v4 plus `stats` (STATS_WORDS words). Counts
+ *           are over the quantized coefficients whether or not quant_en
+ *           is set (the stage quantizes a copy with the same tables), in
+ *           the host's view of a block: transposed as the store writes it,
+ *           positions past the right/bottom edge read as 0.
+ ******************************************************************************/
+
+#include <ap_int.h>
+#include <ap_fixed.h>
+#include <hls_math.h>
+#include <hls_stream.h>
+
+typedef ap_uint<8>  pixel_t;
+typedef ap_int<16>  coeff_t;
+typedef ap_fixed<24,12> dct_t;
+
+static const int N = 8;
+
+static const dct_t C[N][N] = {
+    {0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553, 0.353553},
+    {0.490393, 0.415735, 0.277785, 0.097545,-0.097545,-0.277785,-0.415735,-0.490393},
+    {0.461940, 0.191342,-0.191342,-0.461940,-0.461940,-0.191342, 0.191342, 0.461940},
+    {0.415735,-0.097545,-0.490393,-0.277785, 0.277785, 0.490393, 0.097545,-0.415735},
+    {0.353553,-0.353553,-0.353553, 0.353553, 0.353553,-0.353553,-0.353553, 0.353553},
+    {0.277785,-0.490393, 0.097545, 0.415735,-0.415735,-0.097545, 0.490393,-0.277785},
+    {0.191342,-0.461940, 0.461940,-0.191342,-0.191342, 0.461940,-0.461940, 0.191342},
+    {0.097545,-0.277785, 0.415735,-0.490393, 0.490393,-0.415735, 0.277785,-0.097545}
+};
+
+struct block_data {
+    pixel_t R[8][8];
+    pixel_t G[8][8];
+    pixel_t B[8][8];
+};
+
+struct coeff_data {
+    coeff_t R[8][8];
+    coeff_t G[8][8];
+    coeff_t B[8][8];
+};
+
+// v4's transform: out_blk[u][v] is vertical frequency u, horizontal v
+static void dct_2d(pixel_t in_blk[8][8], coeff_t out_blk[8][8])
+{
+#pragma HLS INLINE
+    dct_t tmp[8][8];
+#pragma HLS ARRAY_PARTITION variable=tmp complete dim=0
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int x = 0; x < 8; x++) {
+#pragma HLS UNROLL
+                acc += C[u][x] * (dct_t)((int)in_blk[x][v] - 128);
+            }
+            tmp[u][v] = acc;
+        }
+    }
+
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            dct_t acc = 0;
+            for (int y = 0; y < 8; y++) {
+#pragma HLS UNROLL
+                acc += tmp[u][y] * C[v][y];
+            }
+            int val = (int)hls::round(acc);
+            if (val < -32768) val = -32768;
+            if (val >  32767) val =  32767;
+            out_blk[u][v] = (coeff_t)val;
+        }
+    }
+}
+
+// v4's loader
+static void load_blocks_df(
+    const pixel_t* inR,
+    const pixel_t* inG,
+    const pixel_t* inB,
+    hls::stream<block_data>& block_stream,
+    int width,
+    int height
+) {
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+            block_data blk;
+            
+            for (int i = 0; i < 64; i++) {
+#pragma HLS PIPELINE II=1
+                int y = i / 8;
+                int x = i % 8;
+                // Edge-replicate past the right/bottom border
+                int gx = bx + x;
+                int gy = by + y;
+                int sx = gx < width ? gx : width - 1;
+                int sy = gy < height ? gy : height - 1;
+                int idx = sy * width + sx;
+                blk.R[y][x] = inR[idx];
+                blk.G[y][x] = inG[idx];
+                blk.B[y][x] = inB[idx];
+            }
+            block_stream.write(blk);
+        }
+    }
+}
+
+// One block of each channel per iteration
+static void compute_dct_df(
+    hls::stream<block_data>& in_stream,
+    hls::stream<coeff_data>& out_stream,
+    int width,
+    int height
+) {
+    int num_blocks = ((height + 7) / 8) * ((width + 7) / 8);
+    
+    for (int i = 0; i < num_blocks; i++) {
+#pragma HLS PIPELINE II=1
+        block_data blk = in_stream.read();
+        coeff_data coef;
+        
+        dct_2d(blk.R, coef.R);
+        dct_2d(blk.G, coef.G);
+        dct_2d(blk.B, coef.B);
+        
+        out_stream.write(coef);
+    }
+}
+
+// Quant table entry as packed by the host: recip[15:0] corr[23:16] shift[28:24]
+// Table t covers channel t (0 = R/Y, 1 = G/Cb, 2 = B/Cr), 64 entries each,
+// indexed by block position y*8+x.
+static const int QTAB_WORDS = 3 * 64;
+
+static void quant_2d(
+    coeff_t blk[8][8],
+    const ap_uint<16> recip[64],
+    const ap_uint<8>  corr[64],
+    const ap_uint<5>  shift[64]
+) {
+#pragma HLS INLINE
+    for (int u = 0; u < 8; u++) {
+#pragma HLS UNROLL
+        for (int v = 0; v < 8; v++) {
+#pragma HLS UNROLL
+            // blk[u][v] is stored at block position (y=v, x=u)
+            int i = v * 8 + u;
+            int val = blk[u][v];
+            ap_uint<17> a = val < 0 ? -val : val;
+            ap_uint<33> p = (a + corr[i]) * recip[i];
+            int q = (int)(p >> shift[i]);
+            blk[u][v] = (coeff_t)(val < 0 ? -q : q);
+        }
+    }
+}
+
+// Also sends every block, quantized, to the statistics stage
+static void quant_blocks_df(
+    hls::stream<coeff_data>& in_stream,
+    hls::stream<coeff_data>& out_stream,
+    hls::stream<coeff_data>& stat_stream,
+    const ap_uint<32>* qtab,
+    int quant_en,
+    int width,
+    int height
+) {
+    ap_uint<16> recip[3][64];
+    ap_uint<8>  corr[3][64];
+    ap_uint<5>  shift[3][64];
+#pragma HLS ARRAY_PARTITION variable=recip complete dim=0
+#pragma HLS ARRAY_PARTITION variable=corr complete dim=0
+#pragma HLS ARRAY_PARTITION variable=shift complete dim=0
+
+    for (int i = 0; i < QTAB_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+        ap_uint<32> e = qtab[i];
+        recip[i / 64][i % 64] = e.range(15, 0);
+        corr[i / 64][i % 64]  = e.range(23, 16);
+        shift[i / 64][i % 64] = e.range(28, 24);
+    }
+
+    int num_blocks = ((height + 7) / 8) * ((width + 7) / 8);
+
+    for (int i = 0; i < num_blocks; i++) {
+#pragma HLS PIPELINE II=1
+        coeff_data coef = in_stream.read();
+        coeff_data q = coef;
+        quant_2d(q.R, recip[0], corr[0], shift[0]);
+        quant_2d(q.G, recip[1], corr[1], shift[1]);
+        quant_2d(q.B, recip[2], corr[2], shift[2]);
+        out_stream.write(quant_en ? q : coef);
+        stat_stream.write(q);
+    }
+}
+
+// Statistics result, STATS_CH_WORDS 32-bit words per channel
+// (host/kernel_stats.hpp):
+//   [0] zero coefficients  [1] nonzero coefficients  [2] RLE pairs
+//   [3] blocks  [4 + k] blocks whose DC difference has category k (0..16)
+static const int STATS_CH_WORDS = 24;
+static const int STATS_WORDS = 3 * STATS_CH_WORDS;
+static const int DC_CATEGORIES = 17;
+
+// Host zigzag table (jpeg_cpu.hpp): scan index -> block position y*8+x
+static const ap_uint<6> ZIGZAG[64] = {
+     0,  1,  5,  6, 14, 15, 27, 28,
+     2,  4,  7, 13, 16, 26, 29, 42,
+     3,  8, 12, 17, 25, 30, 41, 43,
+     9, 11, 18, 24, 31, 40, 44, 53,
+    10, 19, 23, 32, 39, 45, 52, 54,
+    20, 22, 33, 38, 46, 51, 55, 60,
+    21, 34, 37, 47, 50, 56, 59, 61,
+    35, 36, 48, 49, 57, 58, 62, 63
+};
+
+// Counts of one block into acc (one channel's STATS_CH_WORDS counters)
+static void block_stats(
+    coeff_t blk[8][8],
+    int bx,
+    int by,
+    int width,
+    int height,
+    coeff_t& prev_dc,
+    ap_uint<32> acc[STATS_CH_WORDS]
+) {
+#pragma HLS INLINE
+    coeff_t zz[64];
+#pragma HLS ARRAY_PARTITION variable=zz complete
+    for (int i = 0; i < 64; i++) {
+#pragma HLS UNROLL
+        // blk[u][v] is stored at block position (y=v, x=u)
+        int y = ZIGZAG[i] / 8;
+        int x = ZIGZAG[i] % 8;
+        zz[i] = (bx + x < width && by + y < height) ? blk[x][y] : coeff_t(0);
+    }
+
+    ap_uint<7> zeros = 0;
+    ap_uint<7> runs = 1;
+    for (int i = 0; i < 64; i++) {
+#pragma HLS UNROLL
+        if (zz[i] == 0) zeros++;
+        if (i > 0 && zz[i] != zz[i - 1]) runs++;
+    }
+
+    int diff = (int)zz[0] - (int)prev_dc;
+    prev_dc = zz[0];
+    ap_uint<17> mag = diff < 0 ? -diff : diff;
+    int cat = 0;
+    for (int b = 0; b < DC_CATEGORIES - 1; b++) {
+#pragma HLS UNROLL
+        if (mag >> b) cat = b + 1;
+    }
+
+    acc[0] += zeros;
+    acc[1] += 64 - zeros;
+    acc[2] += runs;
+    acc[3] += 1;
+    for (int k = 0; k < DC_CATEGORIES; k++) {
+#pragma HLS UNROLL
+        if (k == cat) acc[4 + k] += 1;
+    }
+}
+
+static void stats_df(
+    hls::stream<coeff_data>& stat_stream,
+    ap_uint<32>* stats,
+    int width,
+    int height
+) {
+    ap_uint<32> acc[3][STATS_CH_WORDS];
+#pragma HLS ARRAY_PARTITION variable=acc complete dim=0
+    for (int c = 0; c < 3; c++) {
+#pragma HLS UNROLL
+        for (int i = 0; i < STATS_CH_WORDS; i++) {
+#pragma HLS UNROLL
+            acc[c][i] = 0;
+        }
+    }
+    coeff_t prev_dc[3] = {0, 0, 0};
+#pragma HLS ARRAY_PARTITION variable=prev_dc complete
+
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+#pragma HLS PIPELINE II=1
+            coeff_data q = stat_stream.read();
+            block_stats(q.R, bx, by, width, height, prev_dc[0], acc[0]);
+            block_stats(q.G, bx, by, width, height, prev_dc[1], acc[1]);
+            block_stats(q.B, bx, by, width, height, prev_dc[2], acc[2]);
+        }
+    }
+
+    for (int i = 0; i < STATS_WORDS; i++) {
+#pragma HLS PIPELINE II=1
+        stats[i] = acc[i / STATS_CH_WORDS][i % STATS_CH_WORDS];
+    }
+}
+
+static void store_blocks_df(
+    hls::stream<coeff_data>& coeff_stream,
+    coeff_t* outR,
+    coeff_t* outG,
+    coeff_t* outB,
+    int width,
+    int height
+) {
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+            coeff_data coef = coeff_stream.read();
+            
+            for (int i = 0; i < 64; i++) {
+#pragma HLS PIPELINE II=1
+                int y = i / 8;
+                int x = i % 8;
+                int gx = bx + x;
+                int gy = by + y;
+                if (gx < width && gy < height) {
+                    int idx = gy * width + gx;
+                    // Transposed, as v4 stores it
+                    outR[idx] = coef.R[x][y];
+                    outG[idx] = coef.G[x][y];
+                    outB[idx] = coef.B[x][y];
+                }
+            }
+        }
+    }
+}
+
+extern "C" void dct_accel(
+    const pixel_t* inR,
+    const pixel_t* inG,
+    const pixel_t* inB,
+    coeff_t* outR,
+    coeff_t* outG,
+    coeff_t* outB,
+    const ap_uint<32>* qtab,
+    int width,
+    int height,
+    int quant_en,
+    ap_uint<32>* stats
+) {
+#pragma HLS INTERFACE m_axi port=inR offset=slave bundle=gmem0 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inG offset=slave bundle=gmem1 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=inB offset=slave bundle=gmem2 depth=2073600 max_read_burst_length=256
+#pragma HLS INTERFACE m_axi port=outR offset=slave bundle=gmem3 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outG offset=slave bundle=gmem4 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=outB offset=slave bundle=gmem5 depth=2073600 max_write_burst_length=256
+#pragma HLS INTERFACE m_axi port=qtab offset=slave bundle=gmem6 depth=192
+#pragma HLS INTERFACE m_axi port=stats offset=slave bundle=gmem7 depth=72
+#pragma HLS INTERFACE s_axilite port=width
+#pragma HLS INTERFACE s_axilite port=height
+#pragma HLS INTERFACE s_axilite port=quant_en
+#pragma HLS INTERFACE s_axilite port=return
+
+#pragma HLS DATAFLOW
+    
+    hls::stream<block_data> block_stream("block_stream");
+#pragma HLS STREAM variable=block_stream depth=4
+    
+    hls::stream<coeff_data> coeff_stream("coeff_stream");
+#pragma HLS STREAM variable=coeff_stream depth=4
+
+    hls::stream<coeff_data> quant_stream("quant_stream");
+#pragma HLS STREAM variable=quant_stream depth=4
+
+    hls::stream<coeff_data> stat_stream("stat_stream");
+#pragma HLS STREAM variable=stat_stream depth=4
+    
+    load_blocks_df(inR, inG, inB, block_stream, width, height);
+    compute_dct_df(block_stream, coeff_stream, width, height);
+    quant_blocks_df(coeff_stream, quant_stream, stat_stream, qtab, quant_en, width, height);
+    stats_df(stat_stream, stats, width, height);
+    store_blocks_df(quant_stream, outR, outG, outB, width, height);
+}
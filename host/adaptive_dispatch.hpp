@@ -0,0 +1,117 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+
+#include "cu_scheduler.hpp"
+
+// Online cost model of one backend: service time
+//   t = fixed_ms + ms_per_block * blocks
+// refitted after every job by recursive least squares with a forgetting
+// factor, so it follows a backend whose speed drifts (clocks, contention,
+// other tenants). Blocks enter in thousands to keep the 2x2 covariance
+// well conditioned.
+class CostModel {
+public:
+    CostModel(double fixed_ms = 0.0, double ms_per_block = 0.0, double forget = 0.97)
+        : a_(fixed_ms), b_(ms_per_block * 1000.0), forget_(forget)
+    {
+        p_[0][0] = p_[1][1] = 1e3;
+        p_[0][1] = p_[1][0] = 0;
+    }
+
+    double predict(size_t blocks) const
+    {
+        return std::max(0.0, std::max(0.0, a_) + std::max(0.0, b_) * (blocks / 1000.0));
+    }
+
+    void update(size_t blocks, double ms)
+    {
+        double x[2] = { 1.0, blocks / 1000.0 };
+        double px[2] = { p_[0][0] * x[0] + p_[0][1] * x[1], p_[1][0] * x[0] + p_[1][1] * x[1] };
+        double denom = forget_ + x[0] * px[0] + x[1] * px[1];
+        double k[2] = { px[0] / denom, px[1] / denom };
+        double err = ms - (a_ + b_ * x[1]);
+        a_ += k[0] * err;
+        b_ += k[1] * err;
+        for (int i = 0; i < 2; i++)
+            for (int j = 0; j < 2; j++)
+                p_[i][j] = (p_[i][j] - k[i] * px[j]) / forget_;
+        samples_++;
+    }
+
+    double fixed_ms() const { return std::max(0.0, a_); }
+    double ms_per_block() const { return std::max(0.0, b_) / 1000.0; }
+    int samples() const { return samples_; }
+
+private:
+    double a_, b_;          // ms, ms per 1000 blocks
+    double p_[2][2];
+    double forget_;
+    int samples_ = 0;
+};
+
+// One routing decision and what came of it
+struct DispatchRecord {
+    int id;
+    size_t blocks;
+    int unit;
+    double queue_ms;        // predicted work ahead of the job on that unit
+    double predicted_ms;    // predicted service time
+    double actual_ms;       // measured service time
+};
+
+// Routes each job to the backend (CPU engine or device unit, one worker
+// thread each) that minimizes its predicted completion time: the
+// predicted service time of everything already queued or running there
+// plus the job's own, both from that backend's CostModel. Every finished
+// job refits its backend's model and is kept as a DispatchRecord.
+class AdaptiveDispatcher : public CuScheduler {
+public:
+    explicit AdaptiveDispatcher(std::vector<std::unique_ptr<DctUnit>> units)
+        : CuScheduler(std::move(units), std::unique_ptr<CuPolicy>(new CostPolicy()))
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        costs().models.resize(num_units());
+    }
+
+    void set_model(int i, const CostModel& m)
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        costs().models[i] = m;
+    }
+
+    CostModel model(int i) const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        return static_cast<const CostPolicy&>(policy()).models[i];
+    }
+
+    // Decisions since the last call, in completion order
+    std::vector<DispatchRecord> take_records()
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        std::vector<DispatchRecord> r;
+        r.swap(costs().records);
+        return r;
+    }
+
+private:
+    // A job costs its predicted service time on the unit
+    struct CostPolicy : CuPolicy {
+        std::vector<CostModel> models;
+        std::vector<DispatchRecord> records;
+
+        double cost(int unit, const DctJob& job) override { return models[unit].predict(job.blocks()); }
+
+        void finished(const DctJob& job, const CuPlacement& p, double ms) override
+        {
+            models[p.unit].update(job.blocks(), ms);
+            records.push_back({p.id, job.blocks(), p.unit, p.queued, p.cost, ms});
+        }
+    };
+
+    CostPolicy& costs() { return static_cast<CostPolicy&>(policy()); }
+};
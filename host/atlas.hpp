@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include "parallel.hpp"
+#include "planes.hpp"
+
+// Many small images laid into one block-aligned atlas so a single launch
+// of a raster dct_accel (v1-v4) transforms all of them. Every image gets
+// its own round_up8(w) x round_up8(h) slot at a multiple of 8, padded by
+// edge replication, so each atlas block belongs to exactly one image and
+// holds what cpu_dct_image would build for that image's own block.
+//
+// Slots are placed with a shelf packer: images sorted by slot height,
+// shelves filled left to right up to the atlas width.
+
+struct AtlasSlot {
+    int x, y;           // top-left in the atlas, multiples of 8
+    int width, height;  // image size (the slot is rounded up to 8)
+};
+
+struct Atlas {
+    int width;
+    int height;
+    std::vector<AtlasSlot> slots;   // in input order
+    size_t size() const { return size_t(width) * height; }
+};
+
+// sizes[i] = {w, h}. The atlas is about square, but at least as wide as
+// the widest slot and at most max_width when the slots allow it.
+inline Atlas atlas_layout(const std::vector<std::pair<int, int>> &sizes, int max_width)
+{
+    Atlas a;
+    a.slots.resize(sizes.size());
+    size_t area = 0;
+    int widest = 8;
+    for (auto &s : sizes) {
+        area += size_t(round_up8(s.first)) * round_up8(s.second);
+        widest = std::max(widest, round_up8(s.first));
+    }
+    a.width = std::max(widest, std::min(round_up8(max_width),
+                                        round_up8((int)std::ceil(std::sqrt((double)area)))));
+
+    std::vector<int> order(sizes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int i, int j) {
+        return round_up8(sizes[i].second) > round_up8(sizes[j].second);
+    });
+
+    int x = 0, y = 0, shelf = 0;
+    for (int i : order) {
+        int sw = round_up8(sizes[i].first), sh = round_up8(sizes[i].second);
+        if (x + sw > a.width) {
+            y += shelf;
+            x = 0;
+            shelf = 0;
+        }
+        a.slots[i] = {x, y, sizes[i].first, sizes[i].second};
+        x += sw;
+        shelf = std::max(shelf, sh);
+    }
+    a.height = std::max(8, y + shelf);
+    return a;
+}
+
+// Copy every image into its slot (edge-replicated to the slot size).
+// images[i] points at a w x h plane; images are spread across threads
+// and each row is one contiguous copy.
+template <class T>
+inline void atlas_pack(const std::vector<const T *> &images, const Atlas &a,
+                       std::vector<T> &atlas)
+{
+    atlas.assign(a.size(), T(0));
+    parallel_for(0, (int)images.size(), host_num_threads(), [&](int, int lo, int hi) {
+        for (int i = lo; i < hi; i++) {
+            const AtlasSlot &s = a.slots[i];
+            copy_rect_replicate(images[i], s.width,
+                                atlas.data() + size_t(s.y) * a.width + s.x, a.width,
+                                s.width, s.height, round_up8(s.width), round_up8(s.height));
+        }
+    });
+}
+
+// Scatter the atlas coefficients back to one w x h plane per image
+template <class T>
+inline void atlas_scatter(const std::vector<T> &atlas, const Atlas &a,
+                          std::vector<std::vector<T>> &images)
+{
+    images.resize(a.slots.size());
+    parallel_for(0, (int)a.slots.size(), host_num_threads(), [&](int, int lo, int hi) {
+        for (int i = lo; i < hi; i++) {
+            const AtlasSlot &s = a.slots[i];
+            images[i].resize(size_t(s.width) * s.height);
+            copy_rect(atlas.data() + size_t(s.y) * a.width + s.x, a.width,
+                      images[i].data(), s.width, s.width, s.height);
+        }
+    });
+}
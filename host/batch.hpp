@@ -0,0 +1,153 @@
+#pragma once
+#include <xrt/xrt_device.h>
+#include <xrt/xrt_kernel.h>
+#include <xrt/xrt_bo.h>
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+#include "jpeg_cpu.hpp"
+#include "parallel.hpp"
+#include "tiles.hpp"
+
+// Batch API for the v8 kernel: many small images share one set of tiled
+// buffers and one launch. Each image is described by
+//   desc[n * BATCH_DESC_WORDS + 0..3] = { first block, width, height, 0 }
+// (layout fixed by hls/v8_dct_accel.cpp).
+
+static const int BATCH_DESC_WORDS = 4;
+static const int BATCH_MAX_IMAGES = 4096;   // v8 MAX_IMAGES
+
+// One image of a batch: three planes of width x height pixels
+struct BatchImage {
+    int width;
+    int height;
+    const pixel_t* planes[3];
+};
+
+// Coefficients of one image, raster order per plane
+struct BatchCoeffs {
+    std::vector<coeff_t> planes[3];
+};
+
+struct BatchTiming {
+    double pack_ms;         // tiling into the mapped input buffers
+    double upload_ms;
+    double kernel_ms;
+    double readback_ms;     // sync back + untiling
+    double total_ms() const { return pack_ms + upload_ms + kernel_ms + readback_ms; }
+};
+
+// Descriptor table and block offsets for a batch, images back to back
+inline size_t batch_layout(const std::vector<BatchImage>& images,
+                           std::vector<uint32_t>& desc,
+                           std::vector<size_t>& first_block)
+{
+    desc.assign(images.size() * BATCH_DESC_WORDS, 0);
+    first_block.resize(images.size());
+    size_t next = 0;
+    for (size_t n = 0; n < images.size(); n++) {
+        const BatchImage& im = images[n];
+        first_block[n] = next;
+        desc[n * BATCH_DESC_WORDS + 0] = uint32_t(next);
+        desc[n * BATCH_DESC_WORDS + 1] = uint32_t(im.width);
+        desc[n * BATCH_DESC_WORDS + 2] = uint32_t(im.height);
+        next += tiled_size(im.width, im.height) / 64;
+    }
+    return next;
+}
+
+// Buffers are allocated once for max_blocks / max_images and reused by
+// every run(); tiles are written straight into the mapped input buffers
+// and only the used prefix of each buffer is synced.
+class BatchDct {
+public:
+    BatchDct(xrt::device& device, xrt::kernel& kernel,
+             size_t max_blocks, int max_images,
+             const std::vector<uint32_t>& qwords)
+        : kernel_(kernel), max_blocks_(max_blocks), max_images_(max_images)
+    {
+        if (max_images > BATCH_MAX_IMAGES)
+            throw std::runtime_error("batch larger than the v8 descriptor table");
+        size_t pix = max_blocks * 64 * sizeof(pixel_t);
+        size_t coef = max_blocks * 64 * sizeof(coeff_t);
+        for (int c = 0; c < 3; c++) {
+            in_[c]  = xrt::bo(device, pix,  xrt::bo::flags::normal, kernel.group_id(c));
+            out_[c] = xrt::bo(device, coef, xrt::bo::flags::normal, kernel.group_id(3 + c));
+        }
+        qtab_ = xrt::bo(device, qwords.size() * sizeof(uint32_t),
+                        xrt::bo::flags::normal, kernel.group_id(6));
+        qtab_.write(qwords.data());
+        qtab_.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+        desc_ = xrt::bo(device, size_t(max_images) * BATCH_DESC_WORDS * sizeof(uint32_t),
+                        xrt::bo::flags::normal, kernel.group_id(7));
+    }
+
+    void run(const std::vector<BatchImage>& images, bool quant,
+             std::vector<BatchCoeffs>& out, BatchTiming& t)
+    {
+        using clock = std::chrono::high_resolution_clock;
+        auto ms = [](clock::time_point a, clock::time_point b) {
+            return std::chrono::duration<double, std::milli>(b - a).count();
+        };
+
+        std::vector<uint32_t> desc;
+        std::vector<size_t> first;
+        size_t blocks = batch_layout(images, desc, first);
+        if (blocks > max_blocks_ || (int)images.size() > max_images_)
+            throw std::runtime_error("batch exceeds the allocated buffers");
+
+        auto t0 = clock::now();
+        pixel_t* dst[3];
+        for (int c = 0; c < 3; c++) dst[c] = in_[c].map<pixel_t*>();
+        parallel_for(0, int(images.size()), host_num_threads(), [&](int, int lo, int hi) {
+            for (int n = lo; n < hi; n++)
+                for (int c = 0; c < 3; c++)
+                    raster_to_tiles(images[n].planes[c], images[n].width, images[n].height,
+                                    dst[c] + first[n] * 64, 1);
+        });
+        desc_.write(desc.data(), desc.size() * sizeof(uint32_t), 0);
+        auto t1 = clock::now();
+
+        for (int c = 0; c < 3; c++)
+            in_[c].sync(XCL_BO_SYNC_BO_TO_DEVICE, blocks * 64 * sizeof(pixel_t), 0);
+        desc_.sync(XCL_BO_SYNC_BO_TO_DEVICE, desc.size() * sizeof(uint32_t), 0);
+        auto t2 = clock::now();
+
+        auto r = kernel_(in_[0], in_[1], in_[2], out_[0], out_[1], out_[2],
+                         qtab_, desc_, int(images.size()), int(blocks), quant ? 1 : 0);
+        r.wait();
+        auto t3 = clock::now();
+
+        out.resize(images.size());
+        const coeff_t* src[3];
+        for (int c = 0; c < 3; c++) {
+            out_[c].sync(XCL_BO_SYNC_BO_FROM_DEVICE, blocks * 64 * sizeof(coeff_t), 0);
+            src[c] = out_[c].map<coeff_t*>();
+        }
+        parallel_for(0, int(images.size()), host_num_threads(), [&](int, int lo, int hi) {
+            for (int n = lo; n < hi; n++) {
+                const BatchImage& im = images[n];
+                for (int c = 0; c < 3; c++) {
+                    out[n].planes[c].resize(size_t(im.width) * im.height);
+                    tiles_to_raster(src[c] + first[n] * 64, im.width, im.height,
+                                    out[n].planes[c].data(), 1);
+                }
+            }
+        });
+        auto t4 = clock::now();
+
+        t.pack_ms = ms(t0, t1);
+        t.upload_ms = ms(t1, t2);
+        t.kernel_ms = ms(t2, t3);
+        t.readback_ms = ms(t3, t4);
+    }
+
+private:
+    xrt::kernel& kernel_;
+    size_t max_blocks_;
+    int max_images_;
+    xrt::bo in_[3], out_[3], qtab_, desc_;
+};
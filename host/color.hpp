@@ -0,0 +1,188 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "jpeg_cpu.hpp"
+#include "parallel.hpp"
+#include "planes.hpp"
+
+// JFIF RGB <-> YCbCr (full range, 16-bit fixed point as in libjpeg) with
+// 2x2 chroma subsampling for the 4:2:0 color path. Row loops are plain
+// integer arithmetic so they vectorize; rows are split across threads.
+
+inline int ycc_chroma_dim(int n) { return (n + 1) / 2; }
+
+// One row of RGB to Y plus full-resolution Cb/Cr
+inline void rgb_to_ycc_row(const pixel_t *r, const pixel_t *g, const pixel_t *b,
+                           pixel_t *y, int32_t *cb, int32_t *cr, int n)
+{
+    for (int i = 0; i < n; i++) {
+        int32_t R = r[i], G = g[i], B = b[i];
+        y[i]  = (pixel_t)((19595 * R + 38470 * G + 7471 * B + 32768) >> 16);
+        cb[i] = (-11059 * R - 21709 * G + 32768 * B + (128 << 16) + 32767) >> 16;
+        cr[i] = (32768 * R - 27439 * G - 5329 * B + (128 << 16) + 32767) >> 16;
+    }
+}
+
+// w x h RGB planes to Y/Cb/Cr 4:4:4, written with rows of out_stride
+// elements so the result can go straight into padded planes
+inline void rgb_to_ycc444(const pixel_t *R, const pixel_t *G, const pixel_t *B,
+                          int w, int h,
+                          pixel_t *Y, pixel_t *Cb, pixel_t *Cr, int out_stride)
+{
+    parallel_for(0, h, host_num_threads(), [&](int, int lo, int hi) {
+        std::vector<int32_t> cb(w), cr(w);
+        for (int y = lo; y < hi; y++) {
+            size_t i = size_t(y) * w, o = size_t(y) * out_stride;
+            rgb_to_ycc_row(R + i, G + i, B + i, Y + o, cb.data(), cr.data(), w);
+            for (int x = 0; x < w; x++) {
+                Cb[o + x] = (pixel_t)cb[x];
+                Cr[o + x] = (pixel_t)cr[x];
+            }
+        }
+    });
+}
+
+// Full-resolution RGB planes to Y (w x h) and Cb/Cr (ceil(w/2) x ceil(h/2)).
+// Odd edges replicate the last row/column into the 2x2 average.
+inline void rgb_to_ycc420(const std::vector<pixel_t> &R,
+                          const std::vector<pixel_t> &G,
+                          const std::vector<pixel_t> &B,
+                          int w, int h,
+                          std::vector<pixel_t> &Y,
+                          std::vector<pixel_t> &Cb,
+                          std::vector<pixel_t> &Cr)
+{
+    int cw = ycc_chroma_dim(w);
+    int ch = ycc_chroma_dim(h);
+    Y.resize(size_t(w) * h);
+    Cb.resize(size_t(cw) * ch);
+    Cr.resize(size_t(cw) * ch);
+
+    parallel_for(0, ch, host_num_threads(), [&](int, int lo, int hi) {
+        std::vector<int32_t> cb0(2 * cw), cr0(2 * cw), cb1(2 * cw), cr1(2 * cw);
+        for (int cy = lo; cy < hi; cy++) {
+            int y0 = 2 * cy;
+            int y1 = std::min(2 * cy + 1, h - 1);
+            size_t o0 = size_t(y0) * w, o1 = size_t(y1) * w;
+            rgb_to_ycc_row(&R[o0], &G[o0], &B[o0], &Y[o0], cb0.data(), cr0.data(), w);
+            rgb_to_ycc_row(&R[o1], &G[o1], &B[o1], &Y[o1], cb1.data(), cr1.data(), w);
+            if (w & 1) {
+                cb0[w] = cb0[w - 1]; cr0[w] = cr0[w - 1];
+                cb1[w] = cb1[w - 1]; cr1[w] = cr1[w - 1];
+            }
+
+            pixel_t *cb_out = &Cb[size_t(cy) * cw];
+            pixel_t *cr_out = &Cr[size_t(cy) * cw];
+            for (int cx = 0; cx < cw; cx++) {
+                int a = 2 * cx;
+                cb_out[cx] = (pixel_t)((cb0[a] + cb0[a + 1] + cb1[a] + cb1[a + 1] + 2) >> 2);
+                cr_out[cx] = (pixel_t)((cr0[a] + cr0[a + 1] + cr1[a] + cr1[a + 1] + 2) >> 2);
+            }
+        }
+    });
+}
+
+// Y plus 4:2:0 Cb/Cr back to RGB, replicating each chroma sample over its 2x2 area
+inline void ycc420_to_rgb(const std::vector<pixel_t> &Y,
+                          const std::vector<pixel_t> &Cb,
+                          const std::vector<pixel_t> &Cr,
+                          int w, int h,
+                          std::vector<pixel_t> &R,
+                          std::vector<pixel_t> &G,
+                          std::vector<pixel_t> &B)
+{
+    int cw = ycc_chroma_dim(w);
+    R.resize(size_t(w) * h);
+    G.resize(size_t(w) * h);
+    B.resize(size_t(w) * h);
+
+    parallel_for(0, h, host_num_threads(), [&](int, int lo, int hi) {
+        std::vector<int32_t> cb(w), cr(w);
+        for (int y = lo; y < hi; y++) {
+            const pixel_t *cb_row = &Cb[size_t(y / 2) * cw];
+            const pixel_t *cr_row = &Cr[size_t(y / 2) * cw];
+            for (int x = 0; x < w; x++) {
+                cb[x] = cb_row[x >> 1] - 128;
+                cr[x] = cr_row[x >> 1] - 128;
+            }
+
+            size_t o = size_t(y) * w;
+            for (int x = 0; x < w; x++) {
+                int32_t yy = Y[o + x];
+                int32_t r = yy + ((91881 * cr[x] + 32768) >> 16);
+                int32_t g = yy + ((-22554 * cb[x] - 46802 * cr[x] + 32768) >> 16);
+                int32_t b = yy + ((116130 * cb[x] + 32768) >> 16);
+                R[o + x] = (pixel_t)std::min(255, std::max(0, r));
+                G[o + x] = (pixel_t)std::min(255, std::max(0, g));
+                B[o + x] = (pixel_t)std::min(255, std::max(0, b));
+            }
+        }
+    });
+}
+
+// Y/Cb/Cr packed into three equal planes so a three-channel dct_accel
+// transforms all of them in one launch with half the blocks of RGB:
+//   plane 0: Y rows [0, split)   plane 1: Y rows [split, h)
+//   plane 2: Cb at column 0 and Cr at column cr_x, side by side
+// split and cr_x are multiples of 8, so every block of the packed planes
+// maps to exactly one block of Y, Cb or Cr. Each sub-plane is padded out
+// to its block boundary by edge replication, as cpu_dct_image does.
+struct Ycc420Packing {
+    int width;
+    int height;
+    int split;
+    int cr_x;
+};
+
+inline Ycc420Packing ycc420_packing(int w, int h)
+{
+    Ycc420Packing p;
+    int cw = ycc_chroma_dim(w);
+    p.split  = round_up8(ycc_chroma_dim(h));
+    p.cr_x   = round_up8(cw);
+    p.width  = std::max(round_up8(w), round_up8(p.cr_x + cw));
+    p.height = p.split;
+    return p;
+}
+
+inline void ycc420_pack(const std::vector<pixel_t> &Y,
+                        const std::vector<pixel_t> &Cb,
+                        const std::vector<pixel_t> &Cr,
+                        int w, int h, const Ycc420Packing &p,
+                        std::vector<pixel_t> packed[3])
+{
+    int cw = ycc_chroma_dim(w), ch = ycc_chroma_dim(h);
+    for (int c = 0; c < 3; c++) packed[c].assign(size_t(p.width) * p.height, 0);
+
+    int top = std::min(h, p.split);
+    copy_rect_replicate(Y.data(), w, packed[0].data(), p.width,
+                        w, top, round_up8(w), round_up8(top));
+    if (h > p.split)
+        copy_rect_replicate(Y.data() + size_t(p.split) * w, w, packed[1].data(), p.width,
+                            w, h - p.split, round_up8(w), round_up8(h - p.split));
+    copy_rect_replicate(Cb.data(), cw, packed[2].data(), p.width,
+                        cw, ch, round_up8(cw), round_up8(ch));
+    copy_rect_replicate(Cr.data(), cw, packed[2].data() + p.cr_x, p.width,
+                        cw, ch, round_up8(cw), round_up8(ch));
+}
+
+// Scatter coefficients of the packed planes back to Y/Cb/Cr-sized planes
+inline void ycc420_unpack(const std::vector<coeff_t> packed[3],
+                          int w, int h, const Ycc420Packing &p,
+                          std::vector<coeff_t> &Y,
+                          std::vector<coeff_t> &Cb,
+                          std::vector<coeff_t> &Cr)
+{
+    int cw = ycc_chroma_dim(w), ch = ycc_chroma_dim(h);
+    Y.resize(size_t(w) * h);
+    Cb.resize(size_t(cw) * ch);
+    Cr.resize(size_t(cw) * ch);
+
+    copy_rect(packed[0].data(), p.width, Y.data(), w, w, std::min(h, p.split));
+    if (h > p.split)
+        copy_rect(packed[1].data(), p.width, Y.data() + size_t(p.split) * w, w, w, h - p.split);
+    copy_rect(packed[2].data(), p.width, Cb.data(), cw, cw, ch);
+    copy_rect(packed[2].data() + p.cr_x, p.width, Cr.data(), cw, cw, ch);
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+#include "dct_units.hpp"
+
+// Cooperative transform of one image on two units at once, typically the
+// CPU engine and a device CU. Side 0 claims stripes from the top of the
+// image, side 1 from the bottom. Each claim is a shrinking slice of the
+// block rows nobody owns yet, weighted by the side's expected share of
+// the combined throughput (guided self-scheduling). Early claims are
+// large enough to amortize a launch; late ones are small enough that
+// neither side waits long for the other. A side that runs ahead keeps
+// claiming rows the other would have taken, which is the work stealing;
+// claimed stripes are never reassigned, except that a stripe whose unit
+// throws goes back to the other side.
+struct CoopSide {
+    std::string name;
+    int stripes = 0;
+    int block_rows = 0;
+    double busy_ms = 0;
+    bool failed = false;
+};
+
+struct CoopResult {
+    double wall_ms = 0;
+    CoopSide side[2];
+};
+
+// share0: expected fraction of the combined throughput from side 0.
+// min_rows: smallest claim of each side, in block rows.
+inline CoopResult coop_run(DctUnit* const units[2], const DctJob& image,
+                           double share0, const int min_rows[2])
+{
+    const int brows = (image.height + 7) / 8;
+    const double share[2] = { std::min(1.0, std::max(0.0, share0)),
+                              1.0 - std::min(1.0, std::max(0.0, share0)) };
+
+    std::mutex m;
+    int lo = 0, hi = brows;             // unclaimed block rows [lo, hi)
+    std::vector<std::pair<int, int>> orphans;   // stripes of a failed side
+    std::string error;
+    CoopResult res;
+
+    auto stripe_job = [&](int r0, int r1) {
+        int y0 = 8 * r0, y1 = std::min(image.height, 8 * r1);
+        DctJob j = image;
+        for (int c = 0; c < 3; c++) {
+            j.in[c] = image.in[c] + size_t(y0) * image.width;
+            j.out[c] = image.out[c] + size_t(y0) * image.width;
+        }
+        j.height = y1 - y0;
+        return j;
+    };
+
+    auto side = [&](int s) {
+        CoopSide& me = res.side[s];
+        me.name = units[s]->name();
+        for (;;) {
+            int r0, r1;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                if (!orphans.empty()) {
+                    r0 = orphans.back().first;
+                    r1 = orphans.back().second;
+                    orphans.pop_back();
+                } else {
+                    int left = hi - lo;
+                    if (left == 0) return;
+                    int take = (int)(left * share[s] / 2 + 0.999);
+                    take = std::min(left, std::max(take, std::max(1, min_rows[s])));
+                    if (s == 0) {
+                        r0 = lo;
+                        lo += take;
+                        r1 = lo;
+                    } else {
+                        r1 = hi;
+                        hi -= take;
+                        r0 = hi;
+                    }
+                }
+            }
+            auto t0 = std::chrono::high_resolution_clock::now();
+            try {
+                units[s]->run(stripe_job(r0, r1));
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(m);
+                orphans.push_back({r0, r1});
+                me.failed = true;
+                if (error.empty()) error = e.what();
+                return;
+            }
+            auto t1 = std::chrono::high_resolution_clock::now();
+            me.busy_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+            me.stripes++;
+            me.block_rows += r1 - r0;
+        }
+    };
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    std::thread other(side, 1);
+    side(0);
+    other.join();
+    // A side may have failed after the other had already finished
+    for (int s = 0; s < 2 && !orphans.empty(); s++)
+        if (!res.side[s].failed) side(s);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    res.wall_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    if (!orphans.empty()) throw std::runtime_error(error);
+    return res;
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+#include "dct_units.hpp"
+
+// Where a CuScheduler put a job: submission number, unit, and the load
+// queued ahead of it and its own cost, in the policy's units
+struct CuPlacement {
+    int id;
+    int unit;
+    double queued;
+    double cost;
+};
+
+// Decides where a CuScheduler sends jobs. A job goes to the allowed unit
+// whose queued load plus cost(unit, job) is lowest; finished() sees every
+// job that ran without error and its measured time. Both are called with
+// the scheduler's lock held.
+class CuPolicy {
+public:
+    virtual ~CuPolicy() {}
+    virtual double cost(int unit, const DctJob& job) = 0;
+    virtual void finished(const DctJob&, const CuPlacement&, double /*ms*/) {}
+};
+
+// Load is outstanding blocks (queued plus running), so large and small
+// jobs even out across units
+class LeastBlocksPolicy : public CuPolicy {
+public:
+    double cost(int, const DctJob& job) override { return double(job.blocks()); }
+};
+
+// Keeps several DctUnits (compute units) busy at once. Every unit has its
+// own queue and worker thread; submit() hands a job to the unit the
+// policy finds least loaded (LeastBlocksPolicy by default). Per-unit busy
+// time gives utilization.
+class CuScheduler {
+public:
+    explicit CuScheduler(std::vector<std::unique_ptr<DctUnit>> units,
+                         std::unique_ptr<CuPolicy> policy = std::unique_ptr<CuPolicy>(new LeastBlocksPolicy()))
+        : policy_(std::move(policy))
+    {
+        for (auto& u : units) {
+            lanes_.emplace_back(new Lane());
+            lanes_.back()->unit = std::move(u);
+        }
+        for (int i = 0; i < (int)lanes_.size(); i++)
+            lanes_[i]->worker = std::thread([this, i] { work(i); });
+    }
+
+    ~CuScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& l : lanes_) l->worker.join();
+    }
+
+    int num_units() const { return (int)lanes_.size(); }
+    const std::string& unit_name(int i) const { return lanes_[i]->unit->name(); }
+
+    // Place among the units whose bit is set in `allowed`; returns the unit.
+    // The job's buffers must stay valid until wait().
+    int submit(const DctJob& job, uint64_t allowed = ~uint64_t(0))
+    {
+        int best = -1;
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            double best_finish = 0, best_cost = 0;
+            for (int i = 0; i < (int)lanes_.size(); i++) {
+                if (!(allowed >> i & 1)) continue;
+                double cost = policy_->cost(i, job);
+                double finish = lanes_[i]->pending + cost;
+                if (best < 0 || finish < best_finish) {
+                    best = i;
+                    best_finish = finish;
+                    best_cost = cost;
+                }
+            }
+            if (best < 0) throw std::runtime_error("no unit allowed for the job");
+            Lane& l = *lanes_[best];
+            l.queue.push_back({job, {next_id_++, best, l.pending, best_cost}});
+            l.pending += best_cost;
+            l.pending_jobs++;
+        }
+        work_cv_.notify_all();
+        return best;
+    }
+
+    // Block until every submitted job has run; rethrows the first unit error
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_);
+        idle_cv_.wait(lock, [this] {
+            for (auto& l : lanes_)
+                if (l->pending_jobs) return false;
+            return true;
+        });
+        if (!error_.empty()) {
+            std::string e;
+            e.swap(error_);
+            throw std::runtime_error(e);
+        }
+    }
+
+    std::vector<DctUnitStats> stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        std::vector<DctUnitStats> s;
+        for (auto& l : lanes_)
+            s.push_back({l->unit->name(), l->jobs, l->blocks, l->busy_ms, false});
+        return s;
+    }
+
+    void reset_stats()
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        for (auto& l : lanes_) {
+            l->jobs = 0;
+            l->blocks = 0;
+            l->busy_ms = 0;
+        }
+    }
+
+protected:
+    CuPolicy& policy() { return *policy_; }
+    const CuPolicy& policy() const { return *policy_; }
+
+    // Guards the lanes and the policy
+    mutable std::mutex m_;
+
+private:
+    struct Queued {
+        DctJob job;
+        CuPlacement at;
+    };
+
+    struct Lane {
+        std::unique_ptr<DctUnit> unit;
+        std::deque<Queued> queue;
+        double pending = 0;         // policy cost, queued + running
+        int pending_jobs = 0;
+        int jobs = 0;
+        size_t blocks = 0;
+        double busy_ms = 0;
+        std::thread worker;
+    };
+
+    void work(int index)
+    {
+        Lane& lane = *lanes_[index];
+        std::unique_lock<std::mutex> lock(m_);
+        for (;;) {
+            work_cv_.wait(lock, [&] { return stop_ || !lane.queue.empty(); });
+            if (lane.queue.empty()) return;
+            Queued q = lane.queue.front();
+            lane.queue.pop_front();
+            lock.unlock();
+
+            std::string err;
+            auto t0 = std::chrono::high_resolution_clock::now();
+            try {
+                lane.unit->run(q.job);
+            } catch (const std::exception& e) {
+                err = e.what();
+            }
+            auto t1 = std::chrono::high_resolution_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+            lock.lock();
+            if (err.empty()) policy_->finished(q.job, q.at, ms);
+            else if (error_.empty()) error_ = err;
+            lane.busy_ms += ms;
+            lane.jobs++;
+            lane.blocks += q.job.blocks();
+            lane.pending = std::max(0.0, lane.pending - q.at.cost);
+            lane.pending_jobs--;
+            idle_cv_.notify_all();
+        }
+    }
+
+    std::unique_ptr<CuPolicy> policy_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    std::condition_variable work_cv_, idle_cv_;
+    int next_id_ = 0;
+    bool stop_ = false;
+    std::string error_;
+};
@@ -0,0 +1,445 @@
+// Thin client and load generator for dct_daemon. Loads one image, copies
+// its planes into a memfd per connection once, then sends requests over
+// the daemon's socket and reports round-trip latency (p50/p90/p99/max)
+// and throughput. The first result is checked: coefficients against the
+// CPU golden, JPEG bytes by decoding them again and measuring PSNR.
+//
+//   dct_client <socket> <input.png> [--requests N] [--concurrency C]
+//              [--jpeg out.jpg] [--quality Q]
+//
+// With --ring NAME the socket is not used: --procs producer processes
+// submit through the daemon's shared-memory ring (dct_ring.hpp), each
+// keeping --depth slots in flight, and every result is checked.
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/wait.h>
+
+#include "jpeg_cpu.hpp"
+#include "tiles.hpp"
+#include "dct_ipc.hpp"
+#include "dct_ring.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+struct ClientOptions {
+    int requests = 100;
+    int concurrency = 1;
+    bool jpeg = false;
+    std::string jpeg_out;       // write the first JPEG here
+    int quality = 75;
+    std::string ring;           // submit through this shared-memory ring
+    int procs = 4;              // ... from this many producer processes
+    int depth = 4;              // ... each with this many slots in flight
+};
+
+// What one connection saw
+struct ConnResult {
+    vector<double> rtt_ms, service_ms;
+    int errors = 0;
+    vector<uint8_t> first;      // output area of the first good reply
+};
+
+static void run_connection(const std::string& sock_path, const vector<pixel_t>& pixels,
+                           int w, int h, int ch, const ClientOptions& opt, int nreq,
+                           bool keep_first, ConnResult& res)
+{
+    size_t off = dct_ipc_out_offset(w, h, ch);
+    size_t bytes = off + dct_ipc_out_bytes(w, h, ch);
+    int fd = dct_ipc_memfd(bytes);
+    int sock = dct_ipc_connect(sock_path);
+    if (fd < 0 || sock < 0) {
+        cerr << "ERROR: cannot " << (fd < 0 ? "create memfd" : "connect to " + sock_path) << "\n";
+        res.errors = nreq;
+        if (fd >= 0) close(fd);
+        if (sock >= 0) close(sock);
+        return;
+    }
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        cerr << "ERROR: cannot map the memfd: " << strerror(errno) << "\n";
+        res.errors = nreq;
+        close(fd);
+        close(sock);
+        return;
+    }
+    uint8_t* map = (uint8_t*)p;
+    std::copy(pixels.begin(), pixels.end(), map);
+
+    DctIpcRequest req = {};
+    req.magic = DCT_IPC_MAGIC;
+    req.op = opt.jpeg ? DCT_IPC_JPEG : DCT_IPC_COEFFS;
+    req.width = w;
+    req.height = h;
+    req.channels = ch;
+    req.quality = opt.quality;
+    for (int i = 0; i < nreq; i++) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        DctIpcReply reply;
+        if (!dct_ipc_send(sock, &req, sizeof(req), i == 0 ? fd : -1) ||
+            !dct_ipc_recv(sock, &reply, sizeof(reply))) {
+            cerr << "ERROR: daemon closed the connection\n";
+            res.errors += nreq - i;
+            break;
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        if (reply.magic != DCT_IPC_MAGIC || reply.status) {
+            res.errors++;
+            continue;
+        }
+        res.rtt_ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        res.service_ms.push_back(reply.service_ms);
+        if (keep_first && res.first.empty())
+            res.first.assign(map + off, map + off + reply.out_bytes);
+    }
+    munmap(map, bytes);
+    close(fd);
+    close(sock);
+}
+
+// CPU golden of ch planes, laid out like the daemon's reply
+static void golden_coeffs(const vector<pixel_t>& pixels, int w, int h, int ch,
+                          vector<coeff_t>& gold)
+{
+    size_t np = size_t(w) * h;
+    gold.resize(ch * np);
+    vector<pixel_t> plane, tiles;
+    vector<coeff_t> tcoef, out;
+    for (int c = 0; c < ch; c++) {
+        plane.assign(pixels.begin() + c * np, pixels.begin() + (c + 1) * np);
+        raster_to_tiles(plane, w, h, tiles);
+        tcoef.resize(tiles.size());
+        cpu_dct_tiles(tiles.data(), tiles.size() / 64, tcoef.data());
+        tiles_to_raster(tcoef, w, h, out);
+        std::copy(out.begin(), out.end(), gold.begin() + c * np);
+    }
+}
+
+// Coefficient mismatches of the reply against the CPU golden
+static long check_coeffs(const vector<uint8_t>& out, const vector<pixel_t>& pixels,
+                         int w, int h, int ch)
+{
+    size_t n = size_t(w) * h * ch;
+    if (out.size() != n * sizeof(coeff_t)) return (long)n;
+    const coeff_t* got = (const coeff_t*)out.data();
+    vector<coeff_t> gold;
+    golden_coeffs(pixels, w, h, ch, gold);
+    long diff = 0;
+    for (size_t i = 0; i < n; i++)
+        if (got[i] != gold[i]) diff++;
+    return diff;
+}
+
+// What a ring producer process reports back (in memory shared with the parent)
+struct RingResult {
+    long ok;
+    long failed;
+    long mismatches;
+};
+
+// One producer process: its own variant of the image (pixels offset by the
+// producer index, so a slot delivered to the wrong process shows up as
+// mismatches), up to depth submissions in flight, every result checked
+// against the golden. Latencies go to lat[0, nreq).
+static void ring_producer(const std::string& name, vector<pixel_t> pixels, int w, int h, int ch,
+                          int index, int nreq, int depth, double* lat, RingResult& res)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    const int TIMEOUT_MS = 5000;
+    DctRing ring;
+    int me = -1;
+    if (!ring.open(name) || (me = ring.register_producer()) < 0) {
+        cerr << "ERROR: producer " << index << " cannot attach to ring " << name << "\n";
+        res.failed = nreq;
+        return;
+    }
+    if (w > ring.max_width() || h > ring.max_height()) {
+        cerr << "ERROR: image larger than the ring's slots (" << ring.max_width() << "x"
+             << ring.max_height() << ")\n";
+        res.failed = nreq;
+        ring.unregister_producer(me);
+        return;
+    }
+    for (auto& p : pixels) p = pixel_t(p + 7 * index);
+    vector<coeff_t> gold;
+    golden_coeffs(pixels, w, h, ch, gold);
+    size_t np = size_t(w) * h;
+
+    vector<Clock::time_point> t_submit(ring.num_slots());
+    int sent = 0, done = 0, inflight = 0;
+    while (done < nreq) {
+        uint32_t i;
+        while (sent < nreq && inflight < depth && ring.acquire_slot(i, inflight ? 0 : TIMEOUT_MS)) {
+            for (int c = 0; c < ch; c++)
+                std::copy(pixels.begin() + c * np, pixels.begin() + (c + 1) * np, ring.pixels(i, c));
+            DctRingSlot& d = ring.slot(i);
+            d.width = w;
+            d.height = h;
+            d.channels = ch;
+            d.producer = me;
+            d.user_data = sent++;
+            t_submit[i] = Clock::now();
+            ring.submit(i);
+            inflight++;
+        }
+        if (!inflight || !ring.reap(me, i, TIMEOUT_MS)) {
+            cerr << "ERROR: producer " << index << " timed out waiting for the daemon\n";
+            break;
+        }
+        DctRingSlot& d = ring.slot(i);
+        lat[d.user_data] = std::chrono::duration<double, std::milli>(Clock::now() - t_submit[i]).count();
+        if (d.status) {
+            res.failed++;
+        } else {
+            res.ok++;
+            for (int c = 0; c < ch; c++) {
+                const coeff_t* got = ring.coeffs(i, c);
+                for (size_t k = 0; k < np; k++)
+                    if (got[k] != gold[c * np + k]) res.mismatches++;
+            }
+        }
+        ring.release_slot(i);
+        inflight--;
+        done++;
+    }
+    res.failed += nreq - done;
+    ring.unregister_producer(me);
+}
+
+// Fork the producers, wait for them and report; exit status of the run
+static int run_ring(const ClientOptions& opt, const vector<pixel_t>& pixels, int w, int h, int ch)
+{
+    // Latencies and per-process results live in memory shared with the children
+    size_t bytes = opt.requests * sizeof(double) + opt.procs * sizeof(RingResult);
+    void* shared = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        cerr << "ERROR: cannot map result memory\n";
+        return 1;
+    }
+    double* lat = (double*)shared;
+    RingResult* results = (RingResult*)(lat + opt.requests);
+    std::fill(lat, lat + opt.requests, -1.0);
+    std::fill(results, results + opt.procs, RingResult{0, 0, 0});
+
+    cout << std::flush;             // or the children repeat what is buffered
+    auto t0 = std::chrono::high_resolution_clock::now();
+    vector<pid_t> kids;
+    int first = 0;
+    for (int p = 0; p < opt.procs; p++) {
+        int nreq = opt.requests / opt.procs + (p < opt.requests % opt.procs);
+        pid_t pid = fork();
+        if (pid == 0) {
+            ring_producer(opt.ring, pixels, w, h, ch, p, nreq, opt.depth, lat + first, results[p]);
+            _exit(0);
+        }
+        if (pid < 0) {
+            cerr << "ERROR: fork failed\n";
+            break;
+        }
+        kids.push_back(pid);
+        first += nreq;
+    }
+    for (pid_t k : kids) waitpid(k, nullptr, 0);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double wall_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    RingResult total = {0, 0, 0};
+    for (int p = 0; p < opt.procs; p++) {
+        total.ok += results[p].ok;
+        total.failed += results[p].failed;
+        total.mismatches += results[p].mismatches;
+    }
+    total.failed += opt.requests - first;
+    vector<double> v;
+    for (int i = 0; i < opt.requests; i++)
+        if (lat[i] >= 0) v.push_back(lat[i]);
+    munmap(shared, bytes);
+
+    size_t np = size_t(w) * h;
+    cout << std::fixed << std::setprecision(3);
+    cout << "\n=== RING SUBMISSIONS ===\n";
+    cout << "Producers:          " << kids.size() << " processes, " << opt.depth << " in flight each\n";
+    cout << "Requests:           " << total.ok << " ok, " << total.failed << " failed\n";
+    cout << "Throughput:         " << total.ok / (wall_ms / 1000.0) << " req/s, "
+         << total.ok * np / 1e6 / (wall_ms / 1000.0) << " MP/s\n";
+    cout << "Latency p50:        " << latency_percentile(v, 50) << " ms\n";
+    cout << "Latency p90:        " << latency_percentile(v, 90) << " ms\n";
+    cout << "Latency p99:        " << latency_percentile(v, 99) << " ms\n";
+    cout << "Latency max:        " << latency_percentile(v, 100) << " ms\n";
+    cout << "Coefficient mismatches: " << total.mismatches << "\n";
+    return total.failed || total.mismatches ? 1 : 0;
+}
+
+// PSNR of the decoded JPEG against the input, averaged over channels
+static double check_jpeg(const vector<uint8_t>& jpg, const vector<pixel_t>& pixels,
+                         int w, int h, int ch)
+{
+    int dw, dh, dch;
+    unsigned char* img = stbi_load_from_memory(jpg.data(), (int)jpg.size(), &dw, &dh, &dch, ch);
+    if (!img || dw != w || dh != h) {
+        if (img) stbi_image_free(img);
+        return -1;
+    }
+    size_t np = size_t(w) * h;
+    double psnr = 0;
+    vector<pixel_t> orig(np), recon(np);
+    for (int c = 0; c < ch; c++) {
+        for (size_t i = 0; i < np; i++) recon[i] = img[i * ch + c];
+        std::copy(pixels.begin() + c * np, pixels.begin() + (c + 1) * np, orig.begin());
+        psnr += compute_psnr_channel(orig, recon);
+    }
+    stbi_image_free(img);
+    return psnr / ch;
+}
+
+static void print_usage(const char* prog)
+{
+    cerr << "Usage: " << prog << " <socket> <input.png> [options]\n"
+         << "  --requests N      requests in total (default 100)\n"
+         << "  --concurrency C   connections sending in parallel (default 1)\n"
+         << "  --jpeg FILE       ask for JPEG bytes instead of coefficients, save the first\n"
+         << "  --quality Q       JPEG quality 1-100 (default 75)\n"
+         << "  --ring NAME       submit through the daemon's shared-memory ring instead\n"
+         << "  --procs P         ring producer processes (default 4)\n"
+         << "  --depth D         ring submissions in flight per producer (default 4)\n";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    std::string sock_path = argv[1];
+    std::string input_png = argv[2];
+    ClientOptions opt;
+    for (int i = 3; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--requests" && i + 1 < argc) {
+            opt.requests = atoi(argv[++i]);
+        } else if (a == "--concurrency" && i + 1 < argc) {
+            opt.concurrency = atoi(argv[++i]);
+        } else if (a == "--jpeg" && i + 1 < argc) {
+            opt.jpeg = true;
+            opt.jpeg_out = argv[++i];
+        } else if (a == "--quality" && i + 1 < argc) {
+            opt.quality = atoi(argv[++i]);
+        } else if (a == "--ring" && i + 1 < argc) {
+            opt.ring = argv[++i];
+        } else if (a == "--procs" && i + 1 < argc) {
+            opt.procs = atoi(argv[++i]);
+        } else if (a == "--depth" && i + 1 < argc) {
+            opt.depth = atoi(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (opt.requests < 1 || opt.concurrency < 1 || opt.procs < 1 || opt.depth < 1) {
+        cerr << "ERROR: --requests, --concurrency, --procs and --depth must be positive\n";
+        return 1;
+    }
+    if (!opt.ring.empty() && opt.jpeg) {
+        cerr << "ERROR: the ring returns coefficients; drop --jpeg\n";
+        return 1;
+    }
+    opt.procs = std::min(opt.procs, opt.requests);
+    opt.concurrency = std::min(opt.concurrency, opt.requests);
+
+    // Grayscale inputs are sent as one plane, like host.exe handles them
+    int w, h, file_ch;
+    if (!stbi_info(input_png.c_str(), &w, &h, &file_ch)) {
+        cerr << "ERROR: Cannot load input image\n";
+        return 1;
+    }
+    const int ch = file_ch <= 2 ? 1 : 3;
+    unsigned char* img = stbi_load(input_png.c_str(), &w, &h, &file_ch, ch);
+    if (!img) {
+        cerr << "ERROR: Cannot load input image\n";
+        return 1;
+    }
+    size_t np = size_t(w) * h;
+    vector<pixel_t> pixels(np * ch);
+    for (size_t i = 0; i < np; i++)
+        for (int c = 0; c < ch; c++) pixels[c * np + i] = img[i * ch + c];
+    stbi_image_free(img);
+    cout << "Loaded " << w << "x" << h << " (" << ch << " channel" << (ch > 1 ? "s" : "") << ")\n";
+
+    if (!opt.ring.empty()) return run_ring(opt, pixels, w, h, ch);
+
+    vector<ConnResult> res(opt.concurrency);
+    vector<std::thread> threads;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < opt.concurrency; i++) {
+        int nreq = opt.requests / opt.concurrency + (i < opt.requests % opt.concurrency);
+        threads.emplace_back(run_connection, std::cref(sock_path), std::cref(pixels), w, h, ch,
+                             std::cref(opt), nreq, i == 0, std::ref(res[i]));
+    }
+    for (auto& t : threads) t.join();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double wall_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    vector<double> rtt, service;
+    int errors = 0;
+    for (auto& r : res) {
+        rtt.insert(rtt.end(), r.rtt_ms.begin(), r.rtt_ms.end());
+        service.insert(service.end(), r.service_ms.begin(), r.service_ms.end());
+        errors += r.errors;
+    }
+    double mean_rtt = 0, mean_service = 0;
+    for (double v : rtt) mean_rtt += v;
+    for (double v : service) mean_service += v;
+    if (!rtt.empty()) {
+        mean_rtt /= rtt.size();
+        mean_service /= service.size();
+    }
+
+    cout << std::fixed << std::setprecision(3);
+    cout << "\n=== DAEMON " << (opt.jpeg ? "JPEG" : "COEFFICIENT") << " REQUESTS ===\n";
+    cout << "Requests:           " << rtt.size() << " ok, " << errors << " failed, "
+         << opt.concurrency << " connection(s)\n";
+    cout << "Throughput:         " << rtt.size() / (wall_ms / 1000.0) << " req/s, "
+         << rtt.size() * np / 1e6 / (wall_ms / 1000.0) << " MP/s\n";
+    cout << "Latency p50:        " << latency_percentile(rtt, 50) << " ms\n";
+    cout << "Latency p90:        " << latency_percentile(rtt, 90) << " ms\n";
+    cout << "Latency p99:        " << latency_percentile(rtt, 99) << " ms\n";
+    cout << "Latency max:        " << latency_percentile(rtt, 100) << " ms\n";
+    cout << "Mean service time:  " << mean_service << " ms (IPC + queueing "
+         << mean_rtt - mean_service << " ms)\n";
+
+    const vector<uint8_t>& first = res[0].first;
+    if (first.empty()) {
+        cerr << "ERROR: no request succeeded\n";
+        return 1;
+    }
+    if (opt.jpeg) {
+        std::ofstream(opt.jpeg_out, std::ios::binary)
+            .write((const char*)first.data(), first.size());
+        double psnr = check_jpeg(first, pixels, w, h, ch);
+        cout << "JPEG:               " << first.size() << " bytes ("
+             << std::setprecision(2) << 8.0 * first.size() / (np) << " bpp) -> " << opt.jpeg_out << "\n";
+        if (psnr < 0) {
+            cerr << "ERROR: the JPEG does not decode\n";
+            return 1;
+        }
+        cout << "Decoded PSNR:       " << psnr << " dB\n";
+    } else {
+        long diff = check_coeffs(first, pixels, w, h, ch);
+        cout << "Coefficient mismatches: " << diff << " / " << ch * np << "\n";
+        if (diff) return 1;
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,573 @@
+// Long-running DCT service. It opens the card and loads the xclbin once,
+// keeps one XrtUnit per compute unit with its buffers already allocated
+// (or a set of emulated units), and serves dct_ipc.hpp requests from any
+// number of local clients over a Unix socket, so a run no longer pays for
+// device open, xclbin load and buffer allocation.
+//
+//   dct_daemon <xclbin | emu:N> <socket> [--variant N] [--warm WxH]
+//              [--ring NAME [--ring-slots N] [--ring-max WxH]]
+//
+// Every connection gets its own thread; requests share the units through
+// a pool, one job per unit at a time. With --ring the daemon also serves
+// the shared-memory submission ring of dct_ring.hpp, one thread per unit.
+#include <xrt/xrt_device.h>
+#include <xrt/xrt_kernel.h>
+#include <xrt/xrt_bo.h>
+
+#include <sys/stat.h>
+#include <poll.h>
+#include <signal.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <set>
+#include <cstdlib>
+#include <cstring>
+
+#include "jpeg_cpu.hpp"
+#include "parallel.hpp"
+#include "color.hpp"
+#include "planes.hpp"
+#include "dct_units.hpp"
+#include "jfif.hpp"
+#include "dct_ipc.hpp"
+#include "dct_ring.hpp"
+
+using std::vector;
+using std::cout;
+using std::cerr;
+
+// Largest accepted image side
+static const int MAX_SIDE = 16384;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int) { g_stop = 1; }
+
+// Units shared by all connections; a request holds one for its kernel run
+class UnitPool {
+public:
+    explicit UnitPool(vector<std::unique_ptr<DctUnit>> units) : units_(std::move(units))
+    {
+        for (auto& u : units_) free_.push_back(u.get());
+    }
+
+    int size() const { return (int)units_.size(); }
+
+    DctUnit& unit(int i) { return *units_[i]; }
+
+    void run(const DctJob& job)
+    {
+        DctUnit* u;
+        {
+            std::unique_lock<std::mutex> lock(m_);
+            cv_.wait(lock, [this] { return !free_.empty(); });
+            u = free_.back();
+            free_.pop_back();
+        }
+        struct Release {
+            UnitPool& p;
+            DctUnit* u;
+            ~Release()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(p.m_);
+                    p.free_.push_back(u);
+                }
+                p.cv_.notify_one();
+            }
+        } release{*this, u};
+        u->run(job);
+    }
+
+private:
+    vector<std::unique_ptr<DctUnit>> units_;
+    vector<DctUnit*> free_;
+    std::mutex m_;
+    std::condition_variable cv_;
+};
+
+// Service times of completed requests, per operation
+class ServiceLog {
+public:
+    void add(uint32_t op, double ms)
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        (op == DCT_IPC_JPEG ? jpeg_ : coeffs_).push_back(ms);
+    }
+
+    void add_ring(double ms)
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        ring_.push_back(ms);
+    }
+
+    void error()
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        errors_++;
+    }
+
+    void print()
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        cout << "\n=== SERVICE TIME (inside the daemon) ===\n";
+        print_row("coeffs", coeffs_);
+        print_row("jpeg", jpeg_);
+        print_row("ring", ring_);
+        cout << "Failed requests: " << errors_ << "\n";
+    }
+
+private:
+    static void print_row(const char* name, vector<double>& v)
+    {
+        cout << std::left << std::setw(8) << name << std::right << std::setw(8) << v.size()
+             << " requests";
+        if (!v.empty())
+            cout << std::fixed << std::setprecision(3)
+                 << "  p50 " << latency_percentile(v, 50) << " ms"
+                 << "  p99 " << latency_percentile(v, 99) << " ms"
+                 << "  max " << latency_percentile(v, 100) << " ms";
+        cout << "\n";
+    }
+
+    std::mutex m_;
+    vector<double> coeffs_, jpeg_, ring_;
+    long errors_ = 0;
+};
+
+// Open client sockets, so shutdown can end the connections' reads
+class ConnSet {
+public:
+    void add(int fd)
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        open_.insert(fd);
+    }
+
+    void close_fd(int fd)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            open_.erase(fd);
+            close(fd);
+        }
+        cv_.notify_all();
+    }
+
+    // Connections finish the request in flight, then see end of stream
+    void drain()
+    {
+        std::unique_lock<std::mutex> lock(m_);
+        for (int fd : open_) shutdown(fd, SHUT_RD);
+        cv_.wait(lock, [this] { return open_.empty(); });
+    }
+
+private:
+    std::mutex m_;
+    std::set<int> open_;
+    std::condition_variable cv_;
+};
+
+// Per-connection mapping of the client's memfd and scratch planes, reused
+// from request to request
+struct Session {
+    uint8_t* map = nullptr;
+    size_t map_bytes = 0;
+    vector<pixel_t> plane, pix[3], strips[3];
+    vector<coeff_t> coef[3], strip_coef[3], plane_coef;
+    vector<uint8_t> jpeg;
+
+    ~Session() { unmap(); }
+
+    void unmap()
+    {
+        if (map) munmap(map, map_bytes);
+        map = nullptr;
+        map_bytes = 0;
+    }
+
+    // Unsealed descriptors are refused (requests then fail with EBADF):
+    // the client could shrink the file under the mapping
+    bool remap(int fd)
+    {
+        unmap();
+        struct stat st;
+        if (dct_ipc_sealed(fd) && fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) {
+                map = (uint8_t*)p;
+                map_bytes = size_t(st.st_size);
+            }
+        }
+        close(fd);
+        return map != nullptr;
+    }
+};
+
+// Raw coefficients of nplanes (1 or 3) w x h planes on one pooled unit.
+// A single plane is cut into three strips (planes.hpp) so it takes one
+// launch of a third of the rows instead of occupying all three channels.
+static void transform(UnitPool& pool, Session& s, const pixel_t* const in[], int nplanes,
+                      int w, int h, coeff_t* const out[])
+{
+    DctJob job;
+    if (nplanes == 3) {
+        for (int c = 0; c < 3; c++) {
+            job.in[c] = in[c];
+            job.out[c] = out[c];
+        }
+        job.width = w;
+        job.height = h;
+        pool.run(job);
+        return;
+    }
+    StripPacking p = strip_packing(w, h);
+    s.plane.assign(in[0], in[0] + size_t(w) * h);
+    strip_pack(s.plane, w, h, p, s.strips);
+    for (int c = 0; c < 3; c++) {
+        s.strip_coef[c].resize(size_t(p.width) * p.height);
+        job.in[c] = s.strips[c].data();
+        job.out[c] = s.strip_coef[c].data();
+    }
+    job.width = p.width;
+    job.height = p.height;
+    pool.run(job);
+    strip_unpack(s.strip_coef, w, h, p, s.plane_coef);
+    std::copy(s.plane_coef.begin(), s.plane_coef.end(), out[0]);
+}
+
+// Repeat the last column and row of a w x h image out to pw x ph in place
+static void pad_edges(pixel_t* p, int w, int h, int pw, int ph)
+{
+    for (int y = 0; y < h; y++)
+        std::fill(p + size_t(y) * pw + w, p + size_t(y) * pw + pw, p[size_t(y) * pw + w - 1]);
+    for (int y = h; y < ph; y++)
+        std::copy(p + size_t(h - 1) * pw, p + size_t(h) * pw, p + size_t(y) * pw);
+}
+
+// Quantize every block of a pw x ph coefficient plane in place
+static void quantize_plane(coeff_t* plane, int pw, int ph, const QuantTable& qt)
+{
+    parallel_for(0, ph / 8, host_num_threads(), [&](int, int lo, int hi) {
+        coeff_t blk[8][8], q[8][8];
+        for (int by = lo; by < hi; by++) {
+            for (int bx = 0; bx < pw; bx += 8) {
+                coeff_t* base = plane + size_t(by) * 8 * pw + bx;
+                for (int y = 0; y < 8; y++)
+                    std::copy(base + size_t(y) * pw, base + size_t(y) * pw + 8, blk[y]);
+                quant_block(blk, q, qt);
+                for (int y = 0; y < 8; y++)
+                    std::copy(q[y], q[y] + 8, base + size_t(y) * pw);
+            }
+        }
+    });
+}
+
+// Baseline JFIF of the request's image into s.jpeg: RGB goes to YCbCr
+// 4:4:4, planes are padded to whole blocks by edge replication, the unit
+// transforms them and the host quantizes and entropy-codes
+static void encode_jpeg(UnitPool& pool, Session& s, const pixel_t* const in[], int nplanes,
+                        int w, int h, int quality)
+{
+    int pw = round_up8(w), ph = round_up8(h);
+    size_t np = size_t(pw) * ph;
+    for (int c = 0; c < nplanes; c++) {
+        s.pix[c].resize(np);
+        s.coef[c].resize(np);
+    }
+    if (nplanes == 3)
+        rgb_to_ycc444(in[0], in[1], in[2], w, h,
+                      s.pix[0].data(), s.pix[1].data(), s.pix[2].data(), pw);
+    else
+        copy_rect(in[0], w, s.pix[0].data(), pw, w, h);
+    for (int c = 0; c < nplanes; c++) pad_edges(s.pix[c].data(), w, h, pw, ph);
+
+    const pixel_t* pin[3] = { s.pix[0].data(), s.pix[1].data(), s.pix[2].data() };
+    coeff_t* pout[3] = { s.coef[0].data(), s.coef[1].data(), s.coef[2].data() };
+    transform(pool, s, pin, nplanes, pw, ph, pout);
+
+    QuantTable qt[2];
+    jfif_quant_table(qt[0], Q_luma, quality);
+    jfif_quant_table(qt[1], Q_chroma, quality);
+    const QuantTable* tabs[3] = { &qt[0], &qt[1], &qt[1] };
+    for (int c = 0; c < nplanes; c++) quantize_plane(pout[c], pw, ph, *tabs[c]);
+    jfif_encode(pout, tabs, nplanes, w, h, pw, ph, s.jpeg);
+}
+
+// errno-style status of one request; on success reply.out_bytes is set
+static int serve_request(UnitPool& pool, Session& s, const DctIpcRequest& req, DctIpcReply& reply)
+{
+    int w = (int)req.width, h = (int)req.height, ch = (int)req.channels;
+    if (req.magic != DCT_IPC_MAGIC || (req.op != DCT_IPC_COEFFS && req.op != DCT_IPC_JPEG) ||
+        (ch != 1 && ch != 3) || w < 1 || h < 1 || w > MAX_SIDE || h > MAX_SIDE)
+        return EINVAL;
+    if (!s.map) return EBADF;
+    size_t off = dct_ipc_out_offset(w, h, ch);
+    if (off > s.map_bytes) return ENOSPC;
+    size_t room = s.map_bytes - off;
+
+    size_t np = size_t(w) * h;
+    const pixel_t* in[3];
+    for (int c = 0; c < ch; c++) in[c] = s.map + c * np;
+
+    try {
+        if (req.op == DCT_IPC_COEFFS) {
+            if (room < ch * np * sizeof(coeff_t)) return ENOSPC;
+            coeff_t* out[3];
+            for (int c = 0; c < ch; c++) out[c] = (coeff_t*)(s.map + off) + c * np;
+            transform(pool, s, in, ch, w, h, out);
+            reply.out_bytes = ch * np * sizeof(coeff_t);
+        } else {
+            int q = std::max(1, std::min(100, (int)req.quality));
+            encode_jpeg(pool, s, in, ch, w, h, q);
+            if (s.jpeg.size() > room) return ENOSPC;
+            std::copy(s.jpeg.begin(), s.jpeg.end(), s.map + off);
+            reply.out_bytes = s.jpeg.size();
+        }
+    } catch (const std::exception& e) {
+        cerr << "ERROR: " << e.what() << "\n";
+        return EIO;
+    }
+    return 0;
+}
+
+static void serve_connection(int sock, UnitPool& pool, ServiceLog& log, ConnSet& conns)
+{
+    Session s;
+    DctIpcRequest req;
+    int fd;
+    while (dct_ipc_recv(sock, &req, sizeof(req), &fd)) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        if (fd >= 0) s.remap(fd);
+        DctIpcReply reply = {};
+        reply.magic = DCT_IPC_MAGIC;
+        reply.status = serve_request(pool, s, req, reply);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        reply.service_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (reply.status) log.error();
+        else log.add(req.op, reply.service_ms);
+        if (!dct_ipc_send(sock, &reply, sizeof(reply))) break;
+    }
+    conns.close_fd(sock);
+}
+
+// Ring worker: takes submissions and transforms each slot in place; the
+// image's planes start at the slot planes with a row stride of its width
+static void serve_ring(DctRing& ring, UnitPool& pool, ServiceLog& log)
+{
+    Session s;
+    uint32_t i;
+    auto last_sweep = std::chrono::steady_clock::now();
+    while (!g_stop) {
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sweep > std::chrono::seconds(1)) {
+            if (int n = ring.reclaim_dead())
+                cout << "Ring: reclaimed " << n << " slot(s) of exited producers\n";
+            last_sweep = now;
+        }
+        if (!ring.next_submission(i, 200)) continue;
+        if (!ring.claim_submission(i)) {
+            log.error();                    // stray index: nothing to free or tell
+            continue;
+        }
+        auto t0 = std::chrono::high_resolution_clock::now();
+        // The producer can still write the descriptor, so each field is
+        // read once and only the copies are used
+        DctRingSlot& d = ring.slot(i);
+        const uint32_t producer = d.producer;
+        const int32_t submitter = d.owner;
+        int w = (int)d.width, h = (int)d.height, ch = (int)d.channels;
+        if (producer >= (uint32_t)DCT_RING_MAX_PRODUCERS) {
+            ring.release_slot(i);           // nobody to tell
+            log.error();
+            continue;
+        }
+        d.status = 0;
+        if ((ch != 1 && ch != 3) || w < 1 || h < 1 || w > ring.max_width() || h > ring.max_height()) {
+            d.status = EINVAL;
+        } else {
+            const pixel_t* in[3];
+            coeff_t* out[3];
+            for (int c = 0; c < ch; c++) {
+                in[c] = ring.pixels(i, c);
+                out[c] = ring.coeffs(i, c);
+            }
+            try {
+                transform(pool, s, in, ch, w, h, out);
+            } catch (const std::exception& e) {
+                cerr << "ERROR: " << e.what() << "\n";
+                d.status = EIO;
+            }
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        d.service_ms = (float)std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (d.status) log.error();
+        else log.add_ring(d.service_ms);
+        ring.complete(i, producer, submitter);  // frees the slot if the producer is gone
+    }
+}
+
+// One job of w x h zero planes through every unit, so buffers are
+// allocated and the first-launch cost is paid before clients arrive
+static void warm_up(UnitPool& pool, int w, int h)
+{
+    vector<pixel_t> in(size_t(w) * h, 0);
+    vector<coeff_t> out[3];
+    DctJob job;
+    for (int c = 0; c < 3; c++) {
+        out[c].resize(in.size());
+        job.in[c] = in.data();
+        job.out[c] = out[c].data();
+    }
+    job.width = w;
+    job.height = h;
+    for (int i = 0; i < pool.size(); i++) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        pool.unit(i).run(job);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        cout << "  " << pool.unit(i).name() << " warm (" << w << "x" << h << "): "
+             << std::fixed << std::setprecision(3)
+             << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms\n";
+    }
+}
+
+// v4 appends qtab and quant_en to the v1-v3 argument list, so the
+// xclbin's own metadata tells the two apart whatever the file is called
+static int variant_from_kernel_args(const std::string& xclbin_file)
+{
+    for (auto& k : xrt::xclbin(xclbin_file).get_kernels())
+        if (k.get_name() == "dct_accel") return k.get_num_args() >= 10 ? 4 : 3;
+    return 3;
+}
+
+static void print_usage(const char* prog)
+{
+    cerr << "Usage: " << prog << " <xclbin | emu:N> <socket> [options]\n"
+         << "  --variant N   kernel argument list (default: from the kernel's arguments; v1-v4)\n"
+         << "  --warm WxH    size of the warm-up job per unit (default 1920x1080)\n"
+         << "  --ring NAME   also serve the shared-memory ring NAME (shm_open name, \"/dct\")\n"
+         << "  --ring-slots N   ring slots (default 16, at most " << DCT_RING_MAX_SLOTS << ")\n"
+         << "  --ring-max WxH   largest image a slot holds (default 1920x1080)\n";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    std::string backend = argv[1];
+    std::string sock_path = argv[2];
+    int variant = 0, warm_w = 1920, warm_h = 1080;
+    std::string ring_name;
+    int ring_slots = 16, ring_w = 1920, ring_h = 1080;
+    for (int i = 3; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--variant" && i + 1 < argc) {
+            variant = atoi(argv[++i]);
+        } else if (a == "--warm" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &warm_w, &warm_h) != 2 || warm_w < 1 || warm_h < 1) {
+                cerr << "ERROR: --warm takes WxH\n";
+                return 1;
+            }
+        } else if (a == "--ring" && i + 1 < argc) {
+            ring_name = argv[++i];
+        } else if (a == "--ring-slots" && i + 1 < argc) {
+            ring_slots = atoi(argv[++i]);
+        } else if (a == "--ring-max" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &ring_w, &ring_h) != 2 || ring_w < 1 || ring_h < 1) {
+                cerr << "ERROR: --ring-max takes WxH\n";
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Raw transforms only: the JPEG path quantizes on the host at the
+    // quality each request asks for
+    QuantTable qtabs[3];
+    for (int c = 0; c < 3; c++) quant_table_init(qtabs[c], c ? Q_chroma : Q_luma, 50);
+
+    vector<std::unique_ptr<DctUnit>> units;
+    xrt::device device;
+    if (backend.compare(0, 4, "emu:") == 0) {
+        int n = atoi(backend.c_str() + 4);
+        if (n < 1) {
+            cerr << "ERROR: emu:N needs at least one unit\n";
+            return 1;
+        }
+        for (int i = 0; i < n; i++)
+            units.emplace_back(new EmuUnit("emu:" + std::to_string(i), qtabs));
+    } else {
+        if (variant == 0) variant = variant_from_kernel_args(backend);
+        if (variant < 1 || variant > 4) {
+            cerr << "ERROR: the daemon drives raster v1-v4 kernels\n";
+            return 1;
+        }
+        vector<std::string> names = discover_cus(backend, "dct_accel");
+        if (names.empty()) names.push_back("dct_accel");
+        cout << "Opening device 0 (" << names.size() << " compute units)...\n";
+        device = xrt::device(0);
+        auto uuid = device.load_xclbin(backend);
+        vector<uint32_t> qwords;
+        pack_quant_tables(qtabs, qwords);
+        for (auto& n : names)
+            units.emplace_back(new XrtUnit(device, uuid, n, variant, qwords));
+    }
+    UnitPool pool(std::move(units));
+    warm_up(pool, warm_w, warm_h);
+
+    int lsock = dct_ipc_listen(sock_path);
+    if (lsock < 0) {
+        cerr << "ERROR: cannot listen on " << sock_path << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    struct sigaction sa = {};
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    ServiceLog log;
+    DctRing ring;
+    vector<std::thread> ring_workers;
+    if (!ring_name.empty()) {
+        if (ring_slots < 1 || !ring.create(ring_name, ring_slots, ring_w, ring_h)) {
+            cerr << "ERROR: cannot create ring " << ring_name << "\n";
+            return 1;
+        }
+        for (int i = 0; i < pool.size(); i++)
+            ring_workers.emplace_back(serve_ring, std::ref(ring), std::ref(pool), std::ref(log));
+        cout << "Ring " << ring_name << ": " << ring.num_slots() << " slots of up to "
+             << ring_w << "x" << ring_h << "\n";
+    }
+    cout << "Serving on " << sock_path << " with " << pool.size() << " unit(s)\n" << std::flush;
+
+    ConnSet conns;
+    while (!g_stop) {
+        pollfd pfd = { lsock, POLLIN, 0 };
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        int c = accept4(lsock, nullptr, nullptr, SOCK_CLOEXEC);
+        if (c < 0) continue;
+        conns.add(c);
+        std::thread(serve_connection, c, std::ref(pool), std::ref(log), std::ref(conns)).detach();
+    }
+
+    // Stop taking connections, let open ones finish the request in flight
+    close(lsock);
+    unlink(sock_path.c_str());
+    conns.drain();
+    for (auto& t : ring_workers) t.join();
+    log.print();
+    return 0;
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <string>
+
+// Wire protocol between dct_daemon and its clients over a Unix stream
+// socket. Pixels and results never cross the socket: the client owns a
+// memfd laid out as
+//   [ pixel planes: channels x w x h ][ pad to 64 ][ output area ]
+// and passes the descriptor (SCM_RIGHTS) with its first request; the
+// daemon maps it once per connection and keeps the mapping until another
+// descriptor arrives. The memfd must be sealed against resizing
+// (DCT_IPC_SEALS), or the daemon refuses it: a file shrunk under its
+// mapping would fault the daemon on the next request. Each request is
+// one fixed-size header, answered by one fixed-size reply once the
+// output area holds the result:
+//   DCT_IPC_COEFFS  channels x w x h coeff_t planes (cpu_dct_image layout)
+//   DCT_IPC_JPEG    a baseline JFIF file of reply.out_bytes bytes
+
+static const uint32_t DCT_IPC_MAGIC = 0x31544344;   // "DCT1"
+static const int DCT_IPC_SEALS = F_SEAL_SHRINK | F_SEAL_GROW;
+
+enum DctIpcOp : uint32_t {
+    DCT_IPC_COEFFS = 1,
+    DCT_IPC_JPEG   = 2,
+};
+
+struct DctIpcRequest {
+    uint32_t magic;
+    uint32_t op;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;      // 1 (gray) or 3 (RGB)
+    uint32_t quality;       // DCT_IPC_JPEG only
+};
+
+struct DctIpcReply {
+    uint32_t magic;
+    int32_t  status;        // 0 or an errno value
+    uint64_t out_bytes;     // bytes written to the output area
+    double   service_ms;    // time inside the daemon, for IPC overhead
+};
+
+inline size_t dct_ipc_pixel_bytes(int w, int h, int channels)
+{
+    return size_t(w) * h * channels;
+}
+
+inline size_t dct_ipc_out_offset(int w, int h, int channels)
+{
+    return (dct_ipc_pixel_bytes(w, h, channels) + 63) & ~size_t(63);
+}
+
+// Output area large enough for the coefficients, and for any JPEG of the
+// image short of pathological quality-100 noise
+inline size_t dct_ipc_out_bytes(int w, int h, int channels)
+{
+    return size_t(w) * h * channels * 2 + 4096;
+}
+
+// Anonymous shared memory of `bytes` bytes, sealed at that size; -1 on
+// failure
+inline int dct_ipc_memfd(size_t bytes)
+{
+    int fd = memfd_create("dct_ipc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, (off_t)bytes) != 0 || fcntl(fd, F_ADD_SEALS, DCT_IPC_SEALS) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// True when fd carries the seals the daemon needs before mapping it
+inline bool dct_ipc_sealed(int fd)
+{
+    int seals = fcntl(fd, F_GET_SEALS);
+    return seals >= 0 && (seals & DCT_IPC_SEALS) == DCT_IPC_SEALS;
+}
+
+// Send one message, with a descriptor attached when fd >= 0
+inline bool dct_ipc_send(int sock, const void *msg, size_t n, int fd = -1)
+{
+    iovec iov = { const_cast<void *>(msg), n };
+    msghdr mh = {};
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    alignas(cmsghdr) char ctl[CMSG_SPACE(sizeof(int))];
+    if (fd >= 0) {
+        mh.msg_control = ctl;
+        mh.msg_controllen = sizeof(ctl);
+        cmsghdr *cm = CMSG_FIRSTHDR(&mh);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+    }
+    ssize_t r;
+    do {
+        r = sendmsg(sock, &mh, MSG_NOSIGNAL);
+    } while (r < 0 && errno == EINTR);
+    return r == (ssize_t)n;
+}
+
+// Receive one message of exactly n bytes; *fd gets an attached descriptor
+// or -1. False on EOF or error.
+inline bool dct_ipc_recv(int sock, void *msg, size_t n, int *fd = nullptr)
+{
+    if (fd) *fd = -1;
+    size_t got = 0;
+    while (got < n) {
+        iovec iov = { (char *)msg + got, n - got };
+        msghdr mh = {};
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        alignas(cmsghdr) char ctl[CMSG_SPACE(sizeof(int))];
+        mh.msg_control = ctl;
+        mh.msg_controllen = sizeof(ctl);
+        ssize_t r = recvmsg(sock, &mh, MSG_CMSG_CLOEXEC);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        for (cmsghdr *cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+            if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+            int rfd;
+            std::memcpy(&rfd, CMSG_DATA(cm), sizeof(int));
+            if (fd && *fd < 0) *fd = rfd;
+            else close(rfd);
+        }
+        got += size_t(r);
+    }
+    return true;
+}
+
+// Connected client socket, -1 on failure
+inline int dct_ipc_connect(const std::string &path)
+{
+    int s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (s < 0) return -1;
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(s, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+// Listening socket at path (an old socket file is replaced), -1 on failure
+inline int dct_ipc_listen(const std::string &path)
+{
+    int s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (s < 0) return -1;
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(s, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(s, 64) != 0) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+// p-th percentile (0-100, nearest rank) of a set of latencies; sorts v
+inline double latency_percentile(std::vector<double> &v, double p)
+{
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t rank = (size_t)std::ceil(p / 100.0 * v.size());
+    return v[std::min(v.size(), std::max<size_t>(rank, 1)) - 1];
+}
@@ -0,0 +1,492 @@
+#pragma once
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+
+#include <cerrno>
+
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <climits>
+#include <string>
+
+// Shared-memory submission and completion rings between producer
+// processes and dct_daemon (--ring), in the spirit of io_uring. The daemon
+// creates a POSIX shm object holding
+//   - a pool of slots, each with room for three max_w x max_h pixel planes
+//     and their coefficient planes (page aligned, so a backend can DMA
+//     from them directly),
+//   - a free-slot queue and a submission queue: bounded lock-free MPMC
+//     queues of slot indices, so any number of producers push and pop
+//     without a lock or syscall on the fast path,
+//   - one completion ring per registered producer (single producer: the
+//     daemon, single consumer: that producer).
+// A producer pops a free slot, writes its decoded planes straight into it,
+// fills the slot descriptor and pushes the index to the submission queue;
+// the daemon transforms the slot in place and posts the index to the
+// producer's completion ring. Sleepers wait on a futex doorbell that the
+// other side only rings when someone is asleep.
+// Everything in the object is writable by every producer, so the daemon
+// keeps its own copy of the geometry, bounds-checks slot indices and
+// reads a slot's descriptor once.
+// Producers may die without unregistering. Their completion rings are
+// taken over by the next producer to register, slots finishing for a
+// producer that is gone go straight back to the free queue, and the
+// daemon's reclaim_dead() sweep frees slots a dead producer was holding.
+
+static const uint32_t DCT_RING_MAGIC = 0x474e5244;     // "DRNG"
+static const int DCT_RING_MAX_SLOTS = 256;
+static const int DCT_RING_MAX_PRODUCERS = 64;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+              std::atomic<uint64_t>::is_always_lock_free,
+              "ring atomics must be address-free to work across processes");
+
+// Block until *a != expected, a wake-up or timeout_ms passes
+inline void dct_ring_futex_wait(std::atomic<uint32_t> &a, uint32_t expected, int timeout_ms)
+{
+    timespec ts = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&a), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+inline void dct_ring_futex_wake(std::atomic<uint32_t> &a)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&a), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// False once process pid has exited (EPERM still means it exists)
+inline bool dct_ring_pid_alive(int32_t pid)
+{
+    return pid > 0 && !(kill(pid, 0) != 0 && errno == ESRCH);
+}
+
+// Doorbell: a counter bumped on every post, plus the number of sleepers
+struct DctRingBell {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> sleepers;
+
+    void ring()
+    {
+        seq.fetch_add(1, std::memory_order_release);
+        if (sleepers.load(std::memory_order_seq_cst)) dct_ring_futex_wake(seq);
+    }
+
+    // ready() is retested after announcing the sleeper, so a post between
+    // the caller's last check and the futex call is never missed. Woken
+    // waiters that lose the race go back to sleep until the deadline.
+    template <class Ready>
+    bool wait(Ready ready, int timeout_ms)
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t deadline = now.tv_sec * 1000LL + now.tv_nsec / 1000000 + timeout_ms;
+        for (;;) {
+            uint32_t s = seq.load(std::memory_order_acquire);
+            if (ready()) return true;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            int64_t left = deadline - (now.tv_sec * 1000LL + now.tv_nsec / 1000000);
+            if (left <= 0) return false;
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            bool got = ready();     // ready() may consume, so a hit returns at once
+            if (!got) dct_ring_futex_wait(seq, s, (int)left);
+            sleepers.fetch_sub(1, std::memory_order_seq_cst);
+            if (got) return true;
+        }
+    }
+};
+
+// Bounded MPMC queue of slot indices (per-cell sequence numbers, as in
+// D. Vyukov's queue). Capacity equals the slot count, so pushing a slot
+// the queue's users own can never find it full. Cell indices are clipped
+// to the array, so a scribbled mask cannot send a pop out of bounds.
+struct DctRingQueue {
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) DctRingBell bell;
+    uint32_t mask;
+    struct Cell {
+        std::atomic<uint64_t> seq;
+        uint64_t value;
+    } cells[DCT_RING_MAX_SLOTS];
+
+    void init(uint32_t n)
+    {
+        mask = n - 1;
+        head.store(0);
+        tail.store(0);
+        bell.seq.store(0);
+        bell.sleepers.store(0);
+        for (uint32_t i = 0; i < n; i++) cells[i].seq.store(i);
+    }
+
+    bool push(uint32_t v)
+    {
+        uint64_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &c = cells[pos & mask & (DCT_RING_MAX_SLOTS - 1)];
+            int64_t dif = int64_t(c.seq.load(std::memory_order_acquire)) - int64_t(pos);
+            if (dif == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = v;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    bell.ring();
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(uint32_t &v)
+    {
+        uint64_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &c = cells[pos & mask & (DCT_RING_MAX_SLOTS - 1)];
+            int64_t dif = int64_t(c.seq.load(std::memory_order_acquire)) - int64_t(pos + 1);
+            if (dif == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    v = (uint32_t)c.value;
+                    c.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop_wait(uint32_t &v, int timeout_ms)
+    {
+        return bell.wait([&] { return pop(v); }, timeout_ms);
+    }
+};
+
+// Completion ring of one producer: the daemon appends, the producer reaps
+struct DctRingCq {
+    alignas(64) std::atomic<uint32_t> tail;
+    alignas(64) std::atomic<uint32_t> head;
+    alignas(64) DctRingBell bell;
+    std::atomic<int32_t> owner;         // pid of the registered producer, 0 = free
+    uint32_t entries[DCT_RING_MAX_SLOTS];
+};
+
+// Where a slot is; every hand-over is a store or CAS of the state
+enum : uint32_t {
+    DCT_SLOT_FREE,          // in the free queue
+    DCT_SLOT_HELD,          // acquired or reaped, its owner's to fill or read
+    DCT_SLOT_QUEUED,        // submitted
+    DCT_SLOT_RUNNING,       // taken by a daemon thread
+    DCT_SLOT_DONE           // posted to its owner's completion ring
+};
+
+// What a producer asks for in a slot; status and service_ms come back
+struct DctRingSlot {
+    std::atomic<uint32_t> state;
+    std::atomic<int32_t> owner;     // pid that acquired it, set by acquire_slot()
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;      // 1 or 3
+    uint32_t producer;      // completion ring to post to
+    uint64_t user_data;     // returned untouched
+    int32_t  status;        // 0 or an errno value
+    float    service_ms;    // time inside the daemon
+};
+
+struct DctRingShared {
+    uint32_t magic;
+    uint32_t nslots;
+    uint32_t max_w, max_h;
+    uint64_t slot_bytes;
+    uint64_t coeff_offset;      // of the coefficient planes inside a slot
+    uint64_t data_offset;       // of slot 0 from the start of the object
+    DctRingQueue free_q;
+    DctRingQueue sq;
+    DctRingSlot slots[DCT_RING_MAX_SLOTS];
+    DctRingCq cq[DCT_RING_MAX_PRODUCERS];
+};
+
+// A mapping of the ring. The daemon create()s it (and unlinks it when
+// done); producers open() it by name.
+class DctRing {
+public:
+    ~DctRing()
+    {
+        if (base_) munmap(base_, bytes_);
+        if (owner_) shm_unlink(name_.c_str());
+    }
+
+    // nslots is rounded up to a power of two
+    bool create(const std::string &name, int nslots, int max_w, int max_h)
+    {
+        uint32_t n = 1;
+        while (n < (uint32_t)nslots) n <<= 1;
+        if (n > (uint32_t)DCT_RING_MAX_SLOTS) return false;
+        size_t plane = size_t(max_w) * max_h;
+        size_t coeff_off = page_up(3 * plane);
+        size_t slot_bytes = page_up(coeff_off + 3 * plane * 2);
+        size_t data_off = page_up(sizeof(DctRingShared));
+
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) return false;
+        bool ok = ftruncate(fd, (off_t)(data_off + n * slot_bytes)) == 0 && map(fd);
+        close(fd);
+        if (!ok) {
+            shm_unlink(name.c_str());
+            return false;
+        }
+        name_ = name;
+        owner_ = true;
+        nslots_ = n;
+        max_w_ = max_w;
+        max_h_ = max_h;
+        slot_bytes_ = slot_bytes;
+        coeff_off_ = coeff_off;
+        data_off_ = data_off;
+
+        DctRingShared &s = *shared_;
+        s.nslots = n;
+        s.max_w = max_w;
+        s.max_h = max_h;
+        s.slot_bytes = slot_bytes;
+        s.coeff_offset = coeff_off;
+        s.data_offset = data_off;
+        s.free_q.init(n);
+        s.sq.init(n);
+        for (uint32_t i = 0; i < n; i++) {
+            s.slots[i].state.store(DCT_SLOT_FREE);
+            s.slots[i].owner.store(0);
+            s.free_q.push(i);
+        }
+        for (auto &cq : s.cq) {
+            cq.tail.store(0);
+            cq.head.store(0);
+            cq.bell.seq.store(0);
+            cq.bell.sleepers.store(0);
+            cq.owner.store(0);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        s.magic = DCT_RING_MAGIC;
+        return true;
+    }
+
+    bool open(const std::string &name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) return false;
+        bool ok = map(fd);
+        close(fd);
+        name_ = name;
+        if (!ok || shared_->magic != DCT_RING_MAGIC) return false;
+        const DctRingShared &s = *shared_;
+        nslots_ = s.nslots;
+        max_w_ = (int)s.max_w;
+        max_h_ = (int)s.max_h;
+        slot_bytes_ = s.slot_bytes;
+        coeff_off_ = s.coeff_offset;
+        data_off_ = s.data_offset;
+        return nslots_ && nslots_ <= (uint32_t)DCT_RING_MAX_SLOTS && !(nslots_ & (nslots_ - 1)) &&
+               data_off_ + nslots_ * slot_bytes_ <= bytes_;
+    }
+
+    DctRingShared &shared() { return *shared_; }
+    DctRingSlot &slot(uint32_t i) { return shared_->slots[i]; }
+    int max_width() const { return max_w_; }
+    int max_height() const { return max_h_; }
+    int num_slots() const { return (int)nslots_; }
+
+    uint8_t *pixels(uint32_t i, int c)
+    {
+        return slot_base(i) + size_t(c) * plane_size();
+    }
+
+    int16_t *coeffs(uint32_t i, int c)
+    {
+        return (int16_t *)(slot_base(i) + coeff_off_) + size_t(c) * plane_size();
+    }
+
+    // ---- producer side ----
+
+    // Claim a completion ring, free or left behind by a producer that
+    // died; -1 if all are taken. Completions the dead producer never
+    // reaped go back to the free queue.
+    int register_producer()
+    {
+        int32_t pid = (int32_t)getpid();
+        for (int i = 0; i < DCT_RING_MAX_PRODUCERS; i++) {
+            DctRingCq &cq = shared_->cq[i];
+            int32_t expect = cq.owner.load();
+            if (expect && dct_ring_pid_alive(expect)) continue;
+            if (cq.owner.compare_exchange_strong(expect, pid)) {
+                uint32_t t = cq.tail.load(std::memory_order_acquire);
+                for (uint32_t h = cq.head.load(std::memory_order_relaxed); h != t; h++)
+                    reclaim(cq.entries[h & (nslots_ - 1)], DCT_SLOT_DONE);
+                cq.head.store(t, std::memory_order_release);
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void unregister_producer(int id) { shared_->cq[id].owner.store(0); }
+
+    bool acquire_slot(uint32_t &i, int timeout_ms)
+    {
+        if (!shared_->free_q.pop_wait(i, timeout_ms)) return false;
+        DctRingSlot &d = shared_->slots[i];
+        d.owner.store((int32_t)getpid(), std::memory_order_relaxed);
+        d.state.store(DCT_SLOT_HELD, std::memory_order_release);
+        return true;
+    }
+
+    // The slot's descriptor and planes must be filled in
+    void submit(uint32_t i)
+    {
+        shared_->slots[i].state.store(DCT_SLOT_QUEUED, std::memory_order_release);
+        shared_->sq.push(i);
+    }
+
+    // A completion the daemon posted just as the ring's previous owner
+    // died can still land here; such slots are freed, not returned.
+    bool reap(int producer, uint32_t &i, int timeout_ms)
+    {
+        DctRingCq &cq = shared_->cq[producer];
+        int32_t pid = (int32_t)getpid();
+        auto ready = [&] {
+            return cq.head.load(std::memory_order_relaxed) != cq.tail.load(std::memory_order_acquire);
+        };
+        for (;;) {
+            if (!cq.bell.wait(ready, timeout_ms)) return false;
+            uint32_t h = cq.head.load(std::memory_order_relaxed);
+            i = cq.entries[h & (nslots_ - 1)];
+            cq.head.store(h + 1, std::memory_order_release);
+            if (i >= nslots_) continue;
+            DctRingSlot &d = shared_->slots[i];
+            uint32_t done = DCT_SLOT_DONE;
+            if (d.owner.load() == pid && d.state.compare_exchange_strong(done, DCT_SLOT_HELD))
+                return true;
+            reclaim(i, DCT_SLOT_DONE);
+        }
+    }
+
+    void release_slot(uint32_t i)
+    {
+        shared_->slots[i].state.store(DCT_SLOT_FREE, std::memory_order_release);
+        shared_->free_q.push(i);
+    }
+
+    // ---- daemon side ----
+
+    bool next_submission(uint32_t &i, int timeout_ms)
+    {
+        return shared_->sq.pop_wait(i, timeout_ms);
+    }
+
+    // Take submitted slot i for work; false if i is not a slot or was not
+    // submitted (a stray or repeated index), which must then be dropped
+    bool claim_submission(uint32_t i)
+    {
+        if (i >= nslots_) return false;
+        uint32_t queued = DCT_SLOT_QUEUED;
+        return shared_->slots[i].state.compare_exchange_strong(queued, DCT_SLOT_RUNNING);
+    }
+
+    // Free the slots that producers which have exited were holding, or
+    // had completions for; returns how many. Submitted slots are left to
+    // complete(). A producer killed between popping a free slot and
+    // marking it held still loses that one slot.
+    int reclaim_dead()
+    {
+        int n = 0;
+        for (uint32_t i = 0; i < nslots_; i++) {
+            uint32_t st = shared_->slots[i].state.load();
+            if ((st == DCT_SLOT_HELD || st == DCT_SLOT_DONE) && reclaim(i, st)) n++;
+        }
+        return n;
+    }
+
+    // Post slot i to completion ring p, which the caller read from the
+    // slot's descriptor (with the submitter's pid) before working on it.
+    // Daemon threads take turns per ring, so the ring keeps a single
+    // writer. If the submitter has unregistered or died, nobody will reap
+    // the slot, so it is freed instead; false then.
+    bool complete(uint32_t i, uint32_t p, int32_t submitter)
+    {
+        if (p >= (uint32_t)DCT_RING_MAX_PRODUCERS) {
+            release_slot(i);
+            return false;
+        }
+        DctRingCq &cq = shared_->cq[p];
+        int32_t owner = cq.owner.load(std::memory_order_acquire);
+        if (owner != submitter || !dct_ring_pid_alive(owner)) {
+            release_slot(i);
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(cq_lock_[p]);
+        shared_->slots[i].state.store(DCT_SLOT_DONE, std::memory_order_release);
+        uint32_t t = cq.tail.load(std::memory_order_relaxed);
+        cq.entries[t & (nslots_ - 1)] = i;
+        cq.tail.store(t + 1, std::memory_order_release);
+        cq.bell.ring();
+        return true;
+    }
+
+private:
+    static size_t page_up(size_t n) { return (n + 4095) & ~size_t(4095); }
+
+    // Free slot i if it is still in state `from` and its owner has exited.
+    // The CAS makes sure only one of the sweep, a new ring owner and a
+    // reaper frees it.
+    bool reclaim(uint32_t i, uint32_t from)
+    {
+        if (i >= nslots_) return false;
+        DctRingSlot &d = shared_->slots[i];
+        if (dct_ring_pid_alive(d.owner.load())) return false;
+        if (!d.state.compare_exchange_strong(from, DCT_SLOT_FREE)) return false;
+        shared_->free_q.push(i);
+        return true;
+    }
+
+    size_t plane_size() const { return size_t(max_w_) * max_h_; }
+
+    uint8_t *slot_base(uint32_t i)
+    {
+        return (uint8_t *)base_ + data_off_ + size_t(i) * slot_bytes_;
+    }
+
+    bool map(int fd)
+    {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(DctRingShared)) return false;
+        void *p = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return false;
+        base_ = p;
+        bytes_ = size_t(st.st_size);
+        shared_ = (DctRingShared *)p;
+        return true;
+    }
+
+    void *base_ = nullptr;
+    size_t bytes_ = 0;
+    DctRingShared *shared_ = nullptr;
+    // Geometry as created or first seen, never reread from the object
+    uint32_t nslots_ = 0;
+    int max_w_ = 0, max_h_ = 0;
+    size_t slot_bytes_ = 0, coeff_off_ = 0, data_off_ = 0;
+    std::string name_;
+    bool owner_ = false;
+    std::mutex cq_lock_[DCT_RING_MAX_PRODUCERS];
+};
@@ -0,0 +1,239 @@
+#pragma once
+#include <xrt/xrt_device.h>
+#include <xrt/xrt_kernel.h>
+#include <xrt/xrt_bo.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+
+#include "jpeg_cpu.hpp"
+#include "parallel.hpp"
+#include "tiles.hpp"
+
+// One unit of DCT work for a raster dct_accel (v1-v4 argument list): three
+// w x h planes in, three coefficient planes out. A stripe of an image is a
+// job too: rows [y0, y0 + h) start at plane + y0 * w, and as long as y0 is
+// a multiple of 8 its blocks are the image's blocks.
+struct DctJob {
+    const pixel_t* in[3];
+    coeff_t* out[3];
+    int width;
+    int height;
+    bool quant = false;
+    int affinity = -1;      // preferred device for DeviceScheduler, -1 = any
+
+    size_t blocks() const { return size_t((width + 7) / 8) * ((height + 7) / 8); }
+};
+
+// Something that runs DctJobs one at a time: a compute unit on a card or
+// an emulated one. Units are driven by a single worker thread each.
+class DctUnit {
+public:
+    virtual ~DctUnit() {}
+    virtual const std::string& name() const = 0;
+    // Throws std::runtime_error if the unit fails; the job is then not done
+    virtual void run(const DctJob& job) = 0;
+};
+
+// What a scheduler reports per unit
+struct DctUnitStats {
+    std::string name;
+    int jobs;
+    size_t blocks;
+    double busy_ms;
+    bool failed;
+};
+
+// Compute units of `kernel` in an xclbin, as names xrt::kernel accepts
+// ("dct_accel:{dct_accel_1}"). Empty if the xclbin has none.
+inline std::vector<std::string> discover_cus(const std::string& xclbin_file,
+                                             const std::string& kernel)
+{
+    std::vector<std::string> names;
+    xrt::xclbin xclbin(xclbin_file);
+    for (auto& k : xclbin.get_kernels()) {
+        if (k.get_name() != kernel) continue;
+        for (auto& cu : k.get_cus()) {
+            std::string ip = cu.get_name();     // "<kernel>:<cu>"
+            size_t colon = ip.find(':');
+            names.push_back(kernel + ":{" + (colon == std::string::npos ? ip : ip.substr(colon + 1)) + "}");
+        }
+    }
+    return names;
+}
+
+// One compute unit on a card with its own buffer set, allocated from the
+// CU's memory banks and grown when a larger job arrives. label names the
+// unit in reports (default: the CU name).
+class XrtUnit : public DctUnit {
+public:
+    XrtUnit(xrt::device& device, const xrt::uuid& uuid, const std::string& cu_name,
+            int variant, const std::vector<uint32_t>& qwords,
+            const std::string& label = "")
+        : device_(device), kernel_(device, uuid, cu_name),
+          name_(label.empty() ? cu_name : label), variant_(variant)
+    {
+        if (variant_ >= 4) {
+            qtab_ = xrt::bo(device_, qwords.size() * sizeof(uint32_t),
+                            xrt::bo::flags::normal, kernel_.group_id(6));
+            qtab_.write(qwords.data());
+            qtab_.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+        }
+    }
+
+    const std::string& name() const override { return name_; }
+
+    void run(const DctJob& job) override
+    {
+        size_t np = size_t(job.width) * job.height;
+        reserve(np);
+        for (int c = 0; c < 3; c++) {
+            in_[c].write(job.in[c], np * sizeof(pixel_t), 0);
+            in_[c].sync(XCL_BO_SYNC_BO_TO_DEVICE, np * sizeof(pixel_t), 0);
+        }
+        xrt::run run;
+        if (variant_ >= 4)
+            run = kernel_(in_[0], in_[1], in_[2], out_[0], out_[1], out_[2],
+                          qtab_, job.width, job.height, job.quant ? 1 : 0);
+        else
+            run = kernel_(in_[0], in_[1], in_[2], out_[0], out_[1], out_[2],
+                          job.width, job.height);
+        run.wait();
+        for (int c = 0; c < 3; c++) {
+            out_[c].sync(XCL_BO_SYNC_BO_FROM_DEVICE, np * sizeof(coeff_t), 0);
+            out_[c].read(job.out[c], np * sizeof(coeff_t), 0);
+        }
+    }
+
+private:
+    void reserve(size_t np)
+    {
+        if (np <= capacity_) return;
+        for (int c = 0; c < 3; c++) {
+            in_[c]  = xrt::bo(device_, np * sizeof(pixel_t), xrt::bo::flags::normal, kernel_.group_id(c));
+            out_[c] = xrt::bo(device_, np * sizeof(coeff_t), xrt::bo::flags::normal, kernel_.group_id(3 + c));
+        }
+        capacity_ = np;
+    }
+
+    xrt::device device_;
+    xrt::kernel kernel_;
+    std::string name_;
+    int variant_;
+    size_t capacity_ = 0;
+    xrt::bo in_[3], out_[3], qtab_;
+};
+
+// Emulated compute unit: the host's golden DCT (edge-replicated blocks,
+// double precision, optional quantization) on the CPU, so schedulers can be
+// exercised without a card. It is the CPU reference, not a model of the
+// kernel's fixed point, so it cannot show kernel/reference mismatches.
+// With fail_after >= 0 every job after the first fail_after throws, like a
+// card that drops off the bus. set_timing() makes each job last at least
+// fixed_ms + blocks / blocks_per_ms, the shape of a card's sync + launch +
+// wait overhead plus its pipeline rate.
+class EmuUnit : public DctUnit {
+public:
+    EmuUnit(const std::string& name, const QuantTable qtabs[3], int fail_after = -1)
+        : name_(name), fail_after_(fail_after)
+    {
+        for (int c = 0; c < 3; c++) qtabs_[c] = qtabs[c];
+    }
+
+    const std::string& name() const override { return name_; }
+
+    void set_timing(double fixed_ms, double blocks_per_ms)
+    {
+        fixed_ms_ = fixed_ms;
+        blocks_per_ms_ = blocks_per_ms;
+    }
+
+    void run(const DctJob& job) override
+    {
+        if (fail_after_ >= 0 && done_ >= fail_after_)
+            throw std::runtime_error(name_ + ": emulated device failure");
+        auto t0 = std::chrono::steady_clock::now();
+        pixel_t blk_in[8][8];
+        coeff_t blk_out[8][8], q_blk[8][8];
+        int w = job.width, h = job.height;
+        for (int c = 0; c < 3; c++) {
+            for (int by = 0; by < h; by += 8) {
+                for (int bx = 0; bx < w; bx += 8) {
+                    for (int y = 0; y < 8; y++)
+                        for (int x = 0; x < 8; x++)
+                            blk_in[y][x] = job.in[c][std::min(by + y, h - 1) * w + std::min(bx + x, w - 1)];
+                    dct_block_cpu(blk_in, blk_out);
+                    if (job.quant) {
+                        quant_block(blk_out, q_blk, qtabs_[c]);
+                        std::copy(&q_blk[0][0], &q_blk[0][0] + 64, &blk_out[0][0]);
+                    }
+                    for (int y = 0; y < 8 && by + y < h; y++)
+                        for (int x = 0; x < 8 && bx + x < w; x++)
+                            job.out[c][(by + y) * w + bx + x] = blk_out[y][x];
+                }
+            }
+        }
+        done_++;
+        double ms = fixed_ms_ + (blocks_per_ms_ > 0 ? job.blocks() / blocks_per_ms_ : 0);
+        if (ms > 0)
+            std::this_thread::sleep_until(t0 + std::chrono::duration<double, std::milli>(ms));
+    }
+
+private:
+    std::string name_;
+    QuantTable qtabs_[3];
+    int fail_after_;
+    int done_ = 0;
+    double fixed_ms_ = 0, blocks_per_ms_ = 0;
+};
+
+// The host CPU as a backend: the tiled CPU engine (tiles.hpp) on nthreads
+// threads, so a dispatcher can weigh it against the card
+class CpuUnit : public DctUnit {
+public:
+    CpuUnit(const std::string& name, const QuantTable qtabs[3],
+            int nthreads = host_num_threads())
+        : name_(name), nthreads_(nthreads)
+    {
+        for (int c = 0; c < 3; c++) qtabs_[c] = qtabs[c];
+    }
+
+    const std::string& name() const override { return name_; }
+
+    void run(const DctJob& job) override
+    {
+        size_t n = tiled_size(job.width, job.height);
+        tiles_.resize(n);
+        coef_.resize(n);
+        for (int c = 0; c < 3; c++) {
+            raster_to_tiles(job.in[c], job.width, job.height, tiles_.data(), nthreads_);
+            parallel_for(0, int(n / 64), nthreads_, [&](int, int lo, int hi) {
+                coeff_t q[8][8];
+                for (int b = lo; b < hi; b++) {
+                    auto in = reinterpret_cast<const pixel_t (*)[8]>(tiles_.data() + size_t(b) * 64);
+                    auto out = reinterpret_cast<coeff_t (*)[8]>(coef_.data() + size_t(b) * 64);
+                    dct_block_cpu(in, out);
+                    if (job.quant) {
+                        quant_block(out, q, qtabs_[c]);
+                        std::copy(&q[0][0], &q[0][0] + 64, &out[0][0]);
+                    }
+                }
+            });
+            tiles_to_raster(coef_.data(), job.width, job.height, job.out[c], nthreads_);
+        }
+    }
+
+private:
+    std::string name_;
+    QuantTable qtabs_[3];
+    int nthreads_;
+    std::vector<pixel_t> tiles_;
+    std::vector<coeff_t> coef_;
+};
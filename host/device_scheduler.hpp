@@ -0,0 +1,171 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "dct_units.hpp"
+
+// Spreads jobs over several cards (one DctUnit, worker thread and buffer
+// set per card) from a single global queue. A free worker takes, in order:
+// a job with affinity to its own card, a job with no affinity or whose
+// card has failed, and finally any job at all, so a busy card's backlog
+// drains to idle ones. A card whose unit throws is retired and the job
+// goes back to the front of the queue for the others; wait() only fails
+// when no card is left.
+class DeviceScheduler {
+public:
+    explicit DeviceScheduler(std::vector<std::unique_ptr<DctUnit>> devices)
+    {
+        for (auto& d : devices) {
+            workers_.emplace_back(new Worker());
+            workers_.back()->unit = std::move(d);
+        }
+        alive_ = (int)workers_.size();
+        for (int i = 0; i < (int)workers_.size(); i++)
+            workers_[i]->thread = std::thread([this, i] { work(i); });
+    }
+
+    ~DeviceScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& w : workers_) w->thread.join();
+    }
+
+    int num_units() const { return (int)workers_.size(); }
+
+    int num_alive() const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        return alive_;
+    }
+
+    // The job's buffers must stay valid until wait()
+    void submit(const DctJob& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            queue_.push_back(job);
+        }
+        work_cv_.notify_all();
+    }
+
+    // Block until the queue is drained. If every card has failed, the
+    // remaining jobs are dropped and an error is thrown.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_);
+        idle_cv_.wait(lock, [this] {
+            return (queue_.empty() && running_ == 0) || alive_ == 0;
+        });
+        if (!queue_.empty()) {
+            size_t n = queue_.size();
+            queue_.clear();
+            throw std::runtime_error("no device left, " + std::to_string(n) + " jobs not run");
+        }
+    }
+
+    std::vector<DctUnitStats> stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        std::vector<DctUnitStats> s;
+        for (auto& w : workers_)
+            s.push_back({w->unit->name(), w->jobs, w->blocks, w->busy_ms, w->failed});
+        return s;
+    }
+
+    void reset_stats()
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        for (auto& w : workers_) {
+            w->jobs = 0;
+            w->blocks = 0;
+            w->busy_ms = 0;
+        }
+    }
+
+private:
+    struct Worker {
+        std::unique_ptr<DctUnit> unit;
+        bool failed = false;
+        int jobs = 0;
+        size_t blocks = 0;
+        double busy_ms = 0;
+        std::thread thread;
+    };
+
+    // Index in queue_ of the job device `dev` should run next (m_ held)
+    size_t pick(int dev) const
+    {
+        size_t any = queue_.size(), open = queue_.size();
+        for (size_t i = 0; i < queue_.size(); i++) {
+            int a = queue_[i].affinity;
+            if (a == dev) return i;
+            bool orphan = a < 0 || a >= (int)workers_.size() || workers_[a]->failed;
+            if (orphan && open == queue_.size()) open = i;
+            if (any == queue_.size()) any = i;
+        }
+        return open < queue_.size() ? open : any;
+    }
+
+    void work(int dev)
+    {
+        Worker& self = *workers_[dev];
+        std::unique_lock<std::mutex> lock(m_);
+        for (;;) {
+            work_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            size_t i = pick(dev);
+            DctJob job = queue_[i];
+            queue_.erase(queue_.begin() + i);
+            running_++;
+            lock.unlock();
+
+            std::string err;
+            auto t0 = std::chrono::high_resolution_clock::now();
+            try {
+                self.unit->run(job);
+            } catch (const std::exception& e) {
+                err = e.what();
+            }
+            auto t1 = std::chrono::high_resolution_clock::now();
+
+            lock.lock();
+            running_--;
+            if (!err.empty()) {
+                // Retire the card; its job goes back for the others
+                self.failed = true;
+                alive_--;
+                job.affinity = -1;
+                queue_.push_front(job);
+                std::cerr << "WARNING: " << self.unit->name() << " failed (" << err
+                          << "), " << alive_ << " device(s) left\n";
+                work_cv_.notify_all();
+                idle_cv_.notify_all();
+                return;
+            }
+            self.busy_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+            self.jobs++;
+            self.blocks += job.blocks();
+            idle_cv_.notify_all();
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::deque<DctJob> queue_;
+    mutable std::mutex m_;
+    std::condition_variable work_cv_, idle_cv_;
+    int alive_ = 0;
+    int running_ = 0;
+    bool stop_ = false;
+};
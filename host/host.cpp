@@ -13,14 +13,76 @@
 #include <cstdint>
 #include <cassert>
 #include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <cmath>
 
 #include "jpeg_cpu.hpp"
+#include "huffman.hpp"
+#include "rans.hpp"
+#include "parallel.hpp"
+#include "color.hpp"
+#include "planes.hpp"
+#include "tiles.hpp"
+#include "batch.hpp"
+#include "atlas.hpp"
+#include "dct_units.hpp"
+#include "cu_scheduler.hpp"
+#include "device_scheduler.hpp"
+#include "adaptive_dispatch.hpp"
+#include "coop.hpp"
+#include "verify.hpp"
+#include "mismatch.hpp"
+#include "kernel_stats.hpp"
+#include "kernel_perf.hpp"
 
 using std::vector;
 using std::cout;
 using std::cerr;
 using std::endl;
 
+// Line buffer width of hls/v6_dct_accel.cpp (MAX_WIDTH)
+static const int V6_MAX_WIDTH = 4096;
+
+// Command-line options following the three positional arguments
+struct HostOptions {
+    bool optimize_huffman = false;
+    bool rans = false;
+    std::string rans_out;       // write the rANS container here if set
+    int quality = 50;           // libjpeg-style 1..100
+    bool chroma_tables = false; // Q_chroma for channels 1 and 2
+    bool kernel_quant = false;  // quantize on the device (v4 and later)
+    int variant = 0;            // kernel variant, 0 = from xclbin file name
+    vector<int> sweep;          // quality levels for the R-D sweep
+    bool ycc420 = false;        // transform Y/Cb/Cr 4:2:0 instead of R/G/B
+    bool tiled = false;         // CPU golden DCT through the block-major layout
+    int batch = 0;              // v8 batch benchmark up to this many images
+    int atlas = 0;              // v1-v4 atlas benchmark with this many thumbnails
+    int cus = -1;               // multi-CU benchmark over this many CUs, 0 = all
+    int emu_cus = 0;            // ... on this many emulated CUs instead of a card
+    bool split_images = false;  // multi-CU: one job per image instead of stripes
+    int jobs = 0;               // multi-CU: stripes / images, 0 = 4 per CU
+    vector<int> devices;        // multi-device benchmark on these cards
+    bool all_devices = false;   // ... on every card that opens
+    int emu_devices = 0;        // ... on this many emulated cards instead
+    int emu_fail_after = -1;    // emulated card 0 fails after this many jobs
+    bool adaptive = false;      // CPU-vs-device adaptive dispatch benchmark
+    double emu_overhead_ms = 0; // emulated units: fixed cost per job
+    double emu_rate = 0;        // ... and blocks per ms, 0 = as fast as the CPU runs them
+    std::string dispatch_log;   // --adaptive: per-job decisions as CSV
+    bool coop = false;          // split one image between CPU and device
+    VerifyPolicy verify;        // how much of the device output to check
+    bool mismatch_report = false;   // full analysis even when nothing differs
+    int worst_blocks = 8;       // worst blocks listed by the analysis
+    bool recon_pixels = false;  // v10: also read back the reconstructed image
+    bool device_idct = false;   // reconstruct with idct_accel instead of the host
+    double kernel_mhz = 300;    // v12: kernel clock, to turn cycle counts into time
+};
+
 // Performance metrics structure
 struct PerfMetrics {
     double load_time_ms;
@@ -28,6 +90,10 @@ struct PerfMetrics {
     double readback_time_ms;
     double total_fpga_time_ms;
     double cpu_dct_time_ms;
+    double color_time_ms;       // host RGB->YCbCr + packing, 0 in RGB mode
+    double layout_time_ms;      // host v6 pitch padding / v7 tiling, 0 otherwise
+    double verify_time_ms;      // golden model + compare, whatever the policy
+    double idct_time_ms;        // --device-idct: upload, idct_accel and readback
     double throughput_mpixels_per_sec;
     double throughput_blocks_per_sec;
     double speedup;
@@ -43,9 +109,47 @@ struct CompressionMetrics {
     int zero_coeffs;
     int nonzero_coeffs;
     double sparsity_percent;
+    size_t huffman_std_bytes;   // 0 unless --huffman-opt, or if Annex K cannot code it
+    size_t huffman_opt_bytes;
+    double huffman_encode_mbps;
+    size_t rans_bytes;          // 0 unless --rans
+    double rans_encode_mbps;
+    double rans_decode_mbps;
+    bool rans_roundtrip_ok;
+    bool kernel_counts;         // sparsity/RLE counts from the v9 stats stage
+};
+
+// Size of one pixel/coefficient plane. All three planes match in RGB mode;
+// in 4:2:0 mode planes 1 and 2 (Cb, Cr) are half size in each direction.
+// A grayscale image has plane 0 only; the others are 0 x 0.
+struct PlaneDims {
+    int width;
+    int height;
+    int blocks_x() const { return (width + 7) / 8; }
+    int blocks_y() const { return (height + 7) / 8; }
+    size_t size() const { return size_t(width) * height; }
+};
+
+inline int num_planes(const PlaneDims dims[3])
+{
+    return dims[2].size() ? 3 : (dims[1].size() ? 2 : 1);
+}
+
+// Block rows of the three planes laid end to end, so one parallel_for
+// covers planes of different sizes
+struct PlaneRows {
+    int first[4];
+    explicit PlaneRows(const PlaneDims dims[3]) {
+        first[0] = 0;
+        for (int c = 0; c < 3; c++) first[c + 1] = first[c] + dims[c].blocks_y();
+    }
+    int total() const { return first[3]; }
+    int plane_of(int row) const { return row >= first[2] ? 2 : (row >= first[1] ? 1 : 0); }
 };
 
-// Helper: process all 8x8 blocks on CPU to get DCT coefficients
+// Helper: process all 8x8 blocks on CPU to get DCT coefficients.
+// Partial edge blocks are padded by repeating the last column/row (same
+// as the kernel loaders), which keeps them free of an artificial edge.
 void cpu_dct_image(const vector<pixel_t> &chan,
                    int width, int height,
                    vector<coeff_t> &coeff_out)
@@ -58,13 +162,9 @@ void cpu_dct_image(const vector<pixel_t> &chan,
         for (int bx = 0; bx < width; bx += 8) {
             for (int y = 0; y < 8; y++) {
                 for (int x = 0; x < 8; x++) {
-                    int gx = bx + x;
-                    int gy = by + y;
-                    int idx = gy * width + gx;
-                    if (gx < width && gy < height)
-                        blk_in[y][x] = chan[idx];
-                    else
-                        blk_in[y][x] = 0;
+                    int gx = std::min(bx + x, width - 1);
+                    int gy = std::min(by + y, height - 1);
+                    blk_in[y][x] = chan[gy * width + gx];
                 }
             }
 
@@ -84,12 +184,56 @@ void cpu_dct_image(const vector<pixel_t> &chan,
     }
 }
 
-// Full JPEG-style block pipeline
-void jpeg_block_pipeline(const coeff_t blk_coeff_in[8][8], pixel_t blk_recon[8][8])
+// cpu_dct_image through the block-major layout: one gather pass into
+// tiles, then every block is a contiguous 8x8 array (see tiles.hpp)
+void cpu_dct_image_tiled(const vector<pixel_t> &chan,
+                         int width, int height,
+                         vector<coeff_t> &coeff_out)
+{
+    vector<pixel_t> tiles;
+    raster_to_tiles(chan, width, height, tiles);
+    vector<coeff_t> coeff_tiles(tiles.size());
+    cpu_dct_tiles(tiles.data(), tiles.size() / 64, coeff_tiles.data());
+    tiles_to_raster(coeff_tiles, width, height, coeff_out);
+}
+
+// Quantize a whole coefficient plane block by block, in place
+void quantize_image(vector<coeff_t> &coeffs, int width, int height, const QuantTable &qt)
+{
+    coeff_t blk[8][8], q_blk[8][8];
+    for (int by = 0; by < height; by += 8) {
+        for (int bx = 0; bx < width; bx += 8) {
+            for (int y = 0; y < 8; y++) {
+                for (int x = 0; x < 8; x++) {
+                    int gx = bx + x;
+                    int gy = by + y;
+                    blk[y][x] = (gx < width && gy < height) ? coeffs[gy * width + gx] : 0;
+                }
+            }
+            quant_block(blk, q_blk, qt);
+            for (int y = 0; y < 8; y++) {
+                for (int x = 0; x < 8; x++) {
+                    int gx = bx + x;
+                    int gy = by + y;
+                    if (gx < width && gy < height)
+                        coeffs[gy * width + gx] = q_blk[y][x];
+                }
+            }
+        }
+    }
+}
+
+// Full JPEG-style block pipeline. With quantized = true the input is
+// already quantized (on-kernel quantizer) and only the decode half runs.
+void jpeg_block_pipeline(const coeff_t blk_coeff_in[8][8], pixel_t blk_recon[8][8],
+                         const QuantTable &qt, bool quantized = false)
 {
     coeff_t q_blk[8][8], dq_blk[8][8];
 
-    quant_block(blk_coeff_in, q_blk);
+    if (quantized)
+        std::copy(&blk_coeff_in[0][0], &blk_coeff_in[0][0] + 64, &q_blk[0][0]);
+    else
+        quant_block(blk_coeff_in, q_blk, qt);
 
     vector<coeff_t> zz;
     zigzag_block(q_blk, zz);
@@ -104,77 +248,268 @@ void jpeg_block_pipeline(const coeff_t blk_coeff_in[8][8], pixel_t blk_recon[8][
     coeff_t q_blk2[8][8];
     inv_zigzag_block(zz2, q_blk2);
 
-    dequant_block(q_blk2, dq_blk);
+    dequant_block(q_blk2, dq_blk, qt);
 
     idct_block_cpu(dq_blk, blk_recon);
 }
 
-// Calculate compression metrics
+// Run every block of one coefficient plane through jpeg_block_pipeline.
+// Coefficients of partial edge blocks that fall outside the plane were
+// never stored and are taken as 0.
+void reconstruct_plane(const vector<coeff_t> &coeffs, const PlaneDims &d,
+                       const QuantTable &qt, bool quantized,
+                       vector<pixel_t> &recon)
+{
+    recon.resize(d.size());
+    parallel_for(0, d.blocks_y(), host_num_threads(), [&](int, int row_lo, int row_hi) {
+        coeff_t blk[8][8];
+        pixel_t blk_recon[8][8];
+        for (int by = row_lo * 8; by < row_hi * 8; by += 8) {
+            for (int bx = 0; bx < d.width; bx += 8) {
+                for (int y = 0; y < 8; y++) {
+                    for (int x = 0; x < 8; x++) {
+                        int gx = bx + x;
+                        int gy = by + y;
+                        blk[y][x] = (gx < d.width && gy < d.height) ? coeffs[gy * d.width + gx] : 0;
+                    }
+                }
+                jpeg_block_pipeline(blk, blk_recon, qt, quantized);
+                for (int y = 0; y < 8; y++) {
+                    for (int x = 0; x < 8; x++) {
+                        int gx = bx + x;
+                        int gy = by + y;
+                        if (gx < d.width && gy < d.height)
+                            recon[gy * d.width + gx] = blk_recon[y][x];
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Calculate compression metrics. With --huffman-opt the same pass also
+// collects per-thread run/size histograms; the blocks are then entropy coded
+// with both the standard Annex K tables and the optimized per-image tables.
+// With --rans the blocks are additionally coded with the rANS backend.
+// Planes may differ in size (4:2:0), so blocks are coded one plane at a
+// time (non-interleaved scans) and sizes are relative to the RGB input.
+// kstats (v9, only when the kernel saw these very planes) replaces the
+// counting pass and the DC histogram with the device's counts; the pass
+// still runs when the entropy coders need the zigzag blocks.
 CompressionMetrics calculate_compression(
-    const vector<coeff_t>& coeffs_R,
-    const vector<coeff_t>& coeffs_G,
-    const vector<coeff_t>& coeffs_B,
-    int width, int height)
+    const vector<coeff_t>* coeffs[3],
+    const PlaneDims dims[3],
+    const HostOptions& opt,
+    const QuantTable qtabs[3],
+    const KernelStats* kstats = nullptr)
 {
+    const bool optimize_huffman = opt.optimize_huffman;
+    const bool keep_blocks = opt.optimize_huffman || opt.rans;
+
     CompressionMetrics metrics;
 
     // Input size (original pixels)
-    metrics.input_size_bytes = width * height * 3; // RGB pixels
+    const int nplanes = num_planes(dims);
+    const int ngroups = nplanes > 1 ? 2 : 1;   // luma tables only for grayscale
+    metrics.input_size_bytes = dims[0].size() * nplanes; // RGB or gray pixels
 
     // Count zero/nonzero coefficients
     metrics.zero_coeffs = 0;
     metrics.nonzero_coeffs = 0;
+    metrics.huffman_std_bytes = 0;
+    metrics.huffman_opt_bytes = 0;
+    metrics.huffman_encode_mbps = 0;
+    metrics.rans_bytes = 0;
+    metrics.rans_encode_mbps = 0;
+    metrics.rans_decode_mbps = 0;
+    metrics.rans_roundtrip_ok = false;
+    metrics.kernel_counts = kstats && !keep_blocks;
 
     size_t total_rle_pairs = 0;
 
-    for (int by = 0; by < height; by += 8) {
-        for (int bx = 0; bx < width; bx += 8) {
-            // Process each channel
-            for (int ch = 0; ch < 3; ch++) {
-                const vector<coeff_t>* coeff_vec = (ch == 0) ? &coeffs_R :
-                                                   (ch == 1) ? &coeffs_G : &coeffs_B;
-
-                coeff_t blk[8][8];
-                for (int y = 0; y < 8; y++) {
-                    for (int x = 0; x < 8; x++) {
-                        int gx = bx + x;
-                        int gy = by + y;
-                        if (gx < width && gy < height) {
-                            int idx = gy * width + gx;
-                            blk[y][x] = (*coeff_vec)[idx];
-                        } else {
-                            blk[y][x] = 0;
-                        }
-                    }
+    PlaneRows rows(dims);
+    int num_blocks[3];
+    for (int ch = 0; ch < 3; ch++) num_blocks[ch] = dims[ch].blocks_x() * dims[ch].blocks_y();
+
+    // Quantized zigzag blocks, kept for the entropy coding passes
+    vector<coeff_t> zz_blocks[3];
+    if (keep_blocks)
+        for (int ch = 0; ch < 3; ch++) zz_blocks[ch].resize(size_t(num_blocks[ch]) * 64);
+
+    // Per-thread partial counts, merged after the parallel pass.
+    // Histogram group 0 = channel 0, group 1 = channels 1 and 2.
+    struct Partial {
+        BlockCounts counts;
+        HuffHistogram hist[2];
+    };
+    int nthreads = host_num_threads();
+    vector<Partial> partials(nthreads);
+
+    int count_rows = metrics.kernel_counts ? 0 : rows.total();
+    parallel_for(0, count_rows, nthreads, [&](int tid, int row_lo, int row_hi) {
+        Partial &p = partials[tid];
+        huff_hist_clear(p.hist[0]);
+        huff_hist_clear(p.hist[1]);
+        vector<coeff_t> zz;
+        vector<std::pair<coeff_t,int>> rle;
+
+        for (int row = row_lo; row < row_hi; row++) {
+            int ch = rows.plane_of(row);
+            const vector<coeff_t>& coeff_vec = *coeffs[ch];
+            int width = dims[ch].width;
+            int height = dims[ch].height;
+            int by = (row - rows.first[ch]) * 8;
+
+            for (int bx = 0; bx < width; bx += 8) {
+                // Quantize (unless the kernel already did) and count
+                count_block(coeff_vec.data(), width, height, bx, by, qtabs[ch],
+                            opt.kernel_quant, zz, rle, p.counts);
+
+                if (keep_blocks) {
+                    size_t b = size_t(by / 8) * dims[ch].blocks_x() + bx / 8;
+                    std::copy(zz.begin(), zz.end(), zz_blocks[ch].begin() + b * 64);
                 }
+                if (optimize_huffman)
+                    huff_hist_ac(zz.data(), p.hist[ch == 0 ? 0 : 1]);
+            }
+        }
+    });
+
+    HuffHistogram hist[2];
+    huff_hist_clear(hist[0]);
+    huff_hist_clear(hist[1]);
+    for (auto &p : partials) {
+        metrics.zero_coeffs += p.counts.zero;
+        metrics.nonzero_coeffs += p.counts.nonzero;
+        total_rle_pairs += p.counts.rle_pairs;
+        huff_hist_merge(hist[0], p.hist[0]);
+        huff_hist_merge(hist[1], p.hist[1]);
+    }
+    if (metrics.kernel_counts) {
+        for (int ch = 0; ch < nplanes; ch++) {
+            metrics.zero_coeffs += kstats[ch].zero;
+            metrics.nonzero_coeffs += kstats[ch].nonzero;
+            total_rle_pairs += kstats[ch].rle_pairs;
+        }
+    }
 
-                // Quantize and count
-                coeff_t q_blk[8][8];
-                quant_block(blk, q_blk);
+    // RLE encoding: each pair is (value, run_length)
+    // Estimate: 2 bytes for value + 1 byte for run length = 3 bytes per pair
+    metrics.rle_size_bytes = total_rle_pairs * 3;
 
-                vector<coeff_t> zz;
-                zigzag_block(q_blk, zz);
+    if (optimize_huffman) {
+        // DC differences depend on the previous block, so they are
+        // counted once all blocks are quantized, unless the kernel did
+        for (int ch = 0; ch < 3; ch++) {
+            if (kstats) {
+                for (int k = 0; k < KSTATS_DC_CATEGORIES; k++)
+                    hist[ch == 0 ? 0 : 1].dc[k] += kstats[ch].dc_hist[k];
+                continue;
+            }
+            int prev_dc = 0;
+            for (int b = 0; b < num_blocks[ch]; b++) {
+                int dc = zz_blocks[ch][size_t(b) * 64];
+                hist[ch == 0 ? 0 : 1].dc[huff_category(dc - prev_dc)]++;
+                prev_dc = dc;
+            }
+        }
 
-                for (auto val : zz) {
-                    if (val == 0) metrics.zero_coeffs++;
-                    else metrics.nonzero_coeffs++;
-                }
+        HuffTable std_dc[2] = { huff_std_dc_luma(), huff_std_dc_chroma() };
+        HuffTable std_ac[2] = { huff_std_ac_luma(), huff_std_ac_chroma() };
+        // Only the groups in use: grayscale has no chroma histogram
+        HuffTable opt_dc[2], opt_ac[2];
+        for (int g = 0; g < ngroups; g++) {
+            opt_dc[g] = huff_optimal_table(hist[g].dc);
+            opt_ac[g] = huff_optimal_table(hist[g].ac);
+        }
+
+        // The standard tables have no code for AC sizes above 10
+        bool std_covers = true;
+        for (int g = 0; g < ngroups; g++)
+            std_covers = std_covers && huff_table_covers(std_dc[g], hist[g].dc) &&
+                         huff_table_covers(std_ac[g], hist[g].ac);
+
+        // Second pass: one scan per channel
+        auto encode_scan = [&](const HuffTable dc[2], const HuffTable ac[2]) {
+            BitWriter bw;
+            bw.bytes.reserve(total_rle_pairs * 2);
+            for (int ch = 0; ch < nplanes; ch++) {
+                int prev_dc = 0;
+                for (int b = 0; b < num_blocks[ch]; b++)
+                    huff_encode_block(&zz_blocks[ch][size_t(b) * 64], prev_dc,
+                                      dc[ch == 0 ? 0 : 1], ac[ch == 0 ? 0 : 1], bw);
+            }
+            bw.flush();
+            // DHT marker + length per segment, plus the tables in use
+            size_t tables = 2 * ngroups;
+            for (int g = 0; g < ngroups; g++) tables += huff_table_bytes(dc[g]) + huff_table_bytes(ac[g]);
+            return bw.bytes.size() + tables;
+        };
+
+        // Timed on the first scan: the standard tables, or the optimized
+        // ones when the standard tables cannot code the image
+        auto t0 = std::chrono::high_resolution_clock::now();
+        size_t first = std_covers ? encode_scan(std_dc, std_ac) : encode_scan(opt_dc, opt_ac);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        metrics.huffman_std_bytes = std_covers ? first : 0;
+        metrics.huffman_opt_bytes = std_covers ? encode_scan(opt_dc, opt_ac) : first;
+
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        metrics.huffman_encode_mbps = metrics.input_size_bytes / 1e6 / (ms / 1000.0);
+    }
 
-                // Calculate RLE size
-                vector<std::pair<coeff_t,int>> rle;
+    if (opt.rans) {
+        // Single-threaded on purpose: the MB/s figures are per core
+        auto t0 = std::chrono::high_resolution_clock::now();
+        RansSymbols syms;
+        vector<coeff_t> zz(64);
+        vector<std::pair<coeff_t,int>> rle;
+        for (int ch = 0; ch < 3; ch++) {
+            for (int b = 0; b < num_blocks[ch]; b++) {
+                const coeff_t* src = &zz_blocks[ch][size_t(b) * 64];
+                std::copy(src, src + 64, zz.begin());
                 rle_encode(zz, rle);
-                total_rle_pairs += rle.size();
+                rans_append_block(rle, syms);
             }
         }
-    }
+        vector<uint8_t> container;
+        rans_encode(syms, dims[0].width, dims[0].height, nplanes, container);
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        RansSymbols dec;
+        vector<coeff_t> zz_dec;
+        int dw = 0, dh = 0, dch = 0;
+        bool ok = rans_decode(container, dec, dw, dh, dch);
+        if (ok) rans_rebuild_blocks(dec, zz_dec);
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        // Decoded blocks come back channel after channel
+        size_t total_blocks = size_t(num_blocks[0]) + num_blocks[1] + num_blocks[2];
+        ok = ok && dw == dims[0].width && dh == dims[0].height && dch == nplanes &&
+             zz_dec.size() == total_blocks * 64;
+        auto dec_it = zz_dec.begin();
+        for (int ch = 0; ok && ch < 3; ch++) {
+            ok = std::equal(zz_blocks[ch].begin(), zz_blocks[ch].end(), dec_it);
+            dec_it += zz_blocks[ch].size();
+        }
 
-    // RLE encoding: each pair is (value, run_length)
-    // Estimate: 2 bytes for value + 1 byte for run length = 3 bytes per pair
-    metrics.rle_size_bytes = total_rle_pairs * 3;
+        double enc_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        double dec_ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        metrics.rans_bytes = container.size();
+        metrics.rans_encode_mbps = metrics.input_size_bytes / 1e6 / (enc_ms / 1000.0);
+        metrics.rans_decode_mbps = metrics.input_size_bytes / 1e6 / (dec_ms / 1000.0);
+        metrics.rans_roundtrip_ok = ok;
+
+        if (!opt.rans_out.empty()) {
+            std::ofstream f(opt.rans_out, std::ios::binary);
+            f.write((const char*)container.data(), container.size());
+            if (!f) cerr << "WARNING: Failed to write " << opt.rans_out << "\n";
+        }
+    }
 
     metrics.output_size_bytes = metrics.rle_size_bytes;
     metrics.compression_ratio = (double)metrics.input_size_bytes / metrics.output_size_bytes;
-    metrics.bits_per_pixel = (double)(metrics.output_size_bytes * 8) / (width * height * 3);
+    metrics.bits_per_pixel = (double)(metrics.output_size_bytes * 8) / metrics.input_size_bytes;
 
     int total_coeffs = metrics.zero_coeffs + metrics.nonzero_coeffs;
     metrics.sparsity_percent = (double)metrics.zero_coeffs / total_coeffs * 100.0;
@@ -182,7 +517,241 @@ CompressionMetrics calculate_compression(
     return metrics;
 }
 
+// One point of the rate-distortion sweep
+struct SweepPoint {
+    int quality;
+    uint64_t bits;      // optimized-table Huffman scan size
+    double bpp;
+    double psnr[3];
+    double psnr_avg;
+};
+
+// Rate-distortion sweep over many quality levels from one set of DCT
+// coefficients: each block is gathered once and then quantized, counted
+// and reconstructed for every level, so the cost grows with the number
+// of levels and never re-runs the DCT. PSNR is per transformed plane.
+vector<SweepPoint> quality_sweep(
+    const vector<coeff_t>* coeffs[3],
+    const vector<pixel_t>* planes[3],
+    const PlaneDims dims[3],
+    const vector<int>& qualities,
+    bool chroma_tables)
+{
+    int nq = (int)qualities.size();
+    int nplanes = num_planes(dims);
+    PlaneRows rows(dims);
+
+    vector<QuantTable> tabs(size_t(nq) * 3);
+    for (int q = 0; q < nq; q++) {
+        quant_table_init(tabs[q * 3 + 0], Q_luma, qualities[q]);
+        for (int c = 1; c < 3; c++)
+            quant_table_init(tabs[q * 3 + c], chroma_tables ? Q_chroma : Q_luma, qualities[q]);
+    }
+
+    // Per-thread, per-level partial sums
+    struct Partial {
+        vector<HuffHistogram> hist;  // [level * 2 + group]
+        vector<double> sse;          // [level * 3 + channel]
+    };
+    int nthreads = host_num_threads();
+    vector<Partial> partials(nthreads);
+
+    parallel_for(0, rows.total(), nthreads, [&](int tid, int row_lo, int row_hi) {
+        Partial &p = partials[tid];
+        p.hist.resize(size_t(nq) * 2);
+        p.sse.assign(size_t(nq) * 3, 0.0);
+        for (auto &h : p.hist) huff_hist_clear(h);
+
+        // DC prediction carries across the chunk boundary: start from the
+        // quantized DC of the block just before this chunk
+        vector<int> prev_dc(size_t(nq) * 3, 0);
+        int c0 = rows.plane_of(row_lo);
+        if (row_lo > rows.first[c0]) {
+            const PlaneDims &d = dims[c0];
+            size_t idx = size_t((row_lo - rows.first[c0]) * 8 - 8) * d.width + (d.blocks_x() - 1) * 8;
+            for (int q = 0; q < nq; q++) {
+                coeff_t blk[8][8] = {{0}}, q_blk[8][8];
+                blk[0][0] = (*coeffs[c0])[idx];
+                quant_block(blk, q_blk, tabs[q * 3 + c0]);
+                prev_dc[q * 3 + c0] = q_blk[0][0];
+            }
+        }
+
+        vector<coeff_t> zz;
+        coeff_t blk[8][8], q_blk[8][8], dq_blk[8][8];
+        pixel_t recon[8][8];
+
+        for (int row = row_lo; row < row_hi; row++) {
+            int c = rows.plane_of(row);
+            const vector<coeff_t> &cf = *coeffs[c];
+            const vector<pixel_t> &px = *planes[c];
+            int width = dims[c].width;
+            int height = dims[c].height;
+            int by = (row - rows.first[c]) * 8;
+
+            for (int bx = 0; bx < width; bx += 8) {
+                for (int y = 0; y < 8; y++) {
+                    for (int x = 0; x < 8; x++) {
+                        int gx = bx + x;
+                        int gy = by + y;
+                        blk[y][x] = (gx < width && gy < height) ? cf[gy * width + gx] : 0;
+                    }
+                }
+
+                for (int q = 0; q < nq; q++) {
+                    const QuantTable &qt = tabs[q * 3 + c];
+                    quant_block(blk, q_blk, qt);
+
+                    zigzag_block(q_blk, zz);
+                    HuffHistogram &h = p.hist[q * 2 + (c == 0 ? 0 : 1)];
+                    int &pdc = prev_dc[q * 3 + c];
+                    h.dc[huff_category(zz[0] - pdc)]++;
+                    pdc = zz[0];
+                    huff_hist_ac(zz.data(), h);
+
+                    dequant_block(q_blk, dq_blk, qt);
+                    idct_block_cpu(dq_blk, recon);
+
+                    double sse = 0.0;
+                    for (int y = 0; y < 8; y++) {
+                        for (int x = 0; x < 8; x++) {
+                            int gx = bx + x;
+                            int gy = by + y;
+                            if (gx < width && gy < height) {
+                                double d = double(px[gy * width + gx]) - double(recon[y][x]);
+                                sse += d * d;
+                            }
+                        }
+                    }
+                    p.sse[q * 3 + c] += sse;
+                }
+            }
+        }
+    });
+
+    vector<SweepPoint> points(nq);
+    for (int q = 0; q < nq; q++) {
+        HuffHistogram hist[2];
+        huff_hist_clear(hist[0]);
+        huff_hist_clear(hist[1]);
+        double sse[3] = {0, 0, 0};
+        for (auto &p : partials) {
+            if (p.hist.empty()) continue;
+            huff_hist_merge(hist[0], p.hist[q * 2 + 0]);
+            huff_hist_merge(hist[1], p.hist[q * 2 + 1]);
+            for (int c = 0; c < 3; c++) sse[c] += p.sse[q * 3 + c];
+        }
+
+        SweepPoint &pt = points[q];
+        pt.quality = qualities[q];
+        pt.bits = 0;
+        for (int g = 0; g < (nplanes > 1 ? 2 : 1); g++) {
+            HuffTable dc = huff_optimal_table(hist[g].dc);
+            HuffTable ac = huff_optimal_table(hist[g].ac);
+            pt.bits += huff_estimate_bits(hist[g], dc, ac);
+            pt.bits += 8 * (huff_table_bytes(dc) + huff_table_bytes(ac));
+        }
+        pt.bpp = double(pt.bits) / (double(dims[0].size()) * nplanes);
+        pt.psnr_avg = 0.0;
+        for (int c = 0; c < 3; c++) {
+            if (c >= nplanes) {
+                pt.psnr[c] = 0.0;
+                continue;
+            }
+            double mse = sse[c] / double(dims[c].size());
+            pt.psnr[c] = (mse == 0.0) ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+            pt.psnr_avg += pt.psnr[c] / nplanes;
+        }
+    }
+    return points;
+}
+
+void print_sweep_report(const vector<SweepPoint>& points, double sweep_ms,
+                        const char* const names[], int nplanes)
+{
+    std::ios::fmtflags flags = cout.flags();
+    std::streamsize prec = cout.precision();
+
+    cout << "\n========================================\n";
+    cout << "       QUALITY SWEEP (R-D CURVE)\n";
+    cout << "========================================\n";
+    cout << "Quality      Bytes      BPP ";
+    for (int c = 0; c < nplanes; c++) cout << std::setw(8) << (std::string("PSNR-") + names[c]);
+    cout << "  PSNR-Avg\n";
+    for (auto &pt : points) {
+        cout << std::setw(7) << pt.quality << "  "
+             << std::setw(9) << (pt.bits + 7) / 8 << "  "
+             << std::fixed << std::setprecision(3) << std::setw(7) << pt.bpp << " "
+             << std::setprecision(2);
+        for (int c = 0; c < nplanes; c++) cout << std::setw(8) << pt.psnr[c];
+        cout << "  " << std::setw(8) << pt.psnr_avg << "\n";
+    }
+    cout << "\nSweep time: " << std::setprecision(3) << sweep_ms << " ms for "
+         << points.size() << " levels (DCT computed once)\n";
+    cout << "========================================\n";
+
+    cout.flags(flags);
+    cout.precision(prec);
+}
+
 // Print performance report
+// Where the device output diverges: error histogram, 8x8 heatmaps of how
+// often and by how much each block position differs (laid out as the
+// coefficient planes store a block), and the worst blocks
+void print_mismatch_report(const MismatchReport& rep, const char* const names[])
+{
+    std::ios::fmtflags flags = cout.flags();
+    std::streamsize prec = cout.precision();
+
+    cout << "\n========================================\n";
+    cout << "       MISMATCH ANALYSIS\n";
+    cout << "========================================\n";
+    cout << rep.mismatches << " / " << rep.coeffs << " coefficients in "
+         << rep.bad_blocks << " / " << rep.blocks << " blocks, max |error| " << rep.max_err << "\n\n";
+
+    cout << "Blocks by max |error|:\n";
+    for (int b = 0; b < MismatchReport::HIST_BUCKETS; b++) {
+        if (!rep.hist[b]) continue;
+        int lo = MismatchReport::bucket_lo(b);
+        std::string range = std::to_string(lo);
+        if (b == MismatchReport::HIST_BUCKETS - 1)
+            range += "+";
+        else if (MismatchReport::bucket_lo(b + 1) - 1 > lo)
+            range += "-" + std::to_string(MismatchReport::bucket_lo(b + 1) - 1);
+        cout << "  " << std::setw(9) << range << std::setw(10) << rep.hist[b]
+             << std::fixed << std::setprecision(2) << std::setw(9)
+             << 100.0 * rep.hist[b] / rep.blocks << "%\n";
+    }
+    if (!rep.bad_blocks) {
+        cout << "========================================\n";
+        cout.flags(flags);
+        cout.precision(prec);
+        return;
+    }
+
+    cout << "\n% of blocks differing at each position        max |error| at each position\n";
+    for (int y = 0; y < 8; y++) {
+        cout << " ";
+        for (int x = 0; x < 8; x++)
+            cout << std::setprecision(1) << std::setw(6) << 100.0 * rep.pos_count[y * 8 + x] / rep.blocks;
+        cout << "    ";
+        for (int x = 0; x < 8; x++) cout << std::setw(5) << rep.pos_max[y * 8 + x];
+        cout << "\n";
+    }
+
+    cout << "\nWorst blocks:\n";
+    cout << "  Plane  Block (x,y)    Max |err|  Sum |err|  At (row,col)\n";
+    for (auto& b : rep.worst)
+        cout << "  " << std::left << std::setw(6) << names[b.plane] << std::right
+             << std::setw(6) << b.bx << "," << std::left << std::setw(6) << b.by << std::right
+             << std::setw(11) << b.max_err << std::setw(11) << b.sum_err
+             << "      " << b.pos / 8 << "," << b.pos % 8 << "\n";
+    cout << "========================================\n";
+
+    cout.flags(flags);
+    cout.precision(prec);
+}
+
 void print_performance_report(const PerfMetrics& perf, int width, int height)
 {
     cout << "\n========================================\n";
@@ -197,7 +766,15 @@ void print_performance_report(const PerfMetrics& perf, int width, int height)
          << perf.load_time_ms << " ms\n";
     cout << "  Kernel exec:    " << perf.kernel_time_ms << " ms\n";
     cout << "  Data readback:  " << perf.readback_time_ms << " ms\n";
-    cout << "  Total FPGA:     " << perf.total_fpga_time_ms << " ms\n\n";
+    cout << "  Total FPGA:     " << perf.total_fpga_time_ms << " ms\n";
+    if (perf.color_time_ms > 0)
+        cout << "  Color convert:  " << perf.color_time_ms << " ms (host, RGB->YCbCr 4:2:0)\n";
+    if (perf.layout_time_ms > 0)
+        cout << "  Layout convert: " << perf.layout_time_ms << " ms (host, v6 pitch / v7 tiles)\n";
+    cout << "  Verification:   " << perf.verify_time_ms << " ms (host)\n";
+    if (perf.idct_time_ms > 0)
+        cout << "  Device IDCT:    " << perf.idct_time_ms << " ms (idct_accel, incl. transfers)\n";
+    cout << "\n";
 
 
 
@@ -211,6 +788,62 @@ void print_performance_report(const PerfMetrics& perf, int width, int height)
     cout << "========================================\n";
 }
 
+// v12: where each dataflow stage spent its cycles, as a share of the
+// time from kernel start until the stage finished. The limiting stage is
+// the one that waited least on its streams: stages before it stall on
+// output, stages after it on input. Comparing the kernel's own cycle
+// count with the host-timed run gives the launch and completion overhead.
+void print_stage_report(const StagePerf stages[KPERF_STAGES], double kernel_mhz, double run_ms)
+{
+    uint32_t cycles = 0;
+    int limit = 0;
+    double least_wait = 2;
+    for (int s = 0; s < KPERF_STAGES; s++) {
+        cycles = std::max(cycles, stages[s].done_at);
+        if (!stages[s].done_at) continue;
+        double wait = double(stages[s].in_stall + uint64_t(stages[s].out_stall)) / stages[s].done_at;
+        if (wait < least_wait) {
+            least_wait = wait;
+            limit = s;
+        }
+    }
+    double kernel_ms = cycles / (kernel_mhz * 1e3);
+
+    auto flags = cout.flags();
+    auto prec = cout.precision();
+    cout << "\n========================================\n";
+    cout << "       KERNEL STAGE OCCUPANCY (v12)\n";
+    cout << "========================================\n";
+    cout << std::fixed << std::setprecision(3);
+    cout << "Kernel cycles:  " << cycles << " (" << kernel_ms << " ms at "
+         << std::setprecision(0) << kernel_mhz << " MHz)\n";
+    cout << std::setprecision(3);
+    cout << "Host-timed run: " << run_ms << " ms (launch + completion overhead "
+         << std::max(0.0, run_ms - kernel_ms) << " ms)\n\n";
+    cout << " Stage               Done at   Active  In stall  Out stall    Other\n";
+    auto pct = [](uint32_t v, uint32_t of) {
+        std::ostringstream o;
+        if (of) o << std::fixed << std::setprecision(1) << 100.0 * v / of << "%";
+        else o << "-";
+        return o.str();
+    };
+    for (int s = 0; s < KPERF_STAGES; s++) {
+        const StagePerf& p = stages[s];
+        cout << " " << std::left << std::setw(17) << KPERF_STAGE_NAMES[s] << std::right
+             << std::setw(10) << p.done_at
+             << std::setw(9) << pct(p.active, p.done_at)
+             << std::setw(10) << pct(p.in_stall, p.done_at)
+             << std::setw(11) << pct(p.out_stall, p.done_at)
+             << std::setw(9) << pct(p.other(), p.done_at) << "\n";
+    }
+    cout << "\nOther = memory wait (load/store) or pipeline fill\n";
+    if (cycles)
+        cout << "Limiting stage: " << KPERF_STAGE_NAMES[limit] << "\n";
+    cout << "========================================\n";
+    cout.flags(flags);
+    cout.precision(prec);
+}
+
 // Print compression report
 void print_compression_report(const CompressionMetrics& comp)
 {
@@ -232,14 +865,1017 @@ void print_compression_report(const CompressionMetrics& comp)
          << " (" << std::setprecision(1) << comp.sparsity_percent << "%)\n";
     cout << "  Non-zero coeffs:    " << comp.nonzero_coeffs
          << " (" << std::setprecision(1) << (100.0 - comp.sparsity_percent) << "%)\n";
+    if (comp.kernel_counts)
+        cout << "  (counted on the device)\n";
+
+    if (comp.huffman_opt_bytes) {
+        cout << "\nHuffman coding:\n";
+        if (comp.huffman_std_bytes) {
+            double saved = 100.0 * (1.0 - (double)comp.huffman_opt_bytes / comp.huffman_std_bytes);
+            cout << "  Standard tables:    " << comp.huffman_std_bytes << " bytes ("
+                 << std::setprecision(3) << (comp.huffman_std_bytes * 8.0) / (comp.input_size_bytes) << " bpp)\n";
+            cout << "  Optimized tables:   " << comp.huffman_opt_bytes << " bytes ("
+                 << (comp.huffman_opt_bytes * 8.0) / (comp.input_size_bytes) << " bpp, "
+                 << std::setprecision(1) << saved << "% smaller)\n";
+        } else {
+            cout << "  Standard tables:    n/a (AC sizes above 10 have no Annex K code)\n";
+            cout << "  Optimized tables:   " << comp.huffman_opt_bytes << " bytes ("
+                 << std::setprecision(3) << (comp.huffman_opt_bytes * 8.0) / (comp.input_size_bytes) << " bpp)\n";
+        }
+        cout << "  Encode speed:       " << std::setprecision(1)
+             << comp.huffman_encode_mbps << " MB/s\n";
+    }
+
+    if (comp.rans_bytes) {
+        cout << "\nrANS coding (4-way interleaved):\n";
+        cout << "  Container size:     " << comp.rans_bytes << " bytes ("
+             << std::setprecision(3) << (comp.rans_bytes * 8.0) / (comp.input_size_bytes) << " bpp)\n";
+        cout << "  Encode speed:       " << std::setprecision(1)
+             << comp.rans_encode_mbps << " MB/s\n";
+        cout << "  Decode speed:       " << comp.rans_decode_mbps << " MB/s\n";
+        cout << "  Round trip:         " << (comp.rans_roundtrip_ok ? "OK" : "FAILED") << "\n";
+    }
+    cout << "========================================\n";
+}
+
+// Batch benchmark for v8: the input image repeated 1, 2, 4, ... max_batch
+// times per launch over shared buffers. Latency is the wall time of one
+// batch (every image waits for the whole batch), throughput is images/s.
+// The largest batch is checked image by image against the CPU golden.
+static int run_batch_bench(xrt::device& device, xrt::kernel& kernel,
+                           const vector<pixel_t>* planes[3], int w, int h,
+                           int max_batch, const QuantTable qtabs[3], bool quant)
+{
+    const int reps = 10;
+
+    vector<uint32_t> qwords;
+    pack_quant_tables(qtabs, qwords);
+    BatchDct batch(device, kernel, tiled_size(w, h) / 64 * max_batch, max_batch, qwords);
+
+    vector<coeff_t> golden[3];
+    for (int c = 0; c < 3; c++) {
+        cpu_dct_image(*planes[c], w, h, golden[c]);
+        if (quant) quantize_image(golden[c], w, h, qtabs[c]);
+    }
+
+    auto flags = cout.flags();
+    auto prec = cout.precision();
+    cout << "\n========================================\n";
+    cout << "       BATCH BENCHMARK (v8)\n";
+    cout << "========================================\n";
+    cout << "Image: " << w << " x " << h << ", " << reps << " launches per batch size (median)\n\n";
+    cout << " Batch  Latency ms  Per-image ms   Images/s      MP/s  Kernel %\n";
+
+    vector<BatchCoeffs> out;
+    long mismatches = 0;
+    for (int n = 1; ; n = std::min(n * 2, max_batch)) {
+        vector<BatchImage> images(n, BatchImage{w, h, {planes[0]->data(), planes[1]->data(), planes[2]->data()}});
+        vector<BatchTiming> runs(reps);
+        for (auto& t : runs) batch.run(images, quant, out, t);
+        std::sort(runs.begin(), runs.end(), [](const BatchTiming& a, const BatchTiming& b) {
+            return a.total_ms() < b.total_ms();
+        });
+        const BatchTiming& t = runs[reps / 2];
+        double total = t.total_ms();
+        cout << std::fixed << std::setw(6) << n
+             << std::setprecision(3) << std::setw(12) << total
+             << std::setw(14) << total / n
+             << std::setprecision(0) << std::setw(11) << n / (total / 1000.0)
+             << std::setprecision(2) << std::setw(10) << (double(w) * h * n / 1e6) / (total / 1000.0)
+             << std::setprecision(1) << std::setw(10) << 100.0 * t.kernel_ms / total << "\n";
+        if (n == max_batch) break;
+    }
+
+    for (auto& img : out)
+        for (int c = 0; c < 3; c++)
+            for (size_t i = 0; i < golden[c].size(); i++)
+                if (img.planes[c][i] != golden[c][i]) mismatches++;
+    cout << "\nCoefficient mismatches (batch of " << out.size() << "): " << mismatches << "\n";
+    cout << "========================================\n";
+
+    cout.flags(flags);
+    cout.precision(prec);
+    return mismatches ? 1 : 0;
+}
+
+// Atlas benchmark for the raster kernels (v1-v4): n thumbnails cut from
+// the input (top-left crops of varying size) are transformed once with a
+// launch per image and once packed into a single atlas (see atlas.hpp).
+// Buffers are allocated once for the largest job in both cases, so the
+// difference is launch, wait and sync overhead against pack/scatter cost.
+static int run_atlas_bench(xrt::device& device, xrt::kernel& kernel, int variant,
+                           const vector<pixel_t>* planes[3], int w, int h,
+                           int n, const QuantTable qtabs[3], bool quant)
+{
+    using clock = std::chrono::high_resolution_clock;
+    auto ms = [](clock::time_point a, clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    // Thumbnails: crops between full size and half size
+    vector<std::pair<int, int>> sizes(n);
+    vector<vector<pixel_t>> thumbs[3];
+    for (int c = 0; c < 3; c++) thumbs[c].resize(n);
+    for (int i = 0; i < n; i++) {
+        int tw = std::max(1, w - (i * 5) % (w / 2 + 1));
+        int th = std::max(1, h - (i * 3) % (h / 2 + 1));
+        sizes[i] = {tw, th};
+        for (int c = 0; c < 3; c++) {
+            thumbs[c][i].resize(size_t(tw) * th);
+            copy_rect(planes[c]->data(), w, thumbs[c][i].data(), tw, tw, th);
+        }
+    }
+
+    Atlas atlas = atlas_layout(sizes, 4096);
+    size_t max_elems = std::max(atlas.size(), size_t(w) * h);
+
+    xrt::bo in[3], out[3], qtab;
+    for (int c = 0; c < 3; c++) {
+        in[c]  = xrt::bo(device, max_elems * sizeof(pixel_t), xrt::bo::flags::normal, kernel.group_id(c));
+        out[c] = xrt::bo(device, max_elems * sizeof(coeff_t), xrt::bo::flags::normal, kernel.group_id(3 + c));
+    }
+    if (variant >= 4) {
+        vector<uint32_t> qwords;
+        pack_quant_tables(qtabs, qwords);
+        qtab = xrt::bo(device, qwords.size() * sizeof(uint32_t), xrt::bo::flags::normal, kernel.group_id(6));
+        qtab.write(qwords.data());
+        qtab.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    }
+
+    // Upload three w x h planes, run, read the coefficients back
+    auto transform = [&](const pixel_t* const src[3], int pw, int ph, coeff_t* const dst[3]) {
+        size_t np = size_t(pw) * ph;
+        for (int c = 0; c < 3; c++) {
+            in[c].write(src[c], np * sizeof(pixel_t), 0);
+            in[c].sync(XCL_BO_SYNC_BO_TO_DEVICE, np * sizeof(pixel_t), 0);
+        }
+        xrt::run run;
+        if (variant >= 4)
+            run = kernel(in[0], in[1], in[2], out[0], out[1], out[2],
+                         qtab, pw, ph, quant ? 1 : 0);
+        else
+            run = kernel(in[0], in[1], in[2], out[0], out[1], out[2], pw, ph);
+        run.wait();
+        for (int c = 0; c < 3; c++) {
+            out[c].sync(XCL_BO_SYNC_BO_FROM_DEVICE, np * sizeof(coeff_t), 0);
+            out[c].read(dst[c], np * sizeof(coeff_t), 0);
+        }
+    };
+
+    // One launch per thumbnail
+    vector<vector<coeff_t>> single[3];
+    for (int c = 0; c < 3; c++) single[c].resize(n);
+    auto t0 = clock::now();
+    for (int i = 0; i < n; i++) {
+        const pixel_t* src[3];
+        coeff_t* dst[3];
+        for (int c = 0; c < 3; c++) {
+            single[c][i].resize(thumbs[c][i].size());
+            src[c] = thumbs[c][i].data();
+            dst[c] = single[c][i].data();
+        }
+        transform(src, sizes[i].first, sizes[i].second, dst);
+    }
+    auto t1 = clock::now();
+
+    // One launch over the atlas
+    vector<pixel_t> apix[3];
+    vector<coeff_t> acoef[3];
+    vector<vector<coeff_t>> scattered[3];
+    auto t2 = clock::now();
+    for (int c = 0; c < 3; c++) {
+        vector<const pixel_t*> src(n);
+        for (int i = 0; i < n; i++) src[i] = thumbs[c][i].data();
+        atlas_pack(src, atlas, apix[c]);
+        acoef[c].resize(atlas.size());
+    }
+    auto t3 = clock::now();
+    const pixel_t* asrc[3] = { apix[0].data(), apix[1].data(), apix[2].data() };
+    coeff_t* adst[3] = { acoef[0].data(), acoef[1].data(), acoef[2].data() };
+    transform(asrc, atlas.width, atlas.height, adst);
+    auto t4 = clock::now();
+    for (int c = 0; c < 3; c++) atlas_scatter(acoef[c], atlas, scattered[c]);
+    auto t5 = clock::now();
+
+    // Both paths against the CPU golden
+    long single_diff = 0, atlas_diff = 0;
+    size_t used = 0;
+    for (int i = 0; i < n; i++) {
+        used += size_t(round_up8(sizes[i].first)) * round_up8(sizes[i].second);
+        for (int c = 0; c < 3; c++) {
+            vector<coeff_t> gold;
+            cpu_dct_image(thumbs[c][i], sizes[i].first, sizes[i].second, gold);
+            if (quant) quantize_image(gold, sizes[i].first, sizes[i].second, qtabs[c]);
+            for (size_t k = 0; k < gold.size(); k++) {
+                single_diff += single[c][i][k] != gold[k];
+                atlas_diff += scattered[c][i][k] != gold[k];
+            }
+        }
+    }
+
+    double single_ms = ms(t0, t1), atlas_ms = ms(t2, t5);
+    auto flags = cout.flags();
+    auto prec = cout.precision();
+    cout << "\n========================================\n";
+    cout << "       ATLAS BENCHMARK (v" << variant << ")\n";
+    cout << "========================================\n";
+    cout << n << " thumbnails, " << atlas.width << " x " << atlas.height << " atlas ("
+         << std::fixed << std::setprecision(1) << 100.0 * used / atlas.size() << "% filled)\n\n";
+    cout << std::setprecision(3);
+    cout << "Launch per image:  " << single_ms << " ms (" << single_ms / n << " ms/image)\n";
+    cout << "One atlas launch:  " << atlas_ms << " ms (" << atlas_ms / n << " ms/image)\n";
+    cout << "  Pack:            " << ms(t2, t3) << " ms\n";
+    cout << "  Transfer+kernel: " << ms(t3, t4) << " ms\n";
+    cout << "  Scatter:         " << ms(t4, t5) << " ms\n";
+    cout << "Speedup:           " << std::setprecision(2) << single_ms / atlas_ms << "x\n";
+    cout << "\nCoefficient mismatches: per-image " << single_diff << ", atlas " << atlas_diff << "\n";
+    cout << "========================================\n";
+    cout.flags(flags);
+    cout.precision(prec);
+    return (single_diff || atlas_diff) ? 1 : 0;
+}
+
+// Multi-CU / multi-device benchmark: the input split into stripes (or,
+// with --split image, repeated as whole images) and spread over every
+// unit by a CuScheduler or DeviceScheduler. Jobs carry a round-robin
+// device affinity, which only the DeviceScheduler uses. Reports the
+// median wall time of a few rounds and per-unit jobs, blocks and
+// utilization (busy time / wall time).
+template <class Sched>
+static int run_cu_bench(Sched& sched, const char* title,
+                        const vector<pixel_t>* planes[3], int w, int h,
+                        const HostOptions& opt, const QuantTable qtabs[3])
+{
+    const int rounds = 5;
+    int njobs = opt.jobs ? opt.jobs : 4 * sched.num_units();
+
+    // Output planes: one image, or one per job in image mode
+    int nimages = opt.split_images ? njobs : 1;
+    vector<vector<coeff_t>> out[3];
+    for (int c = 0; c < 3; c++) out[c].assign(nimages, vector<coeff_t>(size_t(w) * h));
+
+    vector<DctJob> jobs;
+    if (opt.split_images) {
+        for (int i = 0; i < nimages; i++) {
+            DctJob j;
+            for (int c = 0; c < 3; c++) {
+                j.in[c] = planes[c]->data();
+                j.out[c] = out[c][i].data();
+            }
+            j.width = w;
+            j.height = h;
+            j.quant = opt.kernel_quant;
+            j.affinity = i % sched.num_units();
+            jobs.push_back(j);
+        }
+    } else {
+        // Stripe heights are whole block rows, so no block straddles two jobs
+        int brows = (h + 7) / 8;
+        njobs = std::min(njobs, brows);
+        for (int k = 0; k < njobs; k++) {
+            int y0 = 8 * (int)((long long)brows * k / njobs);
+            int y1 = std::min(h, 8 * (int)((long long)brows * (k + 1) / njobs));
+            DctJob j;
+            for (int c = 0; c < 3; c++) {
+                j.in[c] = planes[c]->data() + size_t(y0) * w;
+                j.out[c] = out[c][0].data() + size_t(y0) * w;
+            }
+            j.width = w;
+            j.height = y1 - y0;
+            j.quant = opt.kernel_quant;
+            j.affinity = k % sched.num_units();
+            jobs.push_back(j);
+        }
+    }
+
+    // Warm-up round (buffer allocation), then timed rounds
+    vector<double> wall(rounds);
+    try {
+        for (auto& j : jobs) sched.submit(j);
+        sched.wait();
+        sched.reset_stats();
+
+        for (int r = 0; r < rounds; r++) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            for (auto& j : jobs) sched.submit(j);
+            sched.wait();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            wall[r] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        }
+    } catch (const std::exception& e) {
+        cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+    double total_wall = 0;
+    for (double t : wall) total_wall += t;
+    std::sort(wall.begin(), wall.end());
+    double med = wall[rounds / 2];
+
+    long diff = 0;
+    for (int c = 0; c < 3; c++) {
+        vector<coeff_t> gold;
+        cpu_dct_image(*planes[c], w, h, gold);
+        if (opt.kernel_quant) quantize_image(gold, w, h, qtabs[c]);
+        for (auto& img : out[c])
+            for (size_t i = 0; i < gold.size(); i++) diff += img[i] != gold[i];
+    }
+
+    auto flags = cout.flags();
+    auto prec = cout.precision();
+    cout << "\n========================================\n";
+    cout << "       " << title << "\n";
+    cout << "========================================\n";
+    cout << sched.num_units() << " units, " << jobs.size()
+         << (opt.split_images ? " whole-image" : " stripe") << " jobs, "
+         << rounds << " rounds\n";
+    cout << "Wall time (median): " << std::fixed << std::setprecision(3) << med << " ms, "
+         << std::setprecision(2) << (double(w) * h * nimages / 1e6) / (med / 1000.0) << " MP/s\n\n";
+    cout << " Unit                              Jobs     Blocks   Busy ms   Util %\n";
+    for (auto& u : sched.stats()) {
+        cout << " " << std::left << std::setw(32) << u.name << std::right
+             << std::setw(6) << u.jobs << std::setw(11) << u.blocks
+             << std::setprecision(3) << std::setw(10) << u.busy_ms
+             << std::setprecision(1) << std::setw(9) << 100.0 * u.busy_ms / total_wall
+             << (u.failed ? "  FAILED" : "") << "\n";
+    }
+    cout << "\nCoefficient mismatches: " << diff << "\n";
+    cout << "========================================\n";
+    cout.flags(flags);
+    cout.precision(prec);
+    return diff ? 1 : 0;
+}
+
+// Adaptive dispatch benchmark: stripes of the input from one block row
+// to the whole image (log-uniform heights, fixed seed) arrive in bursts
+// and go to the CPU engine (unit 0) or a device unit, whichever the
+// AdaptiveDispatcher predicts finishes first. The same job list then runs
+// CPU only and device only, and adaptive again with the models the first
+// three passes trained. Each unit's model starts from one small and one
+// full-image job, the load + kernel + readback total PerfMetrics reports.
+// Every decision can be written to a CSV with --dispatch-log.
+static int run_adaptive_bench(AdaptiveDispatcher& disp,
+                              const vector<pixel_t>* planes[3], int w, int h,
+                              const HostOptions& opt, const QuantTable qtabs[3])
+{
+    const int burst = 8;
+    int njobs = opt.jobs ? opt.jobs : 200;
+    int brows = (h + 7) / 8;
+
+    vector<int> heights(njobs);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> logrows(0.0, std::log(double(brows) + 1.0));
+    for (auto& jh : heights)
+        jh = std::min(h, 8 * std::max(1, std::min(brows, (int)std::exp(logrows(rng)))));
+
+    vector<coeff_t> gold[3];
+    for (int c = 0; c < 3; c++) {
+        cpu_dct_image(*planes[c], w, h, gold[c]);
+        if (opt.kernel_quant) quantize_image(gold[c], w, h, qtabs[c]);
+    }
+    vector<coeff_t> out[burst][3];
+    for (int k = 0; k < burst; k++)
+        for (int c = 0; c < 3; c++) out[k][c].resize(size_t(w) * h);
+
+    auto make_job = [&](int k, int height) {
+        DctJob j;
+        for (int c = 0; c < 3; c++) {
+            j.in[c] = planes[c]->data();
+            j.out[c] = out[k][c].data();
+        }
+        j.width = w;
+        j.height = height;
+        j.quant = opt.kernel_quant;
+        return j;
+    };
+
+    long diff = 0;
+    auto check = [&](int k, int height) {
+        size_t n = size_t(w) * height;
+        for (int c = 0; c < 3; c++)
+            for (size_t i = 0; i < n; i++) diff += out[k][c][i] != gold[c][i];
+    };
+
+    struct Pass {
+        const char* name;
+        uint64_t allowed;
+        double wall_ms;
+        vector<DispatchRecord> records;
+        vector<DctUnitStats> stats;
+    };
+    const uint64_t all = ~uint64_t(0);
+    vector<Pass> passes = {
+        { "adaptive (cold)", all, 0, {}, {} },
+        { "CPU only", 1, 0, {}, {} },
+        { "device only", all & ~uint64_t(1), 0, {}, {} },
+        { "adaptive (trained)", all, 0, {}, {} },
+    };
+
+    try {
+        // Calibration: a warm-up job per unit (buffer allocation), then a
+        // fit through one block row and the full image
+        int small = std::min(h, 8);
+        for (int u = 0; u < disp.num_units(); u++) {
+            disp.submit(make_job(0, h), uint64_t(1) << u);
+            disp.wait();
+            disp.set_model(u, CostModel());
+            for (int r = 0; r < 2; r++) {
+                disp.submit(make_job(0, small), uint64_t(1) << u);
+                disp.wait();
+                disp.submit(make_job(0, h), uint64_t(1) << u);
+                disp.wait();
+            }
+        }
+        disp.take_records();
+        disp.reset_stats();
+
+        for (auto& p : passes) {
+            for (int j0 = 0; j0 < njobs; j0 += burst) {
+                int n = std::min(burst, njobs - j0);
+                auto t0 = std::chrono::high_resolution_clock::now();
+                for (int k = 0; k < n; k++) disp.submit(make_job(k, heights[j0 + k]), p.allowed);
+                disp.wait();
+                auto t1 = std::chrono::high_resolution_clock::now();
+                p.wall_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+                for (int k = 0; k < n; k++) check(k, heights[j0 + k]);
+            }
+            p.records = disp.take_records();
+            p.stats = disp.stats();
+            disp.reset_stats();
+        }
+    } catch (const std::exception& e) {
+        cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+
+    size_t total_blocks = 0;
+    double total_px = 0;
+    for (int jh : heights) {
+        total_blocks += size_t((w + 7) / 8) * ((jh + 7) / 8);
+        total_px += double(w) * jh;
+    }
+
+    auto flags = cout.flags();
+    auto prec = cout.precision();
+    cout << "\n========================================\n";
+    cout << "       ADAPTIVE DISPATCH BENCHMARK\n";
+    cout << "========================================\n";
+    cout << disp.num_units() << " units, " << njobs << " stripe jobs of 1.." << brows
+         << " block rows (" << total_blocks << " blocks), bursts of " << burst << "\n\n";
+    cout << " Pass                  Wall ms     MP/s  Jobs per unit        |err| mean  p90\n";
+    for (auto& p : passes) {
+        vector<double> err;
+        double sum = 0;
+        for (auto& r : p.records) {
+            double e = 100.0 * std::fabs(r.actual_ms - r.predicted_ms) / std::max(r.actual_ms, 1e-3);
+            err.push_back(e);
+            sum += e;
+        }
+        std::sort(err.begin(), err.end());
+        std::string split;
+        for (auto& s : p.stats) split += (split.empty() ? "" : "/") + std::to_string(s.jobs);
+        cout << " " << std::left << std::setw(20) << p.name << std::right << std::fixed
+             << std::setprecision(3) << std::setw(10) << p.wall_ms
+             << std::setprecision(2) << std::setw(9)
+             << (total_px / 1e6) / (p.wall_ms / 1000.0)
+             << "  " << std::left << std::setw(18) << split << std::right
+             << std::setprecision(1) << std::setw(9) << (err.empty() ? 0 : sum / err.size()) << "%"
+             << std::setw(6) << (err.empty() ? 0 : err[err.size() * 9 / 10]) << "%\n";
+    }
+
+    // Where the trained models put the CPU/device crossover
+    cout << "\n Unit                               Fixed ms    us/block  Samples\n";
+    for (int u = 0; u < disp.num_units(); u++) {
+        CostModel m = disp.model(u);
+        cout << " " << std::left << std::setw(32) << disp.unit_name(u) << std::right
+             << std::setprecision(3) << std::setw(11) << m.fixed_ms()
+             << std::setw(12) << 1000.0 * m.ms_per_block()
+             << std::setw(9) << m.samples() << "\n";
+    }
+    if (disp.num_units() > 1) {
+        CostModel cpu = disp.model(0), dev = disp.model(1);
+        double slope = cpu.ms_per_block() - dev.ms_per_block();
+        if (slope > 0 && dev.fixed_ms() > cpu.fixed_ms())
+            cout << "Crossover (idle units): device wins above "
+                 << std::setprecision(0) << (dev.fixed_ms() - cpu.fixed_ms()) / slope << " blocks\n";
+        else
+            cout << "Crossover (idle units): none, "
+                 << (dev.predict(1) < cpu.predict(1) ? "device" : "CPU") << " wins at every size\n";
+    }
+
+    if (!opt.dispatch_log.empty()) {
+        std::ofstream log(opt.dispatch_log);
+        log << "pass,job,blocks,unit,queue_ms,predicted_ms,actual_ms\n";
+        log << std::setprecision(4);
+        for (auto& p : passes)
+            for (auto& r : p.records)
+                log << p.name << "," << r.id << "," << r.blocks << "," << disp.unit_name(r.unit)
+                    << "," << r.queue_ms << "," << r.predicted_ms << "," << r.actual_ms << "\n";
+        cout << "Decisions written to " << opt.dispatch_log << "\n";
+    }
+
+    cout << "\nCoefficient mismatches: " << diff << "\n";
+    cout << "========================================\n";
+    cout.flags(flags);
+    cout.precision(prec);
+    return diff ? 1 : 0;
+}
+
+// Cooperative single-image benchmark: the whole input on the CPU engine
+// alone, on the device alone, and split between both by coop_run (device
+// from the top, CPU from the bottom). The expected device share comes
+// from the two single-unit times. Reports median latencies, the split
+// actually reached and each side's throughput while it was busy.
+static int run_coop_bench(DctUnit& dev, DctUnit& cpu,
+                          const vector<pixel_t>* planes[3], int w, int h,
+                          const HostOptions& opt, const QuantTable qtabs[3])
+{
+    const int rounds = 5;
+    int brows = (h + 7) / 8;
+
+    vector<coeff_t> out[3];
+    for (int c = 0; c < 3; c++) out[c].resize(size_t(w) * h);
+    DctJob image;
+    for (int c = 0; c < 3; c++) {
+        image.in[c] = planes[c]->data();
+        image.out[c] = out[c].data();
+    }
+    image.width = w;
+    image.height = h;
+    image.quant = opt.kernel_quant;
+
+    vector<coeff_t> gold[3];
+    for (int c = 0; c < 3; c++) {
+        cpu_dct_image(*planes[c], w, h, gold[c]);
+        if (opt.kernel_quant) quantize_image(gold[c], w, h, qtabs[c]);
+    }
+    long diff[3] = {0, 0, 0};
+    auto check = [&](long& d) {
+        for (int c = 0; c < 3; c++) {
+            for (size_t i = 0; i < gold[c].size(); i++) d += out[c][i] != gold[c][i];
+            std::fill(out[c].begin(), out[c].end(), coeff_t(0));
+        }
+    };
+
+    // Median of `rounds` runs of fn after one warm-up run (buffer allocation)
+    auto median_ms = [&](auto fn, long& d) {
+        vector<double> t(rounds);
+        fn();
+        check(d);
+        for (int r = 0; r < rounds; r++) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            fn();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            t[r] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            check(d);
+        }
+        std::sort(t.begin(), t.end());
+        return t[rounds / 2];
+    };
+
+    // The device's smallest claim covers its launch overhead several times
+    // over; the CPU works down to single block rows
+    DctUnit* units[2] = { &dev, &cpu };
+    const int min_rows[2] = { std::max(1, brows / 16), 1 };
+    double cpu_ms, dev_ms, share;
+    vector<CoopResult> coop(rounds);
+    try {
+        cpu_ms = median_ms([&] { cpu.run(image); }, diff[0]);
+        dev_ms = median_ms([&] { dev.run(image); }, diff[1]);
+        share = (1.0 / dev_ms) / (1.0 / dev_ms + 1.0 / cpu_ms);
+        coop_run(units, image, share, min_rows);
+        check(diff[2]);
+        for (int r = 0; r < rounds; r++) {
+            coop[r] = coop_run(units, image, share, min_rows);
+            check(diff[2]);
+        }
+    } catch (const std::exception& e) {
+        cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+    std::sort(coop.begin(), coop.end(),
+              [](const CoopResult& a, const CoopResult& b) { return a.wall_ms < b.wall_ms; });
+    const CoopResult& med = coop[rounds / 2];
+
+    double mp = double(w) * h / 1e6;
+    auto flags = cout.flags();
+    auto prec = cout.precision();
+    cout << "\n========================================\n";
+    cout << "       CPU + DEVICE CO-PROCESSING\n";
     cout << "========================================\n";
+    cout << "Image " << w << "x" << h << " (" << brows << " block rows), "
+         << rounds << " rounds, median latency\n";
+    cout << std::fixed << std::setprecision(3);
+    cout << "CPU alone:    " << std::setw(10) << cpu_ms << " ms  "
+         << std::setprecision(2) << std::setw(8) << mp / (cpu_ms / 1000.0) << " MP/s\n";
+    cout << std::setprecision(3);
+    cout << "Device alone: " << std::setw(10) << dev_ms << " ms  "
+         << std::setprecision(2) << std::setw(8) << mp / (dev_ms / 1000.0) << " MP/s\n";
+    cout << std::setprecision(3);
+    cout << "Cooperative:  " << std::setw(10) << med.wall_ms << " ms  "
+         << std::setprecision(2) << std::setw(8) << mp / (med.wall_ms / 1000.0) << " MP/s  ("
+         << std::min(cpu_ms, dev_ms) / med.wall_ms << "x the faster side alone)\n\n";
+    cout << "Expected device share: " << std::setprecision(1) << 100.0 * share << "%\n";
+    cout << " Side                              Stripes  Rows %   Busy ms     MP/s  Idle ms\n";
+    for (auto& s : med.side) {
+        double px = double(w) * std::min(h, 8 * s.block_rows);
+        cout << " " << std::left << std::setw(32) << s.name << std::right
+             << std::setw(9) << s.stripes
+             << std::setprecision(1) << std::setw(8) << 100.0 * s.block_rows / brows
+             << std::setprecision(3) << std::setw(10) << s.busy_ms
+             << std::setprecision(2) << std::setw(9) << (s.busy_ms > 0 ? px / 1e6 / (s.busy_ms / 1000.0) : 0)
+             << std::setprecision(3) << std::setw(9) << med.wall_ms - s.busy_ms << "\n";
+    }
+    cout << "\nCoefficient mismatches: CPU " << diff[0] << ", device " << diff[1]
+         << ", cooperative " << diff[2] << "\n";
+    cout << "========================================\n";
+    cout.flags(flags);
+    cout.precision(prec);
+    return (diff[0] || diff[1] || diff[2]) ? 1 : 0;
+}
+
+// PSNR of one channel from its sum of squared errors over n pixels, as
+// compute_psnr_channel reports it
+static double psnr_from_sse(uint64_t sse, size_t n)
+{
+    double mse = double(sse) / double(n);
+    if (mse == 0.0) return 99.0;
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+// Quality audit on a v10 kernel: DCT, quantize, dequantize, IDCT and the
+// squared error all run on the device, which returns three 64-bit sums
+// (and, with --recon, the reconstructed pixels). Full verification runs
+// the host's own quality check (golden DCT, then reconstruct_plane) and
+// compares PSNRs; the DCT itself may differ by 1 in a few coefficients,
+// so the two agree to within PSNR_TOL_DB rather than exactly. Grayscale
+// goes to every port (each port has its own buffer in its own bank), and
+// only channel 0's results are read.
+static int run_roundtrip_audit(xrt::device& device, xrt::kernel& kernel,
+                               const vector<pixel_t>* planes[3], int nplanes, int w, int h,
+                               const QuantTable qtabs[3], const HostOptions& opt,
+                               const std::string& output_png)
+{
+    const double PSNR_TOL_DB = 0.05;
+    const size_t n = size_t(w) * h;
+    // Untouched without recon_en, so a token buffer will do
+    const size_t out_bytes = opt.recon_pixels ? n * sizeof(pixel_t) : 64;
+
+    vector<uint32_t> qwords;
+    pack_roundtrip_tables(qtabs, qwords);
+    auto bo_qtab = xrt::bo(device, qwords.size() * sizeof(uint32_t), xrt::bo::flags::normal, kernel.group_id(6));
+    bo_qtab.write(qwords.data());
+    bo_qtab.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+
+    xrt::bo bo_in[3], bo_out[3];
+    for (int c = 0; c < 3; c++) {
+        bo_in[c] = xrt::bo(device, n * sizeof(pixel_t), xrt::bo::flags::normal, kernel.group_id(c));
+        bo_out[c] = xrt::bo(device, out_bytes, xrt::bo::flags::normal, kernel.group_id(3 + c));
+    }
+    auto bo_sse = xrt::bo(device, 3 * sizeof(uint64_t), xrt::bo::flags::normal, kernel.group_id(10));
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int c = 0; c < 3; c++) {
+        bo_in[c].write(planes[c]->data());
+        bo_in[c].sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    auto run = kernel(bo_in[0], bo_in[1], bo_in[2], bo_out[0], bo_out[1], bo_out[2],
+                      bo_qtab, w, h, opt.recon_pixels ? 1 : 0, bo_sse);
+    run.wait();
+    auto t2 = std::chrono::high_resolution_clock::now();
+    uint64_t sse[3];
+    bo_sse.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+    bo_sse.read(sse);
+    vector<pixel_t> recon[3];
+    if (opt.recon_pixels) {
+        for (int c = 0; c < nplanes; c++) {
+            recon[c].resize(n);
+            bo_out[c].sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+            bo_out[c].read(recon[c].data());
+        }
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    auto ms = [](std::chrono::high_resolution_clock::time_point a,
+                 std::chrono::high_resolution_clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    size_t read_bytes = sizeof(sse) + (opt.recon_pixels ? nplanes * n * sizeof(pixel_t) : 0);
+
+    static const char* const rgb_names[3] = { "R", "G", "B" };
+    static const char* const gray_names[1] = { "Gray" };
+    const char* const* names = nplanes == 1 ? gray_names : rgb_names;
+
+    auto flags = cout.flags();
+    auto prec = cout.precision();
+    cout << "\n========================================\n";
+    cout << "       ROUND TRIP AUDIT (v10)\n";
+    cout << "========================================\n";
+    cout << "Image: " << w << " x " << h << ", quality " << opt.quality << "\n";
+    cout << std::fixed << std::setprecision(3);
+    cout << "Upload:             " << ms(t0, t1) << " ms\n";
+    cout << "Kernel:             " << ms(t1, t2) << " ms ("
+         << std::setprecision(2) << (n / 1e6) / (ms(t1, t2) / 1000.0) << " MP/s)\n";
+    cout << "Readback:           " << std::setprecision(3) << ms(t2, t3) << " ms, " << read_bytes
+         << " bytes (coefficients would be " << nplanes * n * sizeof(coeff_t) << ")\n\n";
+
+    int failed = 0;
+    vector<coeff_t> gold;
+    vector<pixel_t> host_recon;
+    PlaneDims dims = {w, h};
+    const bool check = opt.verify.mode == VerifyPolicy::FULL;
+    cout << (check ? " Chan  Device PSNR    Host PSNR    Delta dB" : " Chan  Device PSNR") << "\n";
+    for (int c = 0; c < nplanes; c++) {
+        double dev_psnr = psnr_from_sse(sse[c], n);
+        cout << std::setw(5) << names[c] << std::setprecision(2) << std::setw(13) << dev_psnr;
+        if (check) {
+            cpu_dct_image(*planes[c], w, h, gold);
+            reconstruct_plane(gold, dims, qtabs[c], false, host_recon);
+            double host_psnr = compute_psnr_channel(*planes[c], host_recon);
+            double delta = dev_psnr - host_psnr;
+            bool ok = std::fabs(delta) <= PSNR_TOL_DB;
+            failed += !ok;
+            cout << std::setw(13) << host_psnr << std::setprecision(4) << std::setw(12) << delta
+                 << (ok ? "" : "  MISMATCH");
+            if (opt.recon_pixels) {
+                long diff = 0;
+                int max_diff = 0;
+                for (size_t i = 0; i < n; i++) {
+                    int d = std::abs(int(recon[c][i]) - int(host_recon[i]));
+                    diff += d != 0;
+                    max_diff = std::max(max_diff, d);
+                }
+                cout << "  (" << diff << " pixels differ, max " << max_diff << ")";
+            }
+        }
+        cout << "\n";
+    }
+    if (!check) cout << "Host check: off (needs --verify full)\n";
+    cout << "========================================\n";
+    cout.flags(flags);
+    cout.precision(prec);
+
+    if (opt.recon_pixels) {
+        vector<unsigned char> out_img(n * nplanes);
+        for (size_t i = 0; i < n; i++)
+            for (int c = 0; c < nplanes; c++) out_img[i * nplanes + c] = recon[c][i];
+        if (!stbi_write_png(output_png.c_str(), w, h, nplanes, out_img.data(), w * nplanes))
+            cerr << "WARNING: Failed to write " << output_png << "\n";
+        else
+            cout << "Saved reconstructed image: " << output_png << "\n";
+    }
+    return failed ? 1 : 0;
+}
+
+// Reconstruction on idct_accel (hls/idct_accel.cpp): the quantized
+// coefficients go up and the kernel dequantizes, transforms and clamps.
+// Equal-size planes share one launch; otherwise (4:2:0, grayscale) each
+// plane gets its own, fed to all three channels with its table in every
+// slot, and only the first output is read. Returns the time spent,
+// transfers included.
+static double device_reconstruct(xrt::device& device, xrt::kernel& idct,
+                                 const vector<coeff_t>* coeffs[3], const PlaneDims dims[3],
+                                 int nplanes, const QuantTable qtabs[3], bool quantized,
+                                 vector<pixel_t> recon[3])
+{
+    auto t0 = std::chrono::high_resolution_clock::now();
+    vector<coeff_t> quant[3];
+    const vector<coeff_t>* src[3] = { coeffs[0], coeffs[1], coeffs[2] };
+    if (!quantized) {
+        for (int c = 0; c < nplanes; c++) {
+            quant[c] = *coeffs[c];
+            quantize_image(quant[c], dims[c].width, dims[c].height, qtabs[c]);
+            src[c] = &quant[c];
+        }
+    }
+
+    auto launch = [&](const int chans[3], int nout) {
+        const PlaneDims& d = dims[chans[0]];
+        const size_t n = d.size();
+        QuantTable tabs[3] = { qtabs[chans[0]], qtabs[chans[1]], qtabs[chans[2]] };
+        vector<uint32_t> steps;
+        pack_dequant_tables(tabs, steps);
+        auto bo_qtab = xrt::bo(device, steps.size() * sizeof(uint32_t), xrt::bo::flags::normal, idct.group_id(6));
+        bo_qtab.write(steps.data());
+        bo_qtab.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+        xrt::bo bo_in[3], bo_out[3];
+        for (int c = 0; c < 3; c++) {
+            bo_in[c] = xrt::bo(device, n * sizeof(coeff_t), xrt::bo::flags::normal, idct.group_id(c));
+            bo_out[c] = xrt::bo(device, n * sizeof(pixel_t), xrt::bo::flags::normal, idct.group_id(3 + c));
+            bo_in[c].write(src[chans[c]]->data());
+            bo_in[c].sync(XCL_BO_SYNC_BO_TO_DEVICE);
+        }
+        auto run = idct(bo_in[0], bo_in[1], bo_in[2], bo_out[0], bo_out[1], bo_out[2],
+                        bo_qtab, d.width, d.height, 1);
+        run.wait();
+        for (int c = 0; c < nout; c++) {
+            recon[chans[c]].resize(n);
+            bo_out[c].sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+            bo_out[c].read(recon[chans[c]].data());
+        }
+    };
+
+    if (nplanes == 3 && dims[1].width == dims[0].width && dims[1].height == dims[0].height &&
+        dims[2].width == dims[0].width && dims[2].height == dims[0].height) {
+        const int chans[3] = { 0, 1, 2 };
+        launch(chans, 3);
+    } else {
+        for (int c = 0; c < nplanes; c++) {
+            const int chans[3] = { c, c, c };
+            launch(chans, 1);
+        }
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+static void print_usage(const char* prog)
+{
+    cerr << "Usage: " << prog
+         << " <xclbin> <input.png> <output.png> [options]\n"
+         << "Options:\n"
+         << "  --huffman-opt    two-pass Huffman coding with optimized per-image tables\n"
+         << "  --rans           code the RLE symbol stream with the rANS backend\n"
+         << "  --rans-out FILE  also write the rANS container to FILE (implies --rans)\n"
+         << "  --quality N      libjpeg-style quality 1..100 (default 50)\n"
+         << "  --chroma-tables  quantize channels 1 and 2 with the chroma table\n"
+         << "  --kernel-quant   quantize on the device (needs a v4+ xclbin)\n"
+         << "  --variant N      kernel variant if it cannot be taken from the xclbin name\n"
+         << "  --sweep LIST     bpp/PSNR table for comma-separated quality levels (e.g. 10,50,90)\n"
+         << "  --ycc420         transform YCbCr 4:2:0 instead of RGB (on the device with v5)\n"
+         << "  --tiled          run the CPU golden DCT on block-major tiles (default with v7, v11)\n"
+         << "  --batch N        v8: latency/throughput of batches of 1..N copies of the input\n"
+         << "  --atlas N        v1-v4: N thumbnails of the input, per-image launches vs one atlas\n"
+         << "  --cus N          v1-v4: spread the input over N compute units (0 = all in the xclbin)\n"
+         << "  --emu-cus N      like --cus on N emulated CUs (no card needed)\n"
+         << "  --split MODE     with --cus: 'stripe' (default) or 'image'\n"
+         << "  --jobs N         with --cus/--devices: number of stripes or images (default 4 per unit)\n"
+         << "  --devices LIST   v1-v4: spread the input over cards (comma-separated indices or 'all')\n"
+         << "  --emu-devices N  like --devices on N emulated cards\n"
+         << "  --emu-fail-after K  emulated card 0 fails after K jobs\n"
+         << "  --adaptive       v1-v4: route mixed-size stripes to CPU or device by an online cost model\n"
+         << "                   (with --emu-cus N: N emulated device units, else every CU in the xclbin)\n"
+         << "  --emu-overhead MS  emulated units: fixed time per job (sync + launch + wait)\n"
+         << "  --emu-rate B     emulated units: blocks per ms\n"
+         << "  --dispatch-log FILE  with --adaptive: write every decision to FILE (CSV)\n"
+         << "  --coop           v1-v4: one image split between the CPU engine and one device CU\n"
+         << "                   (with --emu-cus: an emulated CU)\n"
+         << "  --verify MODE    check device output: full (default), off, sample:K blocks or sample:P%\n"
+         << "  --verify-seed N  RNG seed for --verify sample (default 1)\n"
+         << "  --mismatch-report  error histogram, per-position heatmaps and worst blocks\n"
+         << "                   (printed anyway when full verification finds mismatches)\n"
+         << "  --worst N        blocks listed by the mismatch analysis (default 8)\n"
+         << "  --recon          v10: also read back the reconstructed image and write it\n"
+         << "  --device-idct    reconstruct on idct_accel (xclbin linked with IDCT=1)\n"
+         << "  --kernel-mhz F   v12: kernel clock for the stage report (default 300)\n";
+}
+
+// Kernel variant from the Makefile's naming (build/vN_dct_accel_<target>.xclbin);
+// anything else is assumed to have the v1-v3 argument list
+static int variant_from_xclbin(const std::string& path)
+{
+    size_t slash = path.find_last_of('/');
+    std::string base = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    if (base.size() > 2 && base[0] == 'v' && isdigit((unsigned char)base[1]))
+        return atoi(base.c_str() + 1);
+    return 3;
+}
+
+static bool parse_options(int argc, char** argv, HostOptions& opt)
+{
+    for (int i = 4; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--huffman-opt") {
+            opt.optimize_huffman = true;
+        } else if (a == "--rans") {
+            opt.rans = true;
+        } else if (a == "--rans-out" && i + 1 < argc) {
+            opt.rans = true;
+            opt.rans_out = argv[++i];
+        } else if (a == "--quality" && i + 1 < argc) {
+            opt.quality = atoi(argv[++i]);
+            if (opt.quality < 1 || opt.quality > 100) {
+                cerr << "ERROR: --quality must be 1..100\n";
+                return false;
+            }
+        } else if (a == "--chroma-tables") {
+            opt.chroma_tables = true;
+        } else if (a == "--kernel-quant") {
+            opt.kernel_quant = true;
+        } else if (a == "--variant" && i + 1 < argc) {
+            opt.variant = atoi(argv[++i]);
+        } else if (a == "--recon") {
+            opt.recon_pixels = true;
+        } else if (a == "--device-idct") {
+            opt.device_idct = true;
+        } else if (a == "--kernel-mhz" && i + 1 < argc) {
+            opt.kernel_mhz = atof(argv[++i]);
+            if (opt.kernel_mhz <= 0) {
+                cerr << "ERROR: --kernel-mhz must be positive\n";
+                return false;
+            }
+        } else if (a == "--ycc420") {
+            opt.ycc420 = true;
+        } else if (a == "--atlas" && i + 1 < argc) {
+            opt.atlas = atoi(argv[++i]);
+            if (opt.atlas < 1) {
+                cerr << "ERROR: --atlas needs at least one image\n";
+                return false;
+            }
+        } else if (a == "--cus" && i + 1 < argc) {
+            opt.cus = atoi(argv[++i]);
+        } else if (a == "--emu-cus" && i + 1 < argc) {
+            opt.emu_cus = atoi(argv[++i]);
+            if (opt.emu_cus < 1) {
+                cerr << "ERROR: --emu-cus needs at least one unit\n";
+                return false;
+            }
+        } else if (a == "--split" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode != "image" && mode != "stripe") {
+                cerr << "ERROR: --split is 'image' or 'stripe'\n";
+                return false;
+            }
+            opt.split_images = mode == "image";
+        } else if (a == "--jobs" && i + 1 < argc) {
+            opt.jobs = atoi(argv[++i]);
+        } else if (a == "--devices" && i + 1 < argc) {
+            std::string list = argv[++i];
+            if (list == "all") {
+                opt.all_devices = true;
+            } else {
+                size_t pos = 0;
+                while (pos <= list.size()) {
+                    size_t comma = list.find(',', pos);
+                    if (comma == std::string::npos) comma = list.size();
+                    opt.devices.push_back(atoi(list.substr(pos, comma - pos).c_str()));
+                    pos = comma + 1;
+                }
+            }
+        } else if (a == "--emu-devices" && i + 1 < argc) {
+            opt.emu_devices = atoi(argv[++i]);
+            if (opt.emu_devices < 1) {
+                cerr << "ERROR: --emu-devices needs at least one device\n";
+                return false;
+            }
+        } else if (a == "--emu-fail-after" && i + 1 < argc) {
+            opt.emu_fail_after = atoi(argv[++i]);
+        } else if (a == "--adaptive") {
+            opt.adaptive = true;
+        } else if (a == "--emu-overhead" && i + 1 < argc) {
+            opt.emu_overhead_ms = atof(argv[++i]);
+        } else if (a == "--emu-rate" && i + 1 < argc) {
+            opt.emu_rate = atof(argv[++i]);
+        } else if (a == "--dispatch-log" && i + 1 < argc) {
+            opt.dispatch_log = argv[++i];
+        } else if (a == "--coop") {
+            opt.coop = true;
+        } else if (a == "--verify" && i + 1 < argc) {
+            if (!parse_verify_policy(argv[++i], opt.verify)) {
+                cerr << "ERROR: --verify is full, off, sample:K or sample:P%\n";
+                return false;
+            }
+        } else if (a == "--mismatch-report") {
+            opt.mismatch_report = true;
+        } else if (a == "--worst" && i + 1 < argc) {
+            opt.worst_blocks = std::max(0, atoi(argv[++i]));
+        } else if (a == "--verify-seed" && i + 1 < argc) {
+            opt.verify.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (a == "--tiled") {
+            opt.tiled = true;
+        } else if (a == "--batch" && i + 1 < argc) {
+            opt.batch = atoi(argv[++i]);
+            if (opt.batch < 1 || opt.batch > BATCH_MAX_IMAGES) {
+                cerr << "ERROR: --batch must be 1.." << BATCH_MAX_IMAGES << "\n";
+                return false;
+            }
+        } else if (a == "--sweep" && i + 1 < argc) {
+            std::string list = argv[++i];
+            size_t pos = 0;
+            while (pos <= list.size()) {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) comma = list.size();
+                int q = atoi(list.substr(pos, comma - pos).c_str());
+                if (q < 1 || q > 100) {
+                    cerr << "ERROR: --sweep levels must be 1..100\n";
+                    return false;
+                }
+                opt.sweep.push_back(q);
+                pos = comma + 1;
+            }
+        } else {
+            cerr << "ERROR: Unknown option " << a << "\n";
+            return false;
+        }
+    }
+    return true;
 }
 
 int main(int argc, char** argv)
 {
-    if (argc != 4) {
-        cerr << "Usage: " << argv[0]
-             << " <xclbin> <input.png> <output.png>\n";
+    HostOptions opt;
+    if (argc < 4 || !parse_options(argc, argv, opt)) {
+        print_usage(argv[0]);
         return 1;
     }
 
@@ -247,23 +1883,329 @@ int main(int argc, char** argv)
     std::string input_png   = argv[2];
     std::string output_png  = argv[3];
 
+    if (opt.variant == 0) opt.variant = variant_from_xclbin(xclbin_file);
+    if (opt.variant == 7 || opt.variant == 11) opt.tiled = true;
+    if ((opt.variant == 8) != (opt.batch > 0)) {
+        cerr << "ERROR: --batch runs on a v8 kernel, and v8 only runs --batch\n";
+        return 1;
+    }
+    if (opt.atlas && (opt.variant < 1 || opt.variant > 4)) {
+        cerr << "ERROR: --atlas needs a raster v1-v4 kernel\n";
+        return 1;
+    }
+    const bool multi_dev = !opt.devices.empty() || opt.all_devices || opt.emu_devices > 0;
+    const bool multi_cu = opt.cus >= 0 || opt.emu_cus > 0 || multi_dev || opt.adaptive || opt.coop;
+    if ((opt.cus >= 0 || !opt.devices.empty() || opt.all_devices ||
+         ((opt.adaptive || opt.coop) && !opt.emu_cus)) &&
+        (opt.variant < 1 || opt.variant > 4)) {
+        cerr << "ERROR: --cus/--devices/--adaptive/--coop need a raster v1-v4 kernel\n";
+        return 1;
+    }
+    if (opt.variant == 10 && (opt.ycc420 || opt.kernel_quant || !opt.sweep.empty())) {
+        cerr << "ERROR: v10 audits the planes as loaded and always quantizes; "
+                "drop --ycc420/--kernel-quant/--sweep\n";
+        return 1;
+    }
+    if (opt.device_idct && (opt.batch || opt.atlas || multi_cu || opt.variant == 10)) {
+        cerr << "ERROR: --device-idct reconstructs in the single-image run; "
+                "drop --batch/--atlas/--cus/--devices/--adaptive/--coop or use a v1-v9 kernel\n";
+        return 1;
+    }
+    if ((opt.batch || opt.atlas || multi_cu) && opt.ycc420) {
+        cerr << "ERROR: --batch/--atlas/--cus transform the planes as loaded; drop --ycc420\n";
+        return 1;
+    }
+    if (opt.kernel_quant && opt.variant < 4) {
+        cerr << "ERROR: --kernel-quant needs a v4 or later kernel\n";
+        return 1;
+    }
+    if (opt.kernel_quant && opt.variant == 11) {
+        cerr << "ERROR: v11 is free-running and has no quant table port; drop --kernel-quant\n";
+        return 1;
+    }
+    if (opt.kernel_quant && !opt.sweep.empty()) {
+        cerr << "ERROR: --sweep needs raw coefficients; drop --kernel-quant\n";
+        return 1;
+    }
+
     // ------------------ Load image ------------------
+    // Grayscale (and gray + alpha) inputs stay a single plane end to end
     int w, h, ch;
-    unsigned char* img = stbi_load(input_png.c_str(), &w, &h, &ch, 3);
+    if (!stbi_info(input_png.c_str(), &w, &h, &ch)) {
+        cerr << "ERROR: Cannot load input image\n";
+        return 1;
+    }
+    const bool gray = ch <= 2;
+    const int nplanes = gray ? 1 : 3;
+    unsigned char* img = stbi_load(input_png.c_str(), &w, &h, &ch, nplanes);
     if (!img) {
         cerr << "ERROR: Cannot load input image\n";
         return 1;
     }
-    cout << "Loaded " << w << "x" << h << " (3 channels)\n";
-
-    vector<pixel_t> R(w*h), G(w*h), B(w*h);
-    for (int i = 0; i < w*h; i++) {
-        R[i] = img[3*i + 0];
-        G[i] = img[3*i + 1];
-        B[i] = img[3*i + 2];
+    cout << "Loaded " << w << "x" << h << " (" << nplanes
+         << (gray ? " channel, grayscale" : " channels") << ")\n";
+
+    // R holds the gray plane for grayscale inputs
+    vector<pixel_t> R(w*h), G, B;
+    if (gray) {
+        std::copy(img, img + size_t(w) * h, R.begin());
+    } else {
+        G.resize(w*h);
+        B.resize(w*h);
+        for (int i = 0; i < w*h; i++) {
+            R[i] = img[3*i + 0];
+            G[i] = img[3*i + 1];
+            B[i] = img[3*i + 2];
+        }
     }
     stbi_image_free(img);
 
+    // v5 converts RGB->YCbCr 4:2:0 on the device; v1-v4 get host-converted
+    // planes. Grayscale is already luma, so there is nothing to convert.
+    if (opt.variant == 5) opt.ycc420 = true;
+    if (gray) opt.ycc420 = false;
+    const bool kernel_color = opt.ycc420 && opt.variant == 5;
+    if (opt.ycc420) opt.chroma_tables = true;
+
+    // Quant tables: channel 0 luma, channels 1-2 luma or chroma
+    QuantTable qtabs[3];
+    quant_table_init(qtabs[0], Q_luma, opt.quality);
+    for (int c = 1; c < 3; c++)
+        quant_table_init(qtabs[c], opt.chroma_tables ? Q_chroma : Q_luma, opt.quality);
+
+    // A grayscale image fills all three channels for the benchmarks below
+    const vector<pixel_t>* bench_planes[3] = { &R, gray ? &R : &G, gray ? &R : &B };
+
+    if (opt.coop) {
+        CpuUnit cpu("cpu (" + std::to_string(host_num_threads()) + " threads)", qtabs);
+        if (opt.emu_cus) {
+            EmuUnit dev("emu:0", qtabs);
+            dev.set_timing(opt.emu_overhead_ms, opt.emu_rate);
+            return run_coop_bench(dev, cpu, bench_planes, w, h, opt, qtabs);
+        }
+        vector<std::string> names = discover_cus(xclbin_file, "dct_accel");
+        if (names.empty()) {
+            cerr << "ERROR: no dct_accel compute units in " << xclbin_file << "\n";
+            return 1;
+        }
+        cout << "Opening device 0 (" << names[0] << ")...\n";
+        xrt::device device(0);
+        auto uuid = device.load_xclbin(xclbin_file);
+        vector<uint32_t> qwords;
+        pack_quant_tables(qtabs, qwords);
+        XrtUnit dev(device, uuid, names[0], opt.variant, qwords);
+        return run_coop_bench(dev, cpu, bench_planes, w, h, opt, qtabs);
+    }
+
+    if (opt.adaptive) {
+        // Unit 0 is the CPU engine, the rest device units
+        vector<std::unique_ptr<DctUnit>> units;
+        units.emplace_back(new CpuUnit("cpu (" + std::to_string(host_num_threads()) + " threads)", qtabs));
+        if (opt.emu_cus) {
+            for (int i = 0; i < opt.emu_cus; i++) {
+                EmuUnit* u = new EmuUnit("emu:" + std::to_string(i), qtabs);
+                u->set_timing(opt.emu_overhead_ms, opt.emu_rate);
+                units.emplace_back(u);
+            }
+            AdaptiveDispatcher disp(std::move(units));
+            return run_adaptive_bench(disp, bench_planes, w, h, opt, qtabs);
+        }
+        vector<std::string> names = discover_cus(xclbin_file, "dct_accel");
+        if (names.empty()) {
+            cerr << "ERROR: no dct_accel compute units in " << xclbin_file << "\n";
+            return 1;
+        }
+        cout << "Opening device 0 (" << names.size() << " compute units)...\n";
+        xrt::device device(0);
+        auto uuid = device.load_xclbin(xclbin_file);
+        vector<uint32_t> qwords;
+        pack_quant_tables(qtabs, qwords);
+        for (auto& n : names)
+            units.emplace_back(new XrtUnit(device, uuid, n, opt.variant, qwords));
+        AdaptiveDispatcher disp(std::move(units));
+        return run_adaptive_bench(disp, bench_planes, w, h, opt, qtabs);
+    }
+
+    if (opt.emu_cus) {
+        vector<std::unique_ptr<DctUnit>> units;
+        for (int i = 0; i < opt.emu_cus; i++)
+            units.emplace_back(new EmuUnit("emu:" + std::to_string(i), qtabs));
+        CuScheduler sched(std::move(units));
+        return run_cu_bench(sched, "MULTI-CU BENCHMARK", bench_planes, w, h, opt, qtabs);
+    }
+
+    if (multi_dev) {
+        vector<std::unique_ptr<DctUnit>> units;
+        if (opt.emu_devices) {
+            for (int i = 0; i < opt.emu_devices; i++)
+                units.emplace_back(new EmuUnit("emu-dev" + std::to_string(i), qtabs,
+                                               i == 0 ? opt.emu_fail_after : -1));
+        } else {
+            // Cards that are missing or fail to load the xclbin are skipped
+            vector<uint32_t> qwords;
+            pack_quant_tables(qtabs, qwords);
+            vector<int> ids = opt.devices;
+            for (int i = 0; opt.all_devices && i < 16; i++) ids.push_back(i);
+            for (int id : ids) {
+                try {
+                    xrt::device device(id);
+                    auto uuid = device.load_xclbin(xclbin_file);
+                    units.emplace_back(new XrtUnit(device, uuid, "dct_accel", opt.variant, qwords,
+                                                   "dev" + std::to_string(id)));
+                    cout << "Opened device " << id << "\n";
+                } catch (const std::exception& e) {
+                    if (opt.all_devices) break;
+                    cerr << "WARNING: device " << id << " unavailable (" << e.what() << ")\n";
+                }
+            }
+        }
+        if (units.empty()) {
+            cerr << "ERROR: no device available\n";
+            return 1;
+        }
+        DeviceScheduler sched(std::move(units));
+        return run_cu_bench(sched, "MULTI-DEVICE BENCHMARK", bench_planes, w, h, opt, qtabs);
+    }
+
+    if (opt.cus >= 0) {
+        vector<std::string> names = discover_cus(xclbin_file, "dct_accel");
+        if (names.empty()) {
+            cerr << "ERROR: no dct_accel compute units in " << xclbin_file << "\n";
+            return 1;
+        }
+        if (opt.cus > 0 && opt.cus < (int)names.size()) names.resize(opt.cus);
+        cout << "Opening device 0 (" << names.size() << " compute units)...\n";
+        xrt::device device(0);
+        auto uuid = device.load_xclbin(xclbin_file);
+        vector<uint32_t> qwords;
+        pack_quant_tables(qtabs, qwords);
+        vector<std::unique_ptr<DctUnit>> units;
+        for (auto& n : names)
+            units.emplace_back(new XrtUnit(device, uuid, n, opt.variant, qwords));
+        CuScheduler sched(std::move(units));
+        return run_cu_bench(sched, "MULTI-CU BENCHMARK", bench_planes, w, h, opt, qtabs);
+    }
+
+    if (opt.batch || opt.atlas) {
+        cout << "Opening device 0...\n";
+        xrt::device device(0);
+        auto uuid = device.load_xclbin(xclbin_file);
+        xrt::kernel kernel(device, uuid, "dct_accel");
+        if (opt.atlas)
+            return run_atlas_bench(device, kernel, opt.variant, bench_planes, w, h,
+                                   opt.atlas, qtabs, opt.kernel_quant);
+        return run_batch_bench(device, kernel, bench_planes, w, h, opt.batch, qtabs, opt.kernel_quant);
+    }
+
+    if (opt.variant == 10) {
+        cout << "Opening device 0...\n";
+        xrt::device device(0);
+        auto uuid = device.load_xclbin(xclbin_file);
+        xrt::kernel kernel(device, uuid, "dct_accel");
+        return run_roundtrip_audit(device, kernel, bench_planes, nplanes, w, h, qtabs, opt, output_png);
+    }
+
+    PerfMetrics perf = {};
+
+    // ------------------ Planes to transform ------------------
+    // RGB: the planes as loaded. 4:2:0: Y at full size, Cb/Cr half size.
+    // Grayscale: plane 0 only.
+    PlaneDims dims[3] = { {w, h}, {w, h}, {w, h} };
+    if (gray) dims[1] = dims[2] = {0, 0};
+    const vector<pixel_t>* planes[3] = { &R, &G, &B };
+    vector<pixel_t> Y, Cb, Cr;
+
+    // What the kernel sees. v1-v4 transform three equal-size planes, so
+    // 4:2:0 goes in packed (see Ycc420Packing) and grayscale as three
+    // strips (see StripPacking); v5 takes RGB directly.
+    PlaneDims dev_in = {w, h};
+    PlaneDims dev_out[3] = { {w, h}, {w, h}, {w, h} };
+    const vector<pixel_t>* dev_planes[3] = { &R, &G, &B };
+    const QuantTable* dev_qtabs[3] = { &qtabs[0], &qtabs[1], &qtabs[2] };
+    Ycc420Packing pack = {};
+    StripPacking strips = {};
+    vector<pixel_t> packed[3];
+
+    if (gray && opt.variant == 5) {
+        // R = G = B = gray converts to Y = gray exactly; Cb/Cr are dropped
+        dev_out[1] = dev_out[2] = {ycc_chroma_dim(w), ycc_chroma_dim(h)};
+        dev_planes[1] = dev_planes[2] = &R;
+    } else if (gray) {
+        strips = strip_packing(w, h);
+        strip_pack(R, w, h, strips, packed);
+        dev_in = {strips.width, strips.height};
+        for (int c = 0; c < 3; c++) {
+            dev_out[c] = dev_in;
+            dev_planes[c] = &packed[c];
+            dev_qtabs[c] = &qtabs[0];
+        }
+    }
+
+    if (opt.ycc420) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        rgb_to_ycc420(R, G, B, w, h, Y, Cb, Cr);
+        int cw = ycc_chroma_dim(w), chh = ycc_chroma_dim(h);
+        dims[1] = dims[2] = {cw, chh};
+        planes[0] = &Y; planes[1] = &Cb; planes[2] = &Cr;
+
+        if (kernel_color) {
+            dev_out[1] = dev_out[2] = {cw, chh};
+        } else {
+            pack = ycc420_packing(w, h);
+            ycc420_pack(Y, Cb, Cr, w, h, pack, packed);
+            dev_in = {pack.width, pack.height};
+            for (int c = 0; c < 3; c++) {
+                dev_out[c] = dev_in;
+                dev_planes[c] = &packed[c];
+            }
+            // Packed plane 1 holds the lower half of Y, plane 2 Cb and Cr
+            dev_qtabs[1] = &qtabs[0];
+            dev_qtabs[2] = &qtabs[1];
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        // Only on the device path when the host feeds the kernel
+        if (kernel_color) perf.cpu_dct_time_ms += ms;
+        else perf.color_time_ms = ms;
+
+        cout << "Color path: YCbCr 4:2:0 (" << (kernel_color ? "on device" : "host converted")
+             << "), chroma " << cw << "x" << chh << "\n";
+    }
+
+    // v6 has no bounds checks: planes go up padded to whole blocks with a
+    // 64-element row pitch (see PitchedLayout), coefficients come back the same.
+    // v7 and v11 take block-major tiles (see tiles.hpp) in and out.
+    PitchedLayout pitched = {};
+    vector<pixel_t> layout_in[3];
+    if (opt.variant == 7 || opt.variant == 11) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int c = 0; c < 3; c++) {
+            raster_to_tiles(*dev_planes[c], dev_in.width, dev_in.height, layout_in[c]);
+            dev_planes[c] = &layout_in[c];
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        perf.layout_time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    } else if (opt.variant == 6) {
+        pitched = pitched_layout(dev_in.width, dev_in.height);
+        if (pitched.width > V6_MAX_WIDTH) {
+            cerr << "ERROR: v6 handles planes up to " << V6_MAX_WIDTH << " pixels wide\n";
+            return 1;
+        }
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int c = 0; c < 3; c++) {
+            pitch_pad(*dev_planes[c], dev_in.width, dev_in.height, pitched, layout_in[c]);
+            dev_planes[c] = &layout_in[c];
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        perf.layout_time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    }
+    size_t in_elems = dev_planes[0]->size();
+    size_t out_elems[3];
+    for (int c = 0; c < 3; c++)
+        out_elems[c] = opt.variant == 6 ? pitched.size()
+                     : opt.variant == 7 || opt.variant == 11 ? tiled_size(dev_out[c].width, dev_out[c].height)
+                     : dev_out[c].size();
+
     // ------------------ FPGA setup ------------------
     cout << "Opening device 0...\n";
     xrt::device device(0);
@@ -271,26 +2213,59 @@ int main(int argc, char** argv)
     cout << "Loading xclbin: " << xclbin_file << "\n";
     auto uuid = device.load_xclbin(xclbin_file);
 
-    cout << "Opening kernel 'dct_accel'...\n";
-    xrt::kernel kernel(device, uuid, "dct_accel");
+    // v11's dct_accel has no control interface; the host drives its data
+    // movers instead, which own the buffers (dct_mm2s arguments 0-2,
+    // dct_s2mm arguments 3-5)
+    xrt::kernel kernel, s2mm;
+    if (opt.variant == 11) {
+        cout << "Opening kernels 'dct_mm2s' and 'dct_s2mm'...\n";
+        kernel = xrt::kernel(device, uuid, "dct_mm2s");
+        s2mm = xrt::kernel(device, uuid, "dct_s2mm");
+    } else {
+        cout << "Opening kernel 'dct_accel'...\n";
+        kernel = xrt::kernel(device, uuid, "dct_accel");
+    }
+    xrt::kernel& out_kernel = opt.variant == 11 ? s2mm : kernel;
 
-    size_t coeff_bytes = size_t(w) * h * sizeof(coeff_t);
-    size_t pixel_bytes = size_t(w) * h * sizeof(pixel_t);
+    size_t pixel_bytes = in_elems * sizeof(pixel_t);
 
     auto bo_inR  = xrt::bo(device, pixel_bytes, xrt::bo::flags::normal, kernel.group_id(0));
     auto bo_inG  = xrt::bo(device, pixel_bytes, xrt::bo::flags::normal, kernel.group_id(1));
     auto bo_inB  = xrt::bo(device, pixel_bytes, xrt::bo::flags::normal, kernel.group_id(2));
-    auto bo_outR = xrt::bo(device, coeff_bytes, xrt::bo::flags::normal, kernel.group_id(3));
-    auto bo_outG = xrt::bo(device, coeff_bytes, xrt::bo::flags::normal, kernel.group_id(4));
-    auto bo_outB = xrt::bo(device, coeff_bytes, xrt::bo::flags::normal, kernel.group_id(5));
+    auto bo_outR = xrt::bo(device, out_elems[0] * sizeof(coeff_t), xrt::bo::flags::normal, out_kernel.group_id(3));
+    auto bo_outG = xrt::bo(device, out_elems[1] * sizeof(coeff_t), xrt::bo::flags::normal, out_kernel.group_id(4));
+    auto bo_outB = xrt::bo(device, out_elems[2] * sizeof(coeff_t), xrt::bo::flags::normal, out_kernel.group_id(5));
+
+    // v4-v9: quant tables for the on-kernel quantizer (uploaded even when
+    // quant_en = 0 since the argument is always present)
+    xrt::bo bo_qtab;
+    if (opt.variant >= 4 && opt.variant != 11) {
+        QuantTable tabs[3] = { *dev_qtabs[0], *dev_qtabs[1], *dev_qtabs[2] };
+        vector<uint32_t> qwords;
+        pack_quant_tables(tabs, qwords);
+        bo_qtab = xrt::bo(device, qwords.size() * sizeof(uint32_t),
+                          xrt::bo::flags::normal, kernel.group_id(6));
+        bo_qtab.write(qwords.data());
+        bo_qtab.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    }
+
+    // v9: the statistics stage's result buffer (see kernel_stats.hpp)
+    xrt::bo bo_stats;
+    if (opt.variant == 9)
+        bo_stats = xrt::bo(device, KSTATS_WORDS * sizeof(uint32_t),
+                           xrt::bo::flags::normal, kernel.group_id(10));
 
-    PerfMetrics perf;
+    // v12: the per-stage cycle counters (see kernel_perf.hpp)
+    xrt::bo bo_perf;
+    if (opt.variant == 12)
+        bo_perf = xrt::bo(device, KPERF_WORDS * sizeof(uint32_t),
+                          xrt::bo::flags::normal, kernel.group_id(10));
 
     // Time data transfer to FPGA
     auto t_start = std::chrono::high_resolution_clock::now();
-    bo_inR.write(R.data());
-    bo_inG.write(G.data());
-    bo_inB.write(B.data());
+    bo_inR.write(dev_planes[0]->data());
+    bo_inG.write(dev_planes[1]->data());
+    bo_inB.write(dev_planes[2]->data());
     bo_inR.sync(XCL_BO_SYNC_BO_TO_DEVICE);
     bo_inG.sync(XCL_BO_SYNC_BO_TO_DEVICE);
     bo_inB.sync(XCL_BO_SYNC_BO_TO_DEVICE);
@@ -301,9 +2276,47 @@ int main(int argc, char** argv)
 
     // Time kernel execution
     auto t_kernel_start = std::chrono::high_resolution_clock::now();
-    auto run = kernel(bo_inR, bo_inG, bo_inB,
-                      bo_outR, bo_outG, bo_outB,
-                      w, h);
+    xrt::run run;
+    if (opt.variant == 11) {
+        // The stream arguments are wired at link time, so only the memory
+        // and count arguments are set. s2mm goes first so it is waiting
+        // when the first coefficients come out.
+        int num_blocks = int(in_elems / 64);
+        run = xrt::run(s2mm);
+        run.set_arg(3, bo_outR);
+        run.set_arg(4, bo_outG);
+        run.set_arg(5, bo_outB);
+        run.set_arg(6, num_blocks);
+        run.start();
+        xrt::run mm2s_run(kernel);
+        mm2s_run.set_arg(0, bo_inR);
+        mm2s_run.set_arg(1, bo_inG);
+        mm2s_run.set_arg(2, bo_inB);
+        mm2s_run.set_arg(6, num_blocks);
+        mm2s_run.start();
+        mm2s_run.wait();
+    } else if (opt.variant == 7)
+        run = kernel(bo_inR, bo_inG, bo_inB,
+                     bo_outR, bo_outG, bo_outB,
+                     bo_qtab, int(in_elems / 64), opt.kernel_quant ? 1 : 0);
+    else if (opt.variant == 6)
+        run = kernel(bo_inR, bo_inG, bo_inB,
+                     bo_outR, bo_outG, bo_outB,
+                     bo_qtab, pitched.width, pitched.height, pitched.pitch,
+                     opt.kernel_quant ? 1 : 0);
+    else if (opt.variant == 9 || opt.variant == 12)
+        run = kernel(bo_inR, bo_inG, bo_inB,
+                     bo_outR, bo_outG, bo_outB,
+                     bo_qtab, dev_in.width, dev_in.height, opt.kernel_quant ? 1 : 0,
+                     opt.variant == 9 ? bo_stats : bo_perf);
+    else if (opt.variant >= 4)
+        run = kernel(bo_inR, bo_inG, bo_inB,
+                     bo_outR, bo_outG, bo_outB,
+                     bo_qtab, dev_in.width, dev_in.height, opt.kernel_quant ? 1 : 0);
+    else
+        run = kernel(bo_inR, bo_inG, bo_inB,
+                     bo_outR, bo_outG, bo_outB,
+                     dev_in.width, dev_in.height);
     run.wait();
     auto t_kernel_end = std::chrono::high_resolution_clock::now();
     perf.kernel_time_ms = std::chrono::duration<double, std::milli>(t_kernel_end - t_kernel_start).count();
@@ -312,26 +2325,116 @@ int main(int argc, char** argv)
 
     // Time data transfer from FPGA
     auto t_read_start = std::chrono::high_resolution_clock::now();
-    vector<coeff_t> Rcoef_fpga(w*h), Gcoef_fpga(w*h), Bcoef_fpga(w*h);
+    vector<coeff_t> dev_coef[3];
+    for (int c = 0; c < 3; c++) dev_coef[c].resize(out_elems[c]);
     bo_outR.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
     bo_outG.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
     bo_outB.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
-    bo_outR.read(Rcoef_fpga.data());
-    bo_outG.read(Gcoef_fpga.data());
-    bo_outB.read(Bcoef_fpga.data());
+    bo_outR.read(dev_coef[0].data());
+    bo_outG.read(dev_coef[1].data());
+    bo_outB.read(dev_coef[2].data());
+    KernelStats kstats[3];
+    if (opt.variant == 9) {
+        uint32_t words[KSTATS_WORDS];
+        bo_stats.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+        bo_stats.read(words);
+        unpack_kernel_stats(words, kstats);
+    }
+    StagePerf kperf[KPERF_STAGES];
+    if (opt.variant == 12) {
+        uint32_t words[KPERF_WORDS];
+        bo_perf.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+        bo_perf.read(words);
+        unpack_kernel_perf(words, kperf);
+    }
+    if (opt.variant == 6 || opt.variant == 7 || opt.variant == 11) {
+        for (int c = 0; c < 3; c++) {
+            vector<coeff_t> full;
+            full.swap(dev_coef[c]);
+            if (opt.variant == 6)
+                pitch_crop(full, dev_in.width, dev_in.height, pitched, dev_coef[c]);
+            else
+                tiles_to_raster(full, dev_out[c].width, dev_out[c].height, dev_coef[c]);
+        }
+    }
     auto t_read_end = std::chrono::high_resolution_clock::now();
     perf.readback_time_ms = std::chrono::duration<double, std::milli>(t_read_end - t_read_start).count();
 
     perf.total_fpga_time_ms = perf.load_time_ms + perf.kernel_time_ms + perf.readback_time_ms;
 
-    // ------------------ CPU golden DCT (for comparison) ------------------
-    auto t_cpu_start = std::chrono::high_resolution_clock::now();
-    vector<coeff_t> Rcoef_cpu, Gcoef_cpu, Bcoef_cpu;
-    cpu_dct_image(R, w, h, Rcoef_cpu);
-    cpu_dct_image(G, w, h, Gcoef_cpu);
-    cpu_dct_image(B, w, h, Bcoef_cpu);
-    auto t_cpu_end = std::chrono::high_resolution_clock::now();
-    perf.cpu_dct_time_ms = std::chrono::duration<double, std::milli>(t_cpu_end - t_cpu_start).count();
+    vector<coeff_t> coef_fpga[3];
+    if (opt.ycc420 && !kernel_color) {
+        ycc420_unpack(dev_coef, w, h, pack, coef_fpga[0], coef_fpga[1], coef_fpga[2]);
+    } else if (gray && opt.variant != 5) {
+        strip_unpack(dev_coef, w, h, strips, coef_fpga[0]);
+    } else if (gray) {
+        coef_fpga[0].swap(dev_coef[0]);
+    } else {
+        for (int c = 0; c < 3; c++) coef_fpga[c].swap(dev_coef[c]);
+    }
+
+    // ------------------ Verification against the CPU golden DCT ------------------
+    // Full: the whole image through the golden model, which also gives the
+    // CPU time for the speedup. Sampled: K seeded random blocks, with a
+    // confidence bound on the share of wrong blocks the sample could miss.
+    auto t_verify_start = std::chrono::high_resolution_clock::now();
+    size_t total_coeffs = 0;
+    for (int c = 0; c < nplanes; c++) total_coeffs += dims[c].size();
+    if (opt.verify.mode == VerifyPolicy::FULL) {
+        auto t_cpu_start = std::chrono::high_resolution_clock::now();
+        vector<coeff_t> coef_cpu[3];
+        for (int c = 0; c < nplanes; c++) {
+            if (opt.tiled)
+                cpu_dct_image_tiled(*planes[c], dims[c].width, dims[c].height, coef_cpu[c]);
+            else
+                cpu_dct_image(*planes[c], dims[c].width, dims[c].height, coef_cpu[c]);
+        }
+        auto t_cpu_end = std::chrono::high_resolution_clock::now();
+        perf.cpu_dct_time_ms += std::chrono::duration<double, std::milli>(t_cpu_end - t_cpu_start).count();
+
+        // On-kernel quantization: compare against the quantized golden
+        if (opt.kernel_quant)
+            for (int c = 0; c < nplanes; c++)
+                quantize_image(coef_cpu[c], dims[c].width, dims[c].height, qtabs[c]);
+
+        // Count, histogram, heatmaps and worst blocks in one pass
+        MismatchReport mm;
+        for (int c = 0; c < nplanes; c++)
+            analyze_mismatches(coef_fpga[c].data(), coef_cpu[c].data(), dims[c].width, dims[c].height,
+                               c, mm, opt.worst_blocks);
+        cout << "\nCoefficient mismatches: " << mm.mismatches << " / " << total_coeffs << "\n";
+        if (mm.mismatches || opt.mismatch_report) {
+            static const char* const rgb_names[3] = { "R", "G", "B" };
+            static const char* const ycc_names[3] = { "Y", "Cb", "Cr" };
+            static const char* const gray_names[1] = { "Gray" };
+            print_mismatch_report(mm, gray ? gray_names : (opt.ycc420 ? ycc_names : rgb_names));
+        }
+    } else if (opt.verify.mode == VerifyPolicy::SAMPLED) {
+        VerifyPlane vp[3];
+        size_t all_blocks = 0;
+        for (int c = 0; c < nplanes; c++) {
+            vp[c] = { planes[c]->data(), coef_fpga[c].data(), dims[c].width, dims[c].height,
+                      opt.kernel_quant ? &qtabs[c] : nullptr };
+            all_blocks += size_t(dims[c].blocks_x()) * dims[c].blocks_y();
+        }
+        size_t k = opt.verify.blocks ? opt.verify.blocks
+                 : std::max<size_t>(1, (size_t)std::ceil(all_blocks * opt.verify.percent / 100.0));
+        VerifyResult vr = verify_sampled(vp, nplanes, k, opt.verify.seed);
+        double bound = verify_upper_bound(vr.bad_blocks, vr.blocks_checked, vr.blocks_total);
+        auto flags = cout.flags();
+        cout << "\nSampled verification: " << vr.blocks_checked << " / " << vr.blocks_total
+             << " blocks (" << std::fixed << std::setprecision(2)
+             << 100.0 * vr.blocks_checked / vr.blocks_total << "%, seed " << opt.verify.seed << ")\n";
+        cout << "Coefficient mismatches: " << vr.bad_coeffs << " / " << vr.coeffs_checked
+             << " checked, in " << vr.bad_blocks << " blocks\n";
+        cout << "Wrong blocks in the image: < " << std::setprecision(4) << 100.0 * bound
+             << "% (95% confidence)\n";
+        cout.flags(flags);
+    } else {
+        cout << "\nVerification off: device output not checked\n";
+    }
+    auto t_verify_end = std::chrono::high_resolution_clock::now();
+    perf.verify_time_ms = std::chrono::duration<double, std::milli>(t_verify_end - t_verify_start).count();
 
     // Calculate performance metrics
     double mpixels = (w * h) / 1e6;
@@ -339,128 +2442,88 @@ int main(int argc, char** argv)
 
     perf.throughput_mpixels_per_sec = mpixels / (perf.kernel_time_ms / 1000.0);
     perf.throughput_blocks_per_sec = num_blocks / (perf.kernel_time_ms / 1000.0);
-    perf.speedup = perf.cpu_dct_time_ms / perf.kernel_time_ms;
-
-    // Compare raw coefficients
-    long diff_count = 0;
-    for (int i = 0; i < w*h; i++) {
-        if (Rcoef_fpga[i] != Rcoef_cpu[i]) diff_count++;
-        if (Gcoef_fpga[i] != Gcoef_cpu[i]) diff_count++;
-        if (Bcoef_fpga[i] != Bcoef_cpu[i]) diff_count++;
-    }
-    cout << "\nCoefficient mismatches: " << diff_count << " / " << (w*h*3) << "\n";
+    // The CPU reference time, and so the speedup, needs a full verification
+    perf.speedup = opt.verify.mode == VerifyPolicy::FULL ? perf.cpu_dct_time_ms / perf.kernel_time_ms : 0;
 
     // ------------------ Calculate compression metrics ------------------
-    CompressionMetrics comp = calculate_compression(Rcoef_fpga, Gcoef_fpga, Bcoef_fpga, w, h);
+    // The v9 counts hold for the planes as stored; packed 4:2:0 and
+    // grayscale strips are counted on the host after unpacking
+    const vector<coeff_t>* coeffs[3] = { &coef_fpga[0], &coef_fpga[1], &coef_fpga[2] };
+    const bool direct_planes = !gray && !opt.ycc420;
+    CompressionMetrics comp = calculate_compression(coeffs, dims, opt, qtabs,
+                                                    opt.variant == 9 && direct_planes ? kstats : nullptr);
 
     // ------------------ JPEG-style pipeline per block ------------------
-    vector<pixel_t> R_recon(w*h), G_recon(w*h), B_recon(w*h);
-    pixel_t blk_recon[8][8];
-
-    for (int by = 0; by < h; by += 8) {
-        for (int bx = 0; bx < w; bx += 8) {
-            // R channel
-            coeff_t blkR_fpga[8][8];
-            for (int y = 0; y < 8; y++) {
-                for (int x = 0; x < 8; x++) {
-                    int gx = bx + x;
-                    int gy = by + y;
-                    if (gx < w && gy < h) {
-                        int idx = gy * w + gx;
-                        blkR_fpga[y][x] = Rcoef_fpga[idx];
-                    } else {
-                        blkR_fpga[y][x] = 0;
-                    }
-                }
-            }
-            jpeg_block_pipeline(blkR_fpga, blk_recon);
-            for (int y = 0; y < 8; y++) {
-                for (int x = 0; x < 8; x++) {
-                    int gx = bx + x;
-                    int gy = by + y;
-                    if (gx < w && gy < h) {
-                        int idx = gy * w + gx;
-                        R_recon[idx] = blk_recon[y][x];
-                    }
-                }
-            }
-
-            // G channel
-            coeff_t blkG_fpga[8][8];
-            for (int y = 0; y < 8; y++) {
-                for (int x = 0; x < 8; x++) {
-                    int gx = bx + x;
-                    int gy = by + y;
-                    if (gx < w && gy < h) {
-                        int idx = gy * w + gx;
-                        blkG_fpga[y][x] = Gcoef_fpga[idx];
-                    } else {
-                        blkG_fpga[y][x] = 0;
-                    }
-                }
-            }
-            jpeg_block_pipeline(blkG_fpga, blk_recon);
-            for (int y = 0; y < 8; y++) {
-                for (int x = 0; x < 8; x++) {
-                    int gx = bx + x;
-                    int gy = by + y;
-                    if (gx < w && gy < h) {
-                        int idx = gy * w + gx;
-                        G_recon[idx] = blk_recon[y][x];
-                    }
-                }
-            }
-
-            // B channel
-            coeff_t blkB_fpga[8][8];
-            for (int y = 0; y < 8; y++) {
-                for (int x = 0; x < 8; x++) {
-                    int gx = bx + x;
-                    int gy = by + y;
-                    if (gx < w && gy < h) {
-                        int idx = gy * w + gx;
-                        blkB_fpga[y][x] = Bcoef_fpga[idx];
-                    } else {
-                        blkB_fpga[y][x] = 0;
-                    }
-                }
-            }
-            jpeg_block_pipeline(blkB_fpga, blk_recon);
-            for (int y = 0; y < 8; y++) {
-                for (int x = 0; x < 8; x++) {
-                    int gx = bx + x;
-                    int gy = by + y;
-                    if (gx < w && gy < h) {
-                        int idx = gy * w + gx;
-                        B_recon[idx] = blk_recon[y][x];
-                    }
+    // --device-idct: the decode half on idct_accel; full verification
+    // compares its pixels with the host's
+    vector<pixel_t> recon[3];
+    if (opt.device_idct) {
+        cout << "Opening kernel 'idct_accel'...\n";
+        xrt::kernel idct(device, uuid, "idct_accel");
+        perf.idct_time_ms = device_reconstruct(device, idct, coeffs, dims, nplanes, qtabs,
+                                               opt.kernel_quant, recon);
+        if (opt.verify.mode == VerifyPolicy::FULL) {
+            long diff = 0, total = 0;
+            int max_diff = 0;
+            vector<pixel_t> host_recon;
+            for (int c = 0; c < nplanes; c++) {
+                reconstruct_plane(coef_fpga[c], dims[c], qtabs[c], opt.kernel_quant, host_recon);
+                for (size_t i = 0; i < host_recon.size(); i++) {
+                    int d = std::abs(int(recon[c][i]) - int(host_recon[i]));
+                    diff += d != 0;
+                    max_diff = std::max(max_diff, d);
                 }
+                total += host_recon.size();
             }
+            cout << "Device IDCT vs host: " << diff << " / " << total
+                 << " pixels differ (max " << max_diff << ")\n";
         }
+    } else {
+        for (int c = 0; c < nplanes; c++)
+            reconstruct_plane(coef_fpga[c], dims[c], qtabs[c], opt.kernel_quant, recon[c]);
     }
 
-    // ------------------ PSNR ------------------
-    double psnr_R = compute_psnr_channel(R, R_recon);
-    double psnr_G = compute_psnr_channel(G, G_recon);
-    double psnr_B = compute_psnr_channel(B, B_recon);
-    double psnr_avg = (psnr_R + psnr_G + psnr_B) / 3.0;
+    vector<pixel_t> R_recon, G_recon, B_recon;
+    if (opt.ycc420) {
+        ycc420_to_rgb(recon[0], recon[1], recon[2], w, h, R_recon, G_recon, B_recon);
+    } else {
+        R_recon.swap(recon[0]);
+        G_recon.swap(recon[1]);
+        B_recon.swap(recon[2]);
+    }
 
+    // ------------------ PSNR ------------------
+    double psnr_avg;
     cout << "\n=== PSNR after JPEG-style pipeline ===\n";
-    cout << "R: " << std::fixed << std::setprecision(2) << psnr_R << " dB\n";
-    cout << "G: " << psnr_G << " dB\n";
-    cout << "B: " << psnr_B << " dB\n";
-    cout << "Avg: " << psnr_avg << " dB\n";
+    if (gray) {
+        psnr_avg = compute_psnr_channel(R, R_recon);
+        cout << "Gray: " << std::fixed << std::setprecision(2) << psnr_avg << " dB\n";
+    } else {
+        double psnr_R = compute_psnr_channel(R, R_recon);
+        double psnr_G = compute_psnr_channel(G, G_recon);
+        double psnr_B = compute_psnr_channel(B, B_recon);
+        psnr_avg = (psnr_R + psnr_G + psnr_B) / 3.0;
+
+        cout << "R: " << std::fixed << std::setprecision(2) << psnr_R << " dB\n";
+        cout << "G: " << psnr_G << " dB\n";
+        cout << "B: " << psnr_B << " dB\n";
+        cout << "Avg: " << psnr_avg << " dB\n";
+    }
 
     // ------------------ Write reconstructed image ------------------
-    vector<unsigned char> out_img(w*h*3);
-    for (int i = 0; i < w*h; i++) {
-        out_img[3*i + 0] = R_recon[i];
-        out_img[3*i + 1] = G_recon[i];
-        out_img[3*i + 2] = B_recon[i];
+    vector<unsigned char> out_img(size_t(w) * h * nplanes);
+    if (gray) {
+        std::copy(R_recon.begin(), R_recon.end(), out_img.begin());
+    } else {
+        for (int i = 0; i < w*h; i++) {
+            out_img[3*i + 0] = R_recon[i];
+            out_img[3*i + 1] = G_recon[i];
+            out_img[3*i + 2] = B_recon[i];
+        }
     }
 
-    if (!stbi_write_png(output_png.c_str(), w, h, 3,
-                        out_img.data(), w*3)) {
+    if (!stbi_write_png(output_png.c_str(), w, h, nplanes,
+                        out_img.data(), w * nplanes)) {
         cerr << "ERROR: Failed to write output PNG\n";
         return 1;
     }
@@ -468,8 +2531,22 @@ int main(int argc, char** argv)
 
     // ------------------ Print reports ------------------
     print_performance_report(perf, w, h);
+    if (opt.variant == 12) print_stage_report(kperf, opt.kernel_mhz, perf.kernel_time_ms);
     print_compression_report(comp);
 
+    if (!opt.sweep.empty()) {
+        static const char* const rgb_names[3] = { "R", "G", "B" };
+        static const char* const ycc_names[3] = { "Y", "Cb", "Cr" };
+        static const char* const gray_names[1] = { "Gray" };
+        auto t_sweep_start = std::chrono::high_resolution_clock::now();
+        vector<SweepPoint> points = quality_sweep(coeffs, planes, dims, opt.sweep,
+                                                  opt.chroma_tables);
+        auto t_sweep_end = std::chrono::high_resolution_clock::now();
+        print_sweep_report(points,
+            std::chrono::duration<double, std::milli>(t_sweep_end - t_sweep_start).count(),
+            gray ? gray_names : (opt.ycc420 ? ycc_names : rgb_names), nplanes);
+    }
+
     // Summary CSV line for easy comparison
     cout << "\n=== CSV Summary ===\n";
     cout << "Config,Width,Height,LoadMS,KernelMS,ReadMS,TotalMS,CPUMS,Speedup,MP/s,Blocks/s,";
@@ -0,0 +1,305 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include "jpeg_cpu.hpp"
+
+// JPEG-style Huffman entropy coding of quantized zigzag blocks.
+// DC coefficients are coded as (category, extra bits) of the difference
+// to the previous block's DC; AC coefficients as (run<<4 | size) symbols
+// with ZRL (0xF0) for runs of 16 zeros and EOB (0x00) for the tail.
+
+struct HuffTable {
+    uint8_t bits[17];          // bits[k] = number of codes of length k (1..16)
+    std::vector<uint8_t> vals; // symbols in order of increasing code length
+    uint16_t code[256];
+    uint8_t  size[256];        // 0 = symbol has no code
+};
+
+// Per-channel-group symbol histogram (index = DC category / AC run-size symbol)
+struct HuffHistogram {
+    uint32_t dc[256];
+    uint32_t ac[256];
+};
+
+inline void huff_hist_clear(HuffHistogram &h) {
+    std::memset(&h, 0, sizeof(h));
+}
+
+inline void huff_hist_merge(HuffHistogram &dst, const HuffHistogram &src) {
+    for (int i = 0; i < 256; i++) {
+        dst.dc[i] += src.dc[i];
+        dst.ac[i] += src.ac[i];
+    }
+}
+
+// Canonical code assignment from bits/vals (ITU T.81 Annex C)
+inline void huff_build_codes(HuffTable &t) {
+    std::memset(t.code, 0, sizeof(t.code));
+    std::memset(t.size, 0, sizeof(t.size));
+    int k = 0;
+    uint16_t c = 0;
+    for (int len = 1; len <= 16; len++) {
+        for (int i = 0; i < t.bits[len]; i++) {
+            uint8_t sym = t.vals[k++];
+            t.code[sym] = c++;
+            t.size[sym] = (uint8_t)len;
+        }
+        c <<= 1;
+    }
+}
+
+inline HuffTable huff_make_table(const uint8_t bits16[16], const uint8_t *vals, int nvals) {
+    HuffTable t;
+    t.bits[0] = 0;
+    for (int i = 0; i < 16; i++) t.bits[i + 1] = bits16[i];
+    t.vals.assign(vals, vals + nvals);
+    huff_build_codes(t);
+    return t;
+}
+
+// Standard tables from ITU T.81 Annex K.3
+inline HuffTable huff_std_dc_luma() {
+    static const uint8_t bits[16] = {0,1,5,1,1,1,1,1,1,0,0,0,0,0,0,0};
+    static const uint8_t vals[12] = {0,1,2,3,4,5,6,7,8,9,10,11};
+    return huff_make_table(bits, vals, 12);
+}
+
+inline HuffTable huff_std_dc_chroma() {
+    static const uint8_t bits[16] = {0,3,1,1,1,1,1,1,1,1,1,0,0,0,0,0};
+    static const uint8_t vals[12] = {0,1,2,3,4,5,6,7,8,9,10,11};
+    return huff_make_table(bits, vals, 12);
+}
+
+inline HuffTable huff_std_ac_luma() {
+    static const uint8_t bits[16] = {0,2,1,3,3,2,4,3,5,5,4,4,0,0,1,0x7d};
+    static const uint8_t vals[162] = {
+        0x01,0x02,0x03,0x00,0x04,0x11,0x05,0x12,0x21,0x31,0x41,0x06,0x13,0x51,0x61,0x07,
+        0x22,0x71,0x14,0x32,0x81,0x91,0xa1,0x08,0x23,0x42,0xb1,0xc1,0x15,0x52,0xd1,0xf0,
+        0x24,0x33,0x62,0x72,0x82,0x09,0x0a,0x16,0x17,0x18,0x19,0x1a,0x25,0x26,0x27,0x28,
+        0x29,0x2a,0x34,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,0x49,
+        0x4a,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5a,0x63,0x64,0x65,0x66,0x67,0x68,0x69,
+        0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x83,0x84,0x85,0x86,0x87,0x88,0x89,
+        0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,0xa6,0xa7,
+        0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,0xb5,0xb6,0xb7,0xb8,0xb9,0xba,0xc2,0xc3,0xc4,0xc5,
+        0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,0xe1,0xe2,
+        0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf1,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,
+        0xf9,0xfa
+    };
+    return huff_make_table(bits, vals, 162);
+}
+
+inline HuffTable huff_std_ac_chroma() {
+    static const uint8_t bits[16] = {0,2,1,2,4,4,3,4,7,5,4,4,0,1,2,0x77};
+    static const uint8_t vals[162] = {
+        0x00,0x01,0x02,0x03,0x11,0x04,0x05,0x21,0x31,0x06,0x12,0x41,0x51,0x07,0x61,0x71,
+        0x13,0x22,0x32,0x81,0x08,0x14,0x42,0x91,0xa1,0xb1,0xc1,0x09,0x23,0x33,0x52,0xf0,
+        0x15,0x62,0x72,0xd1,0x0a,0x16,0x24,0x34,0xe1,0x25,0xf1,0x17,0x18,0x19,0x1a,0x26,
+        0x27,0x28,0x29,0x2a,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,
+        0x49,0x4a,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5a,0x63,0x64,0x65,0x66,0x67,0x68,
+        0x69,0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x82,0x83,0x84,0x85,0x86,0x87,
+        0x88,0x89,0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,
+        0xa6,0xa7,0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,0xb5,0xb6,0xb7,0xb8,0xb9,0xba,0xc2,0xc3,
+        0xc4,0xc5,0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,
+        0xe2,0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,
+        0xf9,0xfa
+    };
+    return huff_make_table(bits, vals, 162);
+}
+
+// Optimal length-limited (16 bit) table from a symbol histogram
+// (ITU T.81 Annex K.2, same procedure as libjpeg's jpeg_gen_optimal_table)
+inline HuffTable huff_optimal_table(const uint32_t freq_in[256]) {
+    const int MAX_CLEN = 32;
+    long freq[257];
+    int codesize[257];
+    int others[257];
+    int bits[MAX_CLEN + 1];
+
+    for (int i = 0; i < 256; i++) freq[i] = freq_in[i];
+    freq[256] = 1;  // reserved pseudo-symbol: no real code is all ones
+    for (int i = 0; i < 257; i++) { codesize[i] = 0; others[i] = -1; }
+    for (int i = 0; i <= MAX_CLEN; i++) bits[i] = 0;
+
+    for (;;) {
+        // c1 = smallest nonzero frequency, c2 = next smallest
+        int c1 = -1, c2 = -1;
+        long v = 1000000000L;
+        for (int i = 0; i <= 256; i++)
+            if (freq[i] && freq[i] <= v) { v = freq[i]; c1 = i; }
+        v = 1000000000L;
+        for (int i = 0; i <= 256; i++)
+            if (freq[i] && freq[i] <= v && i != c1) { v = freq[i]; c2 = i; }
+        if (c2 < 0) break;
+
+        freq[c1] += freq[c2];
+        freq[c2] = 0;
+
+        codesize[c1]++;
+        while (others[c1] >= 0) { c1 = others[c1]; codesize[c1]++; }
+        others[c1] = c2;
+        codesize[c2]++;
+        while (others[c2] >= 0) { c2 = others[c2]; codesize[c2]++; }
+    }
+
+    for (int i = 0; i <= 256; i++)
+        if (codesize[i]) bits[codesize[i]]++;
+
+    // Limit code lengths to 16 bits
+    for (int i = MAX_CLEN; i > 16; i--) {
+        while (bits[i] > 0) {
+            int j = i - 2;
+            while (bits[j] == 0) j--;
+            bits[i] -= 2;
+            bits[i - 1]++;
+            bits[j + 1] += 2;
+            bits[j]--;
+        }
+    }
+
+    // Drop the reserved pseudo-symbol (always one of the longest codes).
+    // An all-zero histogram never gives it a code, and the table is empty.
+    int i = 16;
+    while (i > 0 && bits[i] == 0) i--;
+    if (i > 0) bits[i]--;
+
+    HuffTable t;
+    t.bits[0] = 0;
+    for (int k = 1; k <= 16; k++) t.bits[k] = (uint8_t)bits[k];
+    t.vals.clear();
+    for (int len = 1; len <= MAX_CLEN; len++)
+        for (int s = 0; s < 256; s++)
+            if (codesize[s] == len) t.vals.push_back((uint8_t)s);
+    huff_build_codes(t);
+    return t;
+}
+
+// Bytes a DHT segment needs to carry this table (class/id byte + counts + symbols)
+inline size_t huff_table_bytes(const HuffTable &t) {
+    return 1 + 16 + t.vals.size();
+}
+
+// Exact scan size in bits for a histogram coded with the given tables
+// (Huffman codes plus the value bits; no byte stuffing or padding)
+inline uint64_t huff_estimate_bits(const HuffHistogram &h,
+                                   const HuffTable &dc, const HuffTable &ac) {
+    uint64_t bits = 0;
+    for (int s = 0; s < 256; s++) {
+        bits += (uint64_t)h.dc[s] * (dc.size[s] + s);
+        bits += (uint64_t)h.ac[s] * (ac.size[s] + (s & 15));
+    }
+    return bits;
+}
+
+// Magnitude category (bit length of |v|) of all 64 coefficients.
+// Branchless so the 64-lane loop vectorizes.
+inline void huff_categories(const coeff_t zz[64], uint8_t cat[64]) {
+    for (int i = 0; i < 64; i++) {
+        int v = zz[i];
+        int a = v < 0 ? -v : v;
+        int c = 0;
+        for (int b = 0; b < 16; b++)
+            c += (a >> b) != 0;
+        cat[i] = (uint8_t)c;
+    }
+}
+
+inline int huff_category(int v) {
+    int a = v < 0 ? -v : v;
+    int c = 0;
+    while (a) { c++; a >>= 1; }
+    return c;
+}
+
+// Bitmask of nonzero AC positions (bit k set if zz[k] != 0, k = 1..63)
+inline uint64_t huff_ac_mask(const uint8_t cat[64]) {
+    uint64_t m = 0;
+    for (int k = 1; k < 64; k++)
+        m |= (uint64_t)(cat[k] != 0) << k;
+    return m;
+}
+
+// Accumulate the AC run/size symbols of one block
+inline void huff_hist_ac(const coeff_t zz[64], HuffHistogram &h) {
+    uint8_t cat[64];
+    huff_categories(zz, cat);
+    uint64_t m = huff_ac_mask(cat);
+    int last = 0;
+    while (m) {
+        int k = __builtin_ctzll(m);
+        m &= m - 1;
+        int run = k - last - 1;
+        while (run > 15) { h.ac[0xF0]++; run -= 16; }
+        h.ac[(run << 4) | cat[k]]++;
+        last = k;
+    }
+    if (last != 63) h.ac[0x00]++;
+}
+
+// Bit writer for the entropy-coded segment (with 0xFF byte stuffing)
+struct BitWriter {
+    std::vector<uint8_t> bytes;
+    uint64_t acc = 0;
+    int nbits = 0;
+
+    void put(uint32_t code, int len) {
+        acc = (acc << len) | (code & ((1u << len) - 1));
+        nbits += len;
+        while (nbits >= 8) {
+            uint8_t b = (uint8_t)(acc >> (nbits - 8));
+            bytes.push_back(b);
+            if (b == 0xFF) bytes.push_back(0x00);
+            nbits -= 8;
+        }
+    }
+
+    // Pad the final partial byte with 1 bits
+    void flush() {
+        if (nbits > 0) put(0x7F, 8 - nbits);
+    }
+};
+
+// True if t has a code for every symbol counted in freq. The Annex K
+// tables stop at DC category 11 and AC size 10 (8-bit baseline), so an AC
+// coefficient of 1024 or more, possible at quality 100, has no code there;
+// huff_optimal_table codes every symbol it is given.
+inline bool huff_table_covers(const HuffTable &t, const uint32_t freq[256]) {
+    for (int s = 0; s < 256; s++)
+        if (freq[s] && !t.size[s]) return false;
+    return true;
+}
+
+// Emit one block's DC difference and AC symbols. Returns false if a symbol
+// has no code in dc/ac: the scan is then not decodable and has to be coded
+// with tables that cover it.
+inline bool huff_encode_block(const coeff_t zz[64], int &prev_dc,
+                              const HuffTable &dc, const HuffTable &ac,
+                              BitWriter &bw)
+{
+    int diff = zz[0] - prev_dc;
+    prev_dc = zz[0];
+    int s = huff_category(diff);
+    bool coded = dc.size[s] != 0;
+    bw.put(dc.code[s], dc.size[s]);
+    if (s) bw.put(diff < 0 ? diff - 1 : diff, s);
+
+    uint8_t cat[64];
+    huff_categories(zz, cat);
+    uint64_t m = huff_ac_mask(cat);
+    int last = 0;
+    while (m) {
+        int k = __builtin_ctzll(m);
+        m &= m - 1;
+        int run = k - last - 1;
+        while (run > 15) { bw.put(ac.code[0xF0], ac.size[0xF0]); run -= 16; }
+        int sym = (run << 4) | cat[k];
+        coded &= ac.size[sym] != 0;
+        bw.put(ac.code[sym], ac.size[sym]);
+        int v = zz[k];
+        bw.put(v < 0 ? v - 1 : v, cat[k]);
+        last = k;
+    }
+    if (last != 63) bw.put(ac.code[0x00], ac.size[0x00]);
+    return coded;
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "jpeg_cpu.hpp"
+#include "huffman.hpp"
+
+// Baseline JFIF writer (ITU T.81 sequential DCT, Huffman, 8-bit) for the
+// coefficient planes cpu_dct_image / dct_accel produce: one or three
+// components, 1x1 sampling, one interleaved scan, Annex K.3 tables.
+//
+// Those planes hold each block transposed against T.81 (row = horizontal
+// frequency, see dct_block_cpu), so blocks are read column-wise into
+// zigzag order and the quant tables are built transposed (jfif_quant_table)
+// so that DQT carries the standard matrices.
+
+// T.81 zigzag index -> natural (row-major, row = vertical frequency) index
+static const int jpeg_natural_order[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// Quant table for quant_block on transposed blocks that divides every
+// coefficient by the standard entry for its frequency
+inline void jfif_quant_table(QuantTable &t, const int base[64], int quality)
+{
+    int tb[64];
+    for (int r = 0; r < 8; r++)
+        for (int c = 0; c < 8; c++)
+            tb[c * 8 + r] = base[r * 8 + c];
+    quant_table_init(t, tb, quality);
+}
+
+namespace jfif_detail {
+
+inline void put16(std::vector<uint8_t> &o, int v)
+{
+    o.push_back(uint8_t(v >> 8));
+    o.push_back(uint8_t(v));
+}
+
+inline void marker(std::vector<uint8_t> &o, uint8_t m, int len)
+{
+    o.push_back(0xFF);
+    o.push_back(m);
+    put16(o, len);
+}
+
+inline void dht(std::vector<uint8_t> &o, int cls_id, const HuffTable &t)
+{
+    marker(o, 0xC4, 2 + 1 + 16 + (int)t.vals.size());
+    o.push_back(uint8_t(cls_id));
+    for (int k = 1; k <= 16; k++) o.push_back(t.bits[k]);
+    o.insert(o.end(), t.vals.begin(), t.vals.end());
+}
+
+} // namespace jfif_detail
+
+// planes[c]: quantized coefficients (quant_block with the jfif_quant_table
+// tables qt[c]) of a plane padded to pw x ph, both multiples of 8; the
+// image itself is w x h. Component 0 uses the luma Huffman tables, 1-2
+// the chroma ones. Throws std::runtime_error on a coefficient the Annex K
+// tables cannot code (an AC size above 10, outside 8-bit baseline).
+inline void jfif_encode(const coeff_t *const planes[], const QuantTable *const qt[],
+                        int ncomp, int w, int h, int pw, int ph,
+                        std::vector<uint8_t> &out)
+{
+    using namespace jfif_detail;
+    HuffTable dc[2] = { huff_std_dc_luma(), huff_std_dc_chroma() };
+    HuffTable ac[2] = { huff_std_ac_luma(), huff_std_ac_chroma() };
+    int ntab = ncomp > 1 ? 2 : 1;
+
+    out.clear();
+    out.push_back(0xFF);
+    out.push_back(0xD8);                                    // SOI
+
+    static const uint8_t app0[14] = { 'J', 'F', 'I', 'F', 0, 1, 2, 0, 0, 1, 0, 1, 0, 0 };
+    marker(out, 0xE0, 2 + 14);
+    out.insert(out.end(), app0, app0 + 14);
+
+    for (int c = 0; c < ncomp; c++) {                       // DQT per component
+        marker(out, 0xDB, 2 + 1 + 64);
+        out.push_back(uint8_t(c));
+        for (int k = 0; k < 64; k++) {
+            int n = jpeg_natural_order[k];
+            out.push_back(uint8_t(qt[c]->q[(n % 8) * 8 + n / 8]));
+        }
+    }
+
+    marker(out, 0xC0, 2 + 6 + 3 * ncomp);                   // SOF0
+    out.push_back(8);
+    put16(out, h);
+    put16(out, w);
+    out.push_back(uint8_t(ncomp));
+    for (int c = 0; c < ncomp; c++) {
+        out.push_back(uint8_t(c + 1));
+        out.push_back(0x11);
+        out.push_back(uint8_t(c));
+    }
+
+    for (int t = 0; t < ntab; t++) {
+        dht(out, 0x00 | t, dc[t]);
+        dht(out, 0x10 | t, ac[t]);
+    }
+
+    marker(out, 0xDA, 2 + 1 + 2 * ncomp + 3);               // SOS
+    out.push_back(uint8_t(ncomp));
+    for (int c = 0; c < ncomp; c++) {
+        out.push_back(uint8_t(c + 1));
+        out.push_back(uint8_t(c ? 0x11 : 0x00));
+    }
+    out.push_back(0);
+    out.push_back(63);
+    out.push_back(0);
+
+    BitWriter bw;
+    bw.bytes.reserve(size_t(pw) * ph * ncomp / 4);
+    int prev_dc[3] = { 0, 0, 0 };
+    coeff_t zz[64];
+    for (int by = 0; by < ph; by += 8) {
+        for (int bx = 0; bx < pw; bx += 8) {
+            for (int c = 0; c < ncomp; c++) {
+                const coeff_t *blk = planes[c] + size_t(by) * pw + bx;
+                for (int k = 0; k < 64; k++) {
+                    int n = jpeg_natural_order[k];     // row n/8 = vertical frequency
+                    zz[k] = blk[size_t(n % 8) * pw + n / 8];
+                }
+                int t = c ? 1 : 0;
+                if (!huff_encode_block(zz, prev_dc[c], dc[t], ac[t], bw))
+                    throw std::runtime_error("jfif_encode: coefficient outside the baseline Huffman tables");
+            }
+        }
+    }
+    bw.flush();
+    out.insert(out.end(), bw.bytes.begin(), bw.bytes.end());
+
+    out.push_back(0xFF);
+    out.push_back(0xD9);                                    // EOI
+}
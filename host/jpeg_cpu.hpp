@@ -33,6 +33,107 @@ static const int Q_luma[64] = {
      72, 92, 95, 98,112,100,103, 99
 };
 
+// Standard JPEG chrominance quant matrix
+static const int Q_chroma[64] = {
+     17, 18, 24, 47, 99, 99, 99, 99,
+     18, 21, 26, 66, 99, 99, 99, 99,
+     24, 26, 56, 99, 99, 99, 99, 99,
+     47, 66, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99
+};
+
+// Quantization table scaled to a quality setting, with a fixed-point
+// reciprocal per entry so quantizing is a multiply and a shift:
+//   |q| = ((|v| + corr) * recip) >> shift
+// This is libjpeg-turbo's compute_reciprocal scheme; it matches
+// round(v / q) exactly for every 16-bit v and divisor 1..255.
+struct QuantTable {
+    uint16_t q[64];
+    uint16_t recip[64];
+    uint16_t corr[64];
+    uint16_t shift[64];
+};
+
+// libjpeg quality scaling (1..100, 50 = base table unchanged)
+inline int quality_scale(int quality) {
+    if (quality < 1)   quality = 1;
+    if (quality > 100) quality = 100;
+    return quality < 50 ? 5000 / quality : 200 - quality * 2;
+}
+
+inline void quant_table_init(QuantTable &t, const int base[64], int quality) {
+    int scale = quality_scale(quality);
+    for (int i = 0; i < 64; i++) {
+        int d = (base[i] * scale + 50) / 100;
+        if (d < 1)   d = 1;
+        if (d > 255) d = 255;
+        t.q[i] = (uint16_t)d;
+
+        if (d == 1) {
+            t.recip[i] = 1;
+            t.corr[i]  = 0;
+            t.shift[i] = 0;
+            continue;
+        }
+        int b = 0;
+        while ((2 << b) <= d) b++;
+        int r = 16 + b;
+        uint32_t fq = (1u << r) / d;
+        uint32_t fr = (1u << r) % d;
+        uint32_t c  = d / 2;
+        if (fr == 0) {              // power of two: fq would need 17 bits
+            fq >>= 1;
+            r--;
+        } else if (fr <= uint32_t(d / 2)) {
+            c++;
+        } else {
+            fq++;
+        }
+        t.recip[i] = (uint16_t)fq;
+        t.corr[i]  = (uint16_t)c;
+        t.shift[i] = (uint16_t)r;
+    }
+}
+
+// Q_luma at quality 50, the table quant_block uses when none is given
+inline const QuantTable &default_quant_table() {
+    static const QuantTable t = [] {
+        QuantTable q;
+        quant_table_init(q, Q_luma, 50);
+        return q;
+    }();
+    return t;
+}
+
+// Pack quant tables for the v4+ on-kernel quantizer:
+// recip[15:0] corr[23:16] shift[28:24], 64 entries per channel
+inline void pack_quant_tables(const QuantTable qtabs[3], std::vector<uint32_t> &words) {
+    words.resize(3 * 64);
+    for (int ch = 0; ch < 3; ch++)
+        for (int i = 0; i < 64; i++)
+            words[ch * 64 + i] = uint32_t(qtabs[ch].recip[i]) |
+                                 (uint32_t(qtabs[ch].corr[i]) << 16) |
+                                 (uint32_t(qtabs[ch].shift[i]) << 24);
+}
+
+// idct_accel dequantizes with each table's steps, 64 words per channel
+inline void pack_dequant_tables(const QuantTable qtabs[3], std::vector<uint32_t> &words) {
+    words.resize(3 * 64);
+    for (int ch = 0; ch < 3; ch++)
+        for (int i = 0; i < 64; i++) words[ch * 64 + i] = qtabs[ch].q[i];
+}
+
+// v10 also dequantizes: the packed quant tables, then each table's steps
+inline void pack_roundtrip_tables(const QuantTable qtabs[3], std::vector<uint32_t> &words) {
+    std::vector<uint32_t> steps;
+    pack_quant_tables(qtabs, words);
+    pack_dequant_tables(qtabs, steps);
+    words.insert(words.end(), steps.begin(), steps.end());
+}
+
 // Zigzag order for 8x8
 static const int zigzag[64] = {
      0,  1,  5,  6, 14, 15, 27, 28,
@@ -109,26 +210,29 @@ inline void idct_block_cpu(const coeff_t in[8][8], pixel_t out[8][8]) {
     }
 }
 
+// Quantize 8x8 block with integer multiply-shift (flat, branchless loop
+// so the compiler can vectorize it)
+inline void quant_block(const coeff_t in[8][8], coeff_t out[8][8], const QuantTable &t) {
+    const coeff_t *src = &in[0][0];
+    coeff_t *dst = &out[0][0];
+    for (int i = 0; i < 64; i++) {
+        int v = src[i];
+        uint32_t a = (uint32_t)(v < 0 ? -v : v);
+        int qv = (int)(((a + t.corr[i]) * t.recip[i]) >> t.shift[i]);
+        dst[i] = (coeff_t)(v < 0 ? -qv : qv);
+    }
+}
+
 // Quantize 8x8 block using Q_luma
 inline void quant_block(const coeff_t in[8][8], coeff_t out[8][8]) {
-    for (int y = 0; y < 8; y++) {
-        for (int x = 0; x < 8; x++) {
-            int idx = y*8 + x;
-            int q = Q_luma[idx];
-            int v = in[y][x];
-            int qv = (int)std::round((double)v / (double)q);
-            if (qv < -32768) qv = -32768;
-            if (qv >  32767) qv =  32767;
-            out[y][x] = (coeff_t)qv;
-        }
-    }
+    quant_block(in, out, default_quant_table());
 }
 
-inline void dequant_block(const coeff_t in[8][8], coeff_t out[8][8]) {
+inline void dequant_block(const coeff_t in[8][8], coeff_t out[8][8], const QuantTable &t) {
     for (int y = 0; y < 8; y++) {
         for (int x = 0; x < 8; x++) {
             int idx = y*8 + x;
-            int q = Q_luma[idx];
+            int q = t.q[idx];
             int v = in[y][x];
             int dq = v * q;
             if (dq < -32768) dq = -32768;
@@ -138,6 +242,10 @@ inline void dequant_block(const coeff_t in[8][8], coeff_t out[8][8]) {
     }
 }
 
+inline void dequant_block(const coeff_t in[8][8], coeff_t out[8][8]) {
+    dequant_block(in, out, default_quant_table());
+}
+
 // Convert 8x8 block to zigzag 64-vector
 inline void zigzag_block(const coeff_t blk[8][8], std::vector<coeff_t> &out) {
     out.resize(64);
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Result buffer of the v12 cycle counters (hls/v12_dct_accel.cpp). Per
+// dataflow stage, in pipeline order:
+//   [0] cycle the stage finished, counted from the start of the kernel
+//   [1] active cycles  [2] cycles waiting on an empty input stream
+//   [3] cycles waiting on a full output stream
+// The finish cycle less the three counts is memory wait (load, store) or
+// pipeline fill.
+static const int KPERF_STAGES = 4;
+static const int KPERF_STAGE_WORDS = 4;
+static const int KPERF_WORDS = KPERF_STAGES * KPERF_STAGE_WORDS;
+
+static const char* const KPERF_STAGE_NAMES[KPERF_STAGES] = {
+    "load_blocks_df", "compute_dct_df", "quant_blocks_df", "store_blocks_df"
+};
+
+struct StagePerf {
+    uint32_t done_at;
+    uint32_t active;
+    uint32_t in_stall;
+    uint32_t out_stall;
+
+    // Cycles not accounted for by the stage's own counters
+    uint32_t other() const
+    {
+        uint64_t counted = uint64_t(active) + in_stall + out_stall;
+        return done_at > counted ? uint32_t(done_at - counted) : 0;
+    }
+};
+
+inline void unpack_kernel_perf(const uint32_t* words, StagePerf stages[KPERF_STAGES])
+{
+    for (int s = 0; s < KPERF_STAGES; s++) {
+        const uint32_t* w = words + s * KPERF_STAGE_WORDS;
+        stages[s].done_at = w[0];
+        stages[s].active = w[1];
+        stages[s].in_stall = w[2];
+        stages[s].out_stall = w[3];
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "jpeg_cpu.hpp"
+
+// Result buffer of the v9 statistics stage (hls/v9_dct_accel.cpp), counted
+// on the device while the coefficients stream out. Per channel, over the
+// quantized coefficients in zigzag order with blocks zero-padded past the
+// plane edge (the same view calculate_compression takes):
+//   [0] zero coefficients  [1] nonzero coefficients  [2] RLE pairs
+//   [3] blocks  [4 + k] blocks whose DC difference has huff_category k
+static const int KSTATS_CH_WORDS = 24;
+static const int KSTATS_WORDS = 3 * KSTATS_CH_WORDS;
+static const int KSTATS_DC_CATEGORIES = 17;
+
+struct KernelStats {
+    uint32_t zero;
+    uint32_t nonzero;
+    uint32_t rle_pairs;
+    uint32_t blocks;
+    uint32_t dc_hist[KSTATS_DC_CATEGORIES];
+};
+
+inline void unpack_kernel_stats(const uint32_t* words, KernelStats stats[3])
+{
+    for (int ch = 0; ch < 3; ch++) {
+        const uint32_t* w = words + ch * KSTATS_CH_WORDS;
+        stats[ch].zero = w[0];
+        stats[ch].nonzero = w[1];
+        stats[ch].rle_pairs = w[2];
+        stats[ch].blocks = w[3];
+        for (int k = 0; k < KSTATS_DC_CATEGORIES; k++) stats[ch].dc_hist[k] = w[4 + k];
+    }
+}
+
+// The host's side of the same counts, one block at a time
+struct BlockCounts {
+    long zero = 0;
+    long nonzero = 0;
+    size_t rle_pairs = 0;
+};
+
+// Block (bx, by) of a w x h raster coefficient plane, zero-padded past the
+// edge and quantized with qt unless the plane already is: leaves the block
+// in zigzag order in zz and adds its coefficients and RLE pairs to counts.
+// The DC difference needs the previous block; huff_category(zz[0] - prev).
+inline void count_block(const coeff_t* plane, int w, int h, int bx, int by,
+                        const QuantTable& qt, bool quantized, std::vector<coeff_t>& zz,
+                        std::vector<std::pair<coeff_t,int>>& rle, BlockCounts& counts)
+{
+    coeff_t blk[8][8], q_blk[8][8];
+    for (int y = 0; y < 8; y++)
+        for (int x = 0; x < 8; x++)
+            blk[y][x] = (bx + x < w && by + y < h) ? plane[size_t(by + y) * w + bx + x] : 0;
+    if (quantized)
+        std::copy(&blk[0][0], &blk[0][0] + 64, &q_blk[0][0]);
+    else
+        quant_block(blk, q_blk, qt);
+    zigzag_block(q_blk, zz);
+    for (auto v : zz) {
+        if (v == 0) counts.zero++;
+        else counts.nonzero++;
+    }
+    rle_encode(zz, rle);
+    counts.rle_pairs += rle.size();
+}
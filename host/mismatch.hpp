@@ -0,0 +1,131 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+#include "jpeg_cpu.hpp"
+#include "parallel.hpp"
+
+// Where and by how much device coefficients differ from the golden ones,
+// gathered in one pass over both planes: the mismatch count, a histogram
+// of each block's largest |error|, per-position counts and maxima over the
+// 8x8 block (heatmaps, in the layout the coefficient planes store blocks)
+// and the worst blocks.
+struct MismatchBlock {
+    int plane;
+    int bx, by;             // block coordinates
+    int max_err;
+    long sum_err;
+    int pos;                // position (row * 8 + col) of max_err
+};
+
+struct MismatchReport {
+    static const int HIST_BUCKETS = 12;
+    size_t coeffs = 0;
+    size_t blocks = 0;
+    long mismatches = 0;
+    size_t bad_blocks = 0;
+    int max_err = 0;
+    // Blocks by largest |error|: bucket 0 exact, 1 for 1, then powers of
+    // two (2, 3-4, 5-8, ...); the last bucket takes everything above
+    size_t hist[HIST_BUCKETS] = {};
+    long pos_count[64] = {};
+    int pos_max[64] = {};
+    long pos_sum[64] = {};
+    std::vector<MismatchBlock> worst;   // worst first
+
+    static int bucket(int err)
+    {
+        if (err <= 1) return err;
+        int b = 2;
+        while (b < HIST_BUCKETS - 1 && (1 << (b - 1)) < err) b++;
+        return b;
+    }
+    // Smallest error that lands in bucket b
+    static int bucket_lo(int b) { return b <= 1 ? b : (1 << (b - 2)) + 1; }
+
+    void merge(const MismatchReport& o, size_t keep)
+    {
+        coeffs += o.coeffs;
+        blocks += o.blocks;
+        mismatches += o.mismatches;
+        bad_blocks += o.bad_blocks;
+        max_err = std::max(max_err, o.max_err);
+        for (int i = 0; i < HIST_BUCKETS; i++) hist[i] += o.hist[i];
+        for (int i = 0; i < 64; i++) {
+            pos_count[i] += o.pos_count[i];
+            pos_max[i] = std::max(pos_max[i], o.pos_max[i]);
+            pos_sum[i] += o.pos_sum[i];
+        }
+        worst.insert(worst.end(), o.worst.begin(), o.worst.end());
+        trim(keep);
+    }
+
+    void trim(size_t keep)
+    {
+        auto worse = [](const MismatchBlock& a, const MismatchBlock& b) {
+            return a.max_err != b.max_err ? a.max_err > b.max_err : a.sum_err > b.sum_err;
+        };
+        size_t n = std::min(keep, worst.size());
+        std::partial_sort(worst.begin(), worst.begin() + n, worst.end(), worse);
+        worst.resize(n);
+    }
+};
+
+// Compare one w x h plane of device coefficients with the golden plane
+// (both raster, cpu_dct_image layout) and add it to rep. Block rows are
+// split over nthreads; interior blocks take a fixed 8x8 path whose
+// per-row |dev - gold| the compiler vectorizes.
+inline void analyze_mismatches(const coeff_t* dev, const coeff_t* gold, int w, int h,
+                               int plane, MismatchReport& rep, size_t keep_worst = 8,
+                               int nthreads = host_num_threads())
+{
+    const int bw = (w + 7) / 8, bh = (h + 7) / 8;
+    std::vector<MismatchReport> part(nthreads);
+    parallel_for(0, bh, nthreads, [&](int tid, int lo, int hi) {
+        MismatchReport& r = part[tid];
+        for (int by = lo; by < hi; by++) {
+            const int rows = std::min(8, h - 8 * by);
+            for (int bx = 0; bx < bw; bx++) {
+                const int cols = std::min(8, w - 8 * bx);
+                int err[64] = {};
+                for (int y = 0; y < rows; y++) {
+                    const coeff_t* d = dev + size_t(8 * by + y) * w + 8 * bx;
+                    const coeff_t* g = gold + size_t(8 * by + y) * w + 8 * bx;
+                    int* e = err + 8 * y;
+                    if (cols == 8) {
+                        for (int x = 0; x < 8; x++) e[x] = std::abs(int(d[x]) - int(g[x]));
+                    } else {
+                        for (int x = 0; x < cols; x++) e[x] = std::abs(int(d[x]) - int(g[x]));
+                    }
+                }
+                int bmax = 0, bpos = 0, bad = 0;
+                long bsum = 0;
+                for (int i = 0; i < 64; i++) {
+                    bad += err[i] != 0;
+                    bsum += err[i];
+                    if (err[i] > bmax) {
+                        bmax = err[i];
+                        bpos = i;
+                    }
+                }
+                r.coeffs += size_t(rows) * cols;
+                r.blocks++;
+                r.hist[MismatchReport::bucket(bmax)]++;
+                if (!bad) continue;
+                r.mismatches += bad;
+                r.bad_blocks++;
+                r.max_err = std::max(r.max_err, bmax);
+                for (int i = 0; i < 64; i++) {
+                    r.pos_count[i] += err[i] != 0;
+                    r.pos_max[i] = std::max(r.pos_max[i], err[i]);
+                    r.pos_sum[i] += err[i];
+                }
+                r.worst.push_back({plane, bx, by, bmax, bsum, bpos});
+                if (r.worst.size() >= 4 * keep_worst + 64) r.trim(keep_worst);
+            }
+        }
+    });
+    for (auto& r : part) rep.merge(r, keep_worst);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Number of worker threads used by the host-side parallel passes
+inline int host_num_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? (int)n : 1;
+}
+
+// Split [begin, end) into one contiguous chunk per thread and call
+// fn(tid, lo, hi) on each. Chunk tid always belongs to thread tid, so
+// callers can keep per-thread partial results indexed by tid and merge
+// them after the call returns.
+template <class F>
+void parallel_for(int begin, int end, int nthreads, F fn)
+{
+    int n = end - begin;
+    if (n <= 0) return;
+    nthreads = std::max(1, std::min(nthreads, n));
+
+    if (nthreads == 1) {
+        fn(0, begin, end);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(nthreads - 1);
+    for (int t = 1; t < nthreads; t++) {
+        int lo = begin + (int)((long long)n * t / nthreads);
+        int hi = begin + (int)((long long)n * (t + 1) / nthreads);
+        workers.emplace_back(fn, t, lo, hi);
+    }
+    fn(0, begin, begin + n / nthreads);
+    for (auto &w : workers) w.join();
+}
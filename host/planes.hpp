@@ -0,0 +1,116 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// Helpers for fitting image planes into the three equal-size planes every
+// dct_accel variant transforms per launch.
+
+inline int round_up8(int n) { return (n + 7) & ~7; }
+
+template <class T>
+inline void copy_rect(const T *src, int src_stride, T *dst, int dst_stride,
+                      int cols, int rows)
+{
+    for (int y = 0; y < rows; y++)
+        std::copy(src + size_t(y) * src_stride, src + size_t(y) * src_stride + cols,
+                  dst + size_t(y) * dst_stride);
+}
+
+// copy_rect, then repeat the last column out to pad_cols and the last row
+// down to pad_rows, so a packed sub-plane ends in the same edge-replicated
+// partial blocks cpu_dct_image builds for the unpacked plane
+template <class T>
+inline void copy_rect_replicate(const T *src, int src_stride, T *dst, int dst_stride,
+                                int cols, int rows, int pad_cols, int pad_rows)
+{
+    for (int y = 0; y < rows; y++) {
+        T *d = dst + size_t(y) * dst_stride;
+        std::copy(src + size_t(y) * src_stride, src + size_t(y) * src_stride + cols, d);
+        std::fill(d + cols, d + pad_cols, d[cols - 1]);
+    }
+    const T *last = dst + size_t(rows - 1) * dst_stride;
+    for (int y = rows; y < pad_rows; y++)
+        std::copy(last, last + pad_cols, dst + size_t(y) * dst_stride);
+}
+
+// A single (grayscale) plane cut into three horizontal strips, one per
+// kernel channel, so one launch covers it with a third of the rows. The
+// strip height is a multiple of 8, so no block straddles two strips; the
+// last strip repeats the bottom row out to its block boundary.
+struct StripPacking {
+    int width;
+    int height;     // rows per strip
+};
+
+inline StripPacking strip_packing(int w, int h)
+{
+    StripPacking p;
+    p.width  = w;
+    p.height = std::max(8, round_up8((h + 2) / 3));
+    return p;
+}
+
+template <class T>
+inline void strip_pack(const std::vector<T> &src, int w, int h,
+                       const StripPacking &p, std::vector<T> out[3])
+{
+    for (int c = 0; c < 3; c++) {
+        out[c].assign(size_t(p.width) * p.height, T(0));
+        int y0 = c * p.height;
+        int rows = std::min(p.height, h - y0);
+        if (rows > 0)
+            copy_rect_replicate(src.data() + size_t(y0) * w, w, out[c].data(), p.width,
+                                w, rows, w, round_up8(rows));
+    }
+}
+
+template <class T>
+inline void strip_unpack(const std::vector<T> in[3], int w, int h,
+                         const StripPacking &p, std::vector<T> &dst)
+{
+    dst.resize(size_t(w) * h);
+    for (int c = 0; c < 3; c++) {
+        int y0 = c * p.height;
+        int rows = std::min(p.height, h - y0);
+        if (rows > 0)
+            copy_rect(in[c].data(), p.width, dst.data() + size_t(y0) * w, w, w, rows);
+    }
+}
+
+// Pitched layout for kernels without bounds checks (v6): the plane is
+// padded to whole blocks and each row starts on a 64-element boundary, so
+// rows are whole burst-aligned words and the device loops never test x/y
+// against the image edge.
+struct PitchedLayout {
+    int width;      // round_up8(w)
+    int height;     // round_up8(h)
+    int pitch;      // elements per row, multiple of 64
+    size_t size() const { return size_t(pitch) * height; }
+};
+
+inline PitchedLayout pitched_layout(int w, int h)
+{
+    PitchedLayout p;
+    p.width  = round_up8(w);
+    p.height = round_up8(h);
+    p.pitch  = (w + 63) & ~63;
+    return p;
+}
+
+// Edge-replicate out to the block boundary; columns past width stay 0
+template <class T>
+inline void pitch_pad(const std::vector<T> &src, int w, int h,
+                      const PitchedLayout &p, std::vector<T> &out)
+{
+    out.assign(p.size(), T(0));
+    copy_rect_replicate(src.data(), w, out.data(), p.pitch, w, h, p.width, p.height);
+}
+
+template <class T>
+inline void pitch_crop(const std::vector<T> &in, int w, int h,
+                       const PitchedLayout &p, std::vector<T> &dst)
+{
+    dst.resize(size_t(w) * h);
+    copy_rect(in.data(), p.pitch, dst.data(), w, w, h);
+}
@@ -0,0 +1,366 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "jpeg_cpu.hpp"
+
+// Interleaved 4-state rANS coder over the zigzag/RLE pair stream.
+// Not JPEG compatible; meant for internal storage where encode/decode
+// speed matters more than format compatibility.
+//
+// Each RLE pair (value, run) is split into
+//   cats: bit length of |value| (0..16, rANS coded)
+//   runs: run - 1              (0..63, rANS coded in two contexts:
+//                               zero values and nonzero values)
+//   vals: value bits for nonzero values (stored raw, cat bits each)
+//
+// Container layout (little endian):
+//   "RANS" | version u8 | channels u8 | width u32 | height u32
+//   | npairs u32 | cats stream | zero-value runs stream
+//   | nonzero-value runs stream | raw bytes u32 + data
+// stream: nsym u16, nsym x (sym u8, freq u16), nwords u32,
+//         4 x state u32, nwords x u16
+
+static const int      RANS_SCALE_BITS = 12;
+static const uint32_t RANS_SCALE      = 1u << RANS_SCALE_BITS;
+static const uint32_t RANS_L          = 1u << 15;  // state kept in [L, 2^31)
+static const int      RANS_LANES      = 4;
+
+struct RansSymbols {
+    std::vector<uint8_t> runs;
+    std::vector<uint8_t> cats;
+    std::vector<coeff_t> vals;
+};
+
+inline void rans_clear(RansSymbols &s) {
+    s.runs.clear();
+    s.cats.clear();
+    s.vals.clear();
+}
+
+// Append one block's RLE pairs (as produced by rle_encode)
+inline void rans_append_block(const std::vector<std::pair<coeff_t,int>> &rle,
+                              RansSymbols &s)
+{
+    for (auto &p : rle) {
+        int v = p.first;
+        int a = v < 0 ? -v : v;
+        int c = 0;
+        while (a) { c++; a >>= 1; }
+        s.runs.push_back((uint8_t)(p.second - 1));
+        s.cats.push_back((uint8_t)c);
+        if (c) s.vals.push_back(p.first);
+    }
+}
+
+// Expand decoded symbols back into consecutive 64-coefficient zigzag blocks
+inline void rans_rebuild_blocks(const RansSymbols &s, std::vector<coeff_t> &zz_out)
+{
+    size_t total = 0;
+    for (uint8_t r : s.runs) total += r + 1;
+    zz_out.resize(total);
+
+    size_t pos = 0, vi = 0;
+    for (size_t i = 0; i < s.runs.size(); i++) {
+        coeff_t v = s.cats[i] ? s.vals[vi++] : 0;
+        int run = s.runs[i] + 1;
+        for (int k = 0; k < run; k++) zz_out[pos + k] = v;
+        pos += run;
+    }
+}
+
+// Per-symbol encoder entry with a precomputed reciprocal so the
+// encoder needs no division (same scheme as ryg_rans)
+struct RansEncSym {
+    uint32_t x_max;
+    uint32_t rcp_freq;
+    uint32_t bias;
+    uint16_t cmpl_freq;
+    uint16_t rcp_shift;
+};
+
+struct RansDecSym {
+    uint16_t start;
+    uint16_t freq;
+    uint8_t  sym;
+};
+
+struct RansModel {
+    uint16_t freq[256];
+    uint16_t start[256];
+    RansEncSym enc[256];
+    RansDecSym dec[RANS_SCALE];
+};
+
+// Scale a histogram so frequencies sum to RANS_SCALE and every
+// present symbol keeps a nonzero frequency
+inline void rans_normalize(const uint32_t hist[256], uint16_t freq[256])
+{
+    uint64_t total = 0;
+    for (int i = 0; i < 256; i++) total += hist[i];
+    std::memset(freq, 0, 256 * sizeof(uint16_t));
+    if (total == 0) {
+        freq[0] = RANS_SCALE;
+        return;
+    }
+
+    int sum = 0;
+    for (int i = 0; i < 256; i++) {
+        if (!hist[i]) continue;
+        uint32_t f = (uint32_t)((uint64_t)hist[i] * RANS_SCALE / total);
+        freq[i] = (uint16_t)(f ? f : 1);
+        sum += freq[i];
+    }
+
+    // Give the rounding slack to (or take it from) the most frequent symbols
+    while (sum != (int)RANS_SCALE) {
+        int best = -1;
+        for (int i = 0; i < 256; i++)
+            if (freq[i] > 1 && (best < 0 || freq[i] > freq[best])) best = i;
+        if (best < 0) {
+            for (int i = 0; i < 256; i++)
+                if (freq[i] && (best < 0 || freq[i] > freq[best])) best = i;
+        }
+        if (sum < (int)RANS_SCALE) { freq[best]++; sum++; }
+        else                       { freq[best]--; sum--; }
+    }
+}
+
+inline void rans_build_model(RansModel &m)
+{
+    uint32_t cum = 0;
+    for (int s = 0; s < 256; s++) {
+        m.start[s] = (uint16_t)cum;
+        uint32_t f = m.freq[s];
+
+        RansEncSym &e = m.enc[s];
+        e.x_max = ((RANS_L >> RANS_SCALE_BITS) << 16) * f;
+        e.cmpl_freq = (uint16_t)(RANS_SCALE - f);
+        if (f < 2) {
+            e.rcp_freq = ~0u;
+            e.rcp_shift = 0;
+            e.bias = cum + RANS_SCALE - 1;
+        } else {
+            uint32_t shift = 0;
+            while (f > (1u << shift)) shift++;
+            e.rcp_freq = (uint32_t)(((1ull << (shift + 31)) + f - 1) / f);
+            e.rcp_shift = (uint16_t)(shift - 1);
+            e.bias = cum;
+        }
+
+        for (uint32_t k = 0; k < f; k++) {
+            m.dec[cum + k].start = (uint16_t)cum;
+            m.dec[cum + k].freq  = (uint16_t)f;
+            m.dec[cum + k].sym   = (uint8_t)s;
+        }
+        cum += f;
+    }
+}
+
+inline void rans_put_u16(std::vector<uint8_t> &out, uint32_t v) {
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+inline void rans_put_u32(std::vector<uint8_t> &out, uint32_t v) {
+    rans_put_u16(out, v & 0xFFFF);
+    rans_put_u16(out, v >> 16);
+}
+
+inline uint32_t rans_get_u16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+inline uint32_t rans_get_u32(const uint8_t *p) { return rans_get_u16(p) | (rans_get_u16(p + 2) << 16); }
+
+// Encode one symbol stream (model table + interleaved payload)
+inline void rans_encode_stream(const std::vector<uint8_t> &syms, std::vector<uint8_t> &out)
+{
+    uint32_t hist[256] = {0};
+    for (uint8_t s : syms) hist[s]++;
+
+    RansModel m;
+    rans_normalize(hist, m.freq);
+    rans_build_model(m);
+
+    int nsym = 0;
+    for (int s = 0; s < 256; s++) nsym += m.freq[s] != 0;
+    rans_put_u16(out, nsym);
+    for (int s = 0; s < 256; s++) {
+        if (!m.freq[s]) continue;
+        out.push_back((uint8_t)s);
+        rans_put_u16(out, m.freq[s]);
+    }
+
+    // Symbols are encoded back to front; lane i owns symbols n with n % 4 == i
+    size_t n = syms.size();
+    std::vector<uint16_t> words(n + RANS_LANES);
+    uint16_t *wp = words.data() + words.size();
+    uint32_t x[RANS_LANES];
+    for (int l = 0; l < RANS_LANES; l++) x[l] = RANS_L;
+
+    for (size_t i = n; i-- > 0; ) {
+        const RansEncSym &e = m.enc[syms[i]];
+        uint32_t &xs = x[i & (RANS_LANES - 1)];
+        if (xs >= e.x_max) {
+            *--wp = (uint16_t)xs;
+            xs >>= 16;
+        }
+        uint32_t q = (uint32_t)(((uint64_t)xs * e.rcp_freq) >> 32) >> e.rcp_shift;
+        xs = xs + e.bias + q * e.cmpl_freq;
+    }
+
+    size_t nwords = words.data() + words.size() - wp;
+    rans_put_u32(out, (uint32_t)nwords);
+    for (int l = 0; l < RANS_LANES; l++) rans_put_u32(out, x[l]);
+    size_t off = out.size();
+    out.resize(off + nwords * 2);
+    for (size_t k = 0; k < nwords; k++) {
+        out[off + 2 * k]     = (uint8_t)wp[k];
+        out[off + 2 * k + 1] = (uint8_t)(wp[k] >> 8);
+    }
+}
+
+// Decode n symbols; returns bytes consumed, or 0 on a malformed stream
+inline size_t rans_decode_stream(const uint8_t *in, size_t avail, size_t n,
+                                 std::vector<uint8_t> &syms)
+{
+    const uint8_t *p = in, *end = in + avail;
+    if (end - p < 2) return 0;
+    int nsym = rans_get_u16(p); p += 2;
+    if (end - p < nsym * 3) return 0;
+
+    RansModel m;
+    std::memset(m.freq, 0, sizeof(m.freq));
+    uint32_t total = 0;
+    for (int k = 0; k < nsym; k++) {
+        m.freq[p[0]] = (uint16_t)rans_get_u16(p + 1);
+        total += m.freq[p[0]];
+        p += 3;
+    }
+    if (total != RANS_SCALE) return 0;
+    rans_build_model(m);
+
+    if (end - p < 4 + 4 * RANS_LANES) return 0;
+    size_t nwords = rans_get_u32(p); p += 4;
+    uint32_t x[RANS_LANES];
+    for (int l = 0; l < RANS_LANES; l++) { x[l] = rans_get_u32(p); p += 4; }
+    if ((size_t)(end - p) < nwords * 2) return 0;
+    const uint8_t *wp = p, *wend = p + nwords * 2;
+
+    syms.resize(n);
+    const uint32_t mask = RANS_SCALE - 1;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t &xs = x[i & (RANS_LANES - 1)];
+        const RansDecSym &d = m.dec[xs & mask];
+        syms[i] = d.sym;
+        xs = d.freq * (xs >> RANS_SCALE_BITS) + (xs & mask) - d.start;
+        if (xs < RANS_L) {
+            if (wp >= wend) return 0;
+            xs = (xs << 16) | rans_get_u16(wp);
+            wp += 2;
+        }
+    }
+    return wend - in;
+}
+
+inline void rans_encode(const RansSymbols &s, int width, int height, int channels,
+                        std::vector<uint8_t> &out)
+{
+    out.clear();
+    for (char c : {'R', 'A', 'N', 'S'}) out.push_back((uint8_t)c);
+    out.push_back(1);
+    out.push_back((uint8_t)channels);
+    rans_put_u32(out, width);
+    rans_put_u32(out, height);
+    rans_put_u32(out, (uint32_t)s.runs.size());
+
+    // Runs after a nonzero value are almost always 1, so they get their own model
+    std::vector<uint8_t> runs_z, runs_nz;
+    runs_z.reserve(s.runs.size());
+    runs_nz.reserve(s.runs.size());
+    for (size_t i = 0; i < s.runs.size(); i++)
+        (s.cats[i] ? runs_nz : runs_z).push_back(s.runs[i]);
+
+    rans_encode_stream(s.cats, out);
+    rans_encode_stream(runs_z, out);
+    rans_encode_stream(runs_nz, out);
+
+    // Raw value bits, LSB first
+    size_t len_off = out.size();
+    rans_put_u32(out, 0);
+    size_t data_off = out.size();
+    uint64_t acc = 0;
+    int nbits = 0;
+    size_t vi = 0;
+    for (size_t i = 0; i < s.cats.size(); i++) {
+        int c = s.cats[i];
+        if (!c) continue;
+        int v = s.vals[vi++];
+        uint32_t bits = (uint32_t)(v < 0 ? v - 1 : v) & ((1u << c) - 1);
+        acc |= (uint64_t)bits << nbits;
+        nbits += c;
+        while (nbits >= 8) {
+            out.push_back((uint8_t)acc);
+            acc >>= 8;
+            nbits -= 8;
+        }
+    }
+    if (nbits) out.push_back((uint8_t)acc);
+    uint32_t raw_len = (uint32_t)(out.size() - data_off);
+    for (int k = 0; k < 4; k++) out[len_off + k] = (uint8_t)(raw_len >> (8 * k));
+}
+
+inline bool rans_decode(const std::vector<uint8_t> &in, RansSymbols &s,
+                        int &width, int &height, int &channels)
+{
+    const uint8_t *p = in.data(), *end = in.data() + in.size();
+    if (in.size() < 18 || std::memcmp(p, "RANS", 4) != 0 || p[4] != 1) return false;
+    channels = p[5];
+    width    = (int)rans_get_u32(p + 6);
+    height   = (int)rans_get_u32(p + 10);
+    size_t npairs = rans_get_u32(p + 14);
+    p += 18;
+
+    size_t used = rans_decode_stream(p, end - p, npairs, s.cats);
+    if (!used) return false;
+    p += used;
+
+    size_t nz = 0;
+    for (uint8_t c : s.cats) nz += c != 0;
+    std::vector<uint8_t> runs_z, runs_nz;
+    used = rans_decode_stream(p, end - p, npairs - nz, runs_z);
+    if (!used) return false;
+    p += used;
+    used = rans_decode_stream(p, end - p, nz, runs_nz);
+    if (!used) return false;
+    p += used;
+
+    s.runs.resize(npairs);
+    size_t iz = 0, inz = 0;
+    for (size_t i = 0; i < npairs; i++)
+        s.runs[i] = s.cats[i] ? runs_nz[inz++] : runs_z[iz++];
+
+    if (end - p < 4) return false;
+    size_t raw_len = rans_get_u32(p); p += 4;
+    if ((size_t)(end - p) < raw_len) return false;
+    const uint8_t *rp = p, *rend = p + raw_len;
+
+    s.vals.clear();
+    uint64_t acc = 0;
+    int nbits = 0;
+    for (size_t i = 0; i < npairs; i++) {
+        int c = s.cats[i];
+        if (!c) continue;
+        while (nbits < c) {
+            if (rp >= rend) return false;
+            acc |= (uint64_t)(*rp++) << nbits;
+            nbits += 8;
+        }
+        int v = (int)(acc & ((1u << c) - 1));
+        acc >>= c;
+        nbits -= c;
+        if (v < (1 << (c - 1))) v -= (1 << c) - 1;
+        s.vals.push_back((coeff_t)v);
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#include "jpeg_cpu.hpp"
+#include "parallel.hpp"
+
+// Block-major (tiled) plane layout: the 64 elements of each 8x8 block are
+// contiguous, row-major inside the block, and blocks follow in raster
+// order. Block (bx, by) of a w x h plane starts at
+//   (by * tiled_blocks_x(w) + bx) * 64,
+// so a block fetch is one sequential 64-element run for the CPU engines
+// and one burst for the tiled kernel (v7). Partial edge blocks are filled
+// by edge replication, as cpu_dct_image and the kernel loaders do.
+
+inline int tiled_blocks_x(int w) { return (w + 7) / 8; }
+inline int tiled_blocks_y(int h) { return (h + 7) / 8; }
+inline size_t tiled_size(int w, int h) { return size_t(tiled_blocks_x(w)) * tiled_blocks_y(h) * 64; }
+
+// Raster -> tiles. Each image row is cut into 8-element runs that land
+// in consecutive tiles; full runs are fixed-length copies the compiler
+// turns into single vector moves. Block rows are split across nthreads
+// (1 when the caller already runs one image per thread).
+template <class T>
+inline void raster_to_tiles(const T *src, int w, int h, T *dst,
+                            int nthreads = host_num_threads())
+{
+    int bw = tiled_blocks_x(w);
+    int full = w / 8;
+    parallel_for(0, tiled_blocks_y(h), nthreads, [&](int, int lo, int hi) {
+        for (int by = lo; by < hi; by++) {
+            T *tile_row = dst + size_t(by) * bw * 64;
+            for (int y = 0; y < 8; y++) {
+                const T *s = src + size_t(std::min(by * 8 + y, h - 1)) * w;
+                T *d = tile_row + y * 8;
+                for (int bx = 0; bx < full; bx++)
+                    std::copy_n(s + bx * 8, 8, d + size_t(bx) * 64);
+                if (full < bw) {
+                    T *e = d + size_t(full) * 64;
+                    for (int x = 0; x < 8; x++)
+                        e[x] = s[std::min(full * 8 + x, w - 1)];
+                }
+            }
+        }
+    });
+}
+
+// Tiles -> raster, dropping the padding of partial edge blocks
+template <class T>
+inline void tiles_to_raster(const T *src, int w, int h, T *dst,
+                            int nthreads = host_num_threads())
+{
+    int bw = tiled_blocks_x(w);
+    int full = w / 8;
+    int tail = w - full * 8;
+    parallel_for(0, tiled_blocks_y(h), nthreads, [&](int, int lo, int hi) {
+        for (int by = lo; by < hi; by++) {
+            const T *tile_row = src + size_t(by) * bw * 64;
+            int rows = std::min(8, h - by * 8);
+            for (int y = 0; y < rows; y++) {
+                const T *s = tile_row + y * 8;
+                T *d = dst + size_t(by * 8 + y) * w;
+                for (int bx = 0; bx < full; bx++)
+                    std::copy_n(s + size_t(bx) * 64, 8, d + bx * 8);
+                if (tail)
+                    std::copy_n(s + size_t(full) * 64, tail, d + full * 8);
+            }
+        }
+    });
+}
+
+template <class T>
+inline void raster_to_tiles(const std::vector<T> &src, int w, int h, std::vector<T> &dst)
+{
+    dst.resize(tiled_size(w, h));
+    raster_to_tiles(src.data(), w, h, dst.data());
+}
+
+template <class T>
+inline void tiles_to_raster(const std::vector<T> &src, int w, int h, std::vector<T> &dst)
+{
+    dst.resize(size_t(w) * h);
+    tiles_to_raster(src.data(), w, h, dst.data());
+}
+
+// CPU DCT over a tiled plane: every block is read and written in place
+// as one contiguous 8x8 array, with no gather or edge tests
+inline void cpu_dct_tiles(const pixel_t *tiles, size_t nblocks, coeff_t *out)
+{
+    for (size_t b = 0; b < nblocks; b++)
+        dct_block_cpu(reinterpret_cast<const pixel_t (*)[8]>(tiles + b * 64),
+                      reinterpret_cast<coeff_t (*)[8]>(out + b * 64));
+}
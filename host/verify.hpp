@@ -0,0 +1,152 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include "jpeg_cpu.hpp"
+#include "parallel.hpp"
+
+// How much of the device output to check against the CPU golden model.
+// FULL recomputes every plane; SAMPLED recomputes a seeded random subset
+// of blocks (a count, or a percentage of all blocks over all planes);
+// OFF trusts the device.
+struct VerifyPolicy {
+    enum Mode { FULL, SAMPLED, OFF };
+    Mode mode = FULL;
+    size_t blocks = 0;          // SAMPLED: this many blocks ...
+    double percent = 0;         // ... or, if blocks == 0, this share of them
+    uint32_t seed = 1;
+};
+
+// Parse "full", "off", "sample:K" or "sample:P%"; false on anything else
+inline bool parse_verify_policy(const std::string& s, VerifyPolicy& p)
+{
+    if (s == "full") {
+        p.mode = VerifyPolicy::FULL;
+    } else if (s == "off") {
+        p.mode = VerifyPolicy::OFF;
+    } else if (s.compare(0, 7, "sample:") == 0 && s.size() > 7) {
+        std::string n = s.substr(7);
+        p.mode = VerifyPolicy::SAMPLED;
+        if (n.back() == '%') {
+            p.blocks = 0;
+            p.percent = atof(n.c_str());
+            return p.percent > 0 && p.percent <= 100;
+        }
+        p.blocks = strtoull(n.c_str(), nullptr, 10);
+        return p.blocks > 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// One plane to check: source pixels, device coefficients (raster layout,
+// as cpu_dct_image writes them) and the quant table if the device
+// quantized, else null
+struct VerifyPlane {
+    const pixel_t* pixels;
+    const coeff_t* coeffs;
+    int width;
+    int height;
+    const QuantTable* qt;
+};
+
+struct VerifyResult {
+    size_t blocks_total = 0;
+    size_t blocks_checked = 0;
+    size_t coeffs_checked = 0;
+    size_t bad_blocks = 0;
+    long bad_coeffs = 0;
+};
+
+// One-sided 95% upper confidence bound on the fraction of wrong blocks in
+// the image after finding `bad` of `n` sampled ones: exact for bad == 0
+// (1 - 0.05^(1/n), about 3/n), the Wilson score bound otherwise. Checking
+// every block leaves no uncertainty.
+inline double verify_upper_bound(size_t bad, size_t n, size_t total)
+{
+    if (n == 0) return 1.0;
+    if (n >= total) return double(bad) / double(total);
+    if (bad == 0) return 1.0 - std::pow(0.05, 1.0 / double(n));
+    const double z = 1.645;
+    double p = double(bad) / n, z2n = z * z / n;
+    return std::min(1.0, (p + z2n / 2 + z * std::sqrt(p * (1 - p) / n + z2n / (4.0 * n))) / (1 + z2n));
+}
+
+// Recompute k distinct blocks, drawn uniformly over all blocks of all
+// planes with a seeded RNG, and compare them with the device output.
+// Each sample is one edge-replicated gather and one dct_block_cpu (the
+// kernel of the tiled CPU engine), split over nthreads.
+inline VerifyResult verify_sampled(const VerifyPlane* planes, int nplanes, size_t k,
+                                   uint32_t seed, int nthreads = host_num_threads())
+{
+    VerifyResult res;
+    std::vector<size_t> first(nplanes + 1, 0);
+    for (int c = 0; c < nplanes; c++)
+        first[c + 1] = first[c] + size_t((planes[c].width + 7) / 8) * ((planes[c].height + 7) / 8);
+    res.blocks_total = first[nplanes];
+    k = std::min(k, res.blocks_total);
+
+    // Floyd's algorithm: k distinct indices in O(k), then sorted so the
+    // gathers walk each plane top to bottom
+    std::vector<size_t> pick;
+    if (k == res.blocks_total) {
+        for (size_t i = 0; i < k; i++) pick.push_back(i);
+    } else {
+        std::mt19937_64 rng(seed);
+        std::unordered_set<size_t> chosen;
+        for (size_t j = res.blocks_total - k; j < res.blocks_total; j++) {
+            size_t t = std::uniform_int_distribution<size_t>(0, j)(rng);
+            if (!chosen.insert(t).second) chosen.insert(j);
+        }
+        pick.assign(chosen.begin(), chosen.end());
+        std::sort(pick.begin(), pick.end());
+    }
+
+    std::vector<VerifyResult> part(nthreads);
+    parallel_for(0, (int)pick.size(), nthreads, [&](int tid, int lo, int hi) {
+        VerifyResult& r = part[tid];
+        pixel_t in[8][8];
+        coeff_t out[8][8], q[8][8];
+        for (int i = lo; i < hi; i++) {
+            int c = int(std::upper_bound(first.begin(), first.end(), pick[i]) - first.begin()) - 1;
+            const VerifyPlane& p = planes[c];
+            size_t b = pick[i] - first[c];
+            int bw = (p.width + 7) / 8;
+            int bx = 8 * int(b % bw), by = 8 * int(b / bw);
+            for (int y = 0; y < 8; y++) {
+                const pixel_t* row = p.pixels + size_t(std::min(by + y, p.height - 1)) * p.width;
+                for (int x = 0; x < 8; x++) in[y][x] = row[std::min(bx + x, p.width - 1)];
+            }
+            dct_block_cpu(in, out);
+            if (p.qt) {
+                quant_block(out, q, *p.qt);
+                std::copy(&q[0][0], &q[0][0] + 64, &out[0][0]);
+            }
+            long bad = 0;
+            for (int y = 0; y < 8 && by + y < p.height; y++) {
+                const coeff_t* dev = p.coeffs + size_t(by + y) * p.width;
+                for (int x = 0; x < 8 && bx + x < p.width; x++) {
+                    bad += dev[bx + x] != out[y][x];
+                    r.coeffs_checked++;
+                }
+            }
+            r.blocks_checked++;
+            r.bad_coeffs += bad;
+            r.bad_blocks += bad != 0;
+        }
+    });
+    for (auto& r : part) {
+        res.blocks_checked += r.blocks_checked;
+        res.coeffs_checked += r.coeffs_checked;
+        res.bad_blocks += r.bad_blocks;
+        res.bad_coeffs += r.bad_coeffs;
+    }
+    return res;
+}